@@ -33,7 +33,6 @@
 work_dir=$(pwd) # you may have to change the path here
 mkdir -p "${work_dir}/output"
 output_dir="${work_dir}/output"
-rm -rf tmp/
 
 input_dir="../input_data"
 timespan="19810101_20101231"
@@ -57,20 +56,6 @@ declare -a quant_methods=("quantile_mapping" "quantile_delta_mapping")
 # enable array index at 0 for zsh
 { setopt KSH_ARRAYS || : ; } 2> /dev/null
 
-tmp_path=${work_dir}/tmp/$(uuidgen | tr '[:upper:]' '[:lower:]' | head -c 12)
-tmp_ref="${tmp_path}/ref"
-tmp_contr="${tmp_path}/contr"
-tmp_scen="${tmp_path}/scen"
-tmp_results="${tmp_path}/results"
-
-mkdir -p $tmp_ref
-mkdir -p $tmp_contr
-mkdir -p $tmp_scen
-mkdir -p $tmp_results
-
-declare -a datasets=("${observations}" "${control}" "${scenario}")
-declare -a ds_paths=("${tmp_ref}" "${tmp_contr}" "${tmp_scen}")
-
 # * -------------------------------------------------------------------
 # *            ===== Distribution-based Adjustment =====
 # * -------------------------------------------------------------------
@@ -96,7 +81,7 @@ done
 
 # ? Additive linear scaling based on 31 day long-term mean interval instead of
 # long-term monthly means to avoid high deviations between month transitions
-# this only works if every dataset has 365 days per year (no January 29th)
+# the day of the year is decoded from the calendar of the time variable
 # this is available for all scaling methods
 
 $exec_file                             \
@@ -114,41 +99,19 @@ $exec_file                             \
 # *   ===== Scaling Adjustment based on long-term monthly means =====
 # * -------------------------------------------------------------------
 
-# ? OR: Adjust using the regular formulas using long-term monthly means by using the --no-group flag
-echo "Separating months ..."
-# ? Separate months
-for (( month=1; month<13; month++ ));do
-    declare -i index=0
-    for dataset in "${datasets[@]}"; do
-        cdo -f nc -s \
-            -selvar,$variable \
-            -selmon,$month $dataset \
-            "${ds_paths[index]}/${month}.nc" &
-        ((++index))
-    done
-    wait
-done
-
-echo "Staring adjusting data ..."
-# ? this should not be done in parallel because this could lead to excessive memory usage
+# ? OR: Adjust using the regular formulas using long-term monthly means by
+# grouping the time steps by month, every month is adjusted separately
 for method in "${month_methods[@]}"; do
-    # ? Apply scaling-based bias adjustment per month
-    for (( month=1; month<13; month++ )); do
-        $exec_file                                          \
-            --ref "${tmp_ref}/${month}.nc"                  \
-            --contr "${tmp_contr}/${month}.nc"              \
-            --scen "${tmp_scen}/${month}.nc"                \
-            -v $variable                                    \
-            -m $method                                      \
-            -o "${tmp_results}/${month}_${method}.nc"       \
-            -p 4                                            \
-            --no-group
-    done
-
-    # ? Merge corrected datasets
-    cdo -f nc \
-        -mergetime $tmp_path/results/*${method}.nc \
-        "${output_dir}/${variable}_${method}_kind-${kind}_scalingtype-monthly_${quant}result_${timespan}.nc"
+    $exec_file                                  \
+        --ref $observations                     \
+        --contr $control                        \
+        --scen $scenario                        \
+        -v $variable                            \
+        -m $method                              \
+        -k $kind                                \
+        --group month                           \
+        -p 4                                    \
+        -o "${output_dir}/${variable}_${method}_kind-${kind}_scalingtype-monthly_result_${timespan}.nc"
 done
 
 
@@ -168,11 +131,6 @@ $exec_file                                              \
     --1dim                                              \
     -o "${output_dir}/${variable}_1d_quantile_mapping_kind-${kind}_quants-${n_quantiles}_result_${timespan}.nc"
 
-# * -------------------------------------------------------------------
-# *                    ===== clean-up =====
-# * -------------------------------------------------------------------
-
-rm -rf tmp/
 echo "Finished adjusting data sets!"
 exit 0
 
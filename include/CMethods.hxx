@@ -27,36 +27,319 @@
 #ifndef __CMETHODS__
 #define __CMETHODS__
 
+#include <cstddef>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "Precision.hxx"
+#include "QuantileSketch.hxx"
+
+/**
+ * Adjustment kind, resolved once from the command-line arguments so that the
+ * adjustment procedures do not have to compare strings for every grid cell
+ */
+enum class AdjustmentKind {
+    Additive,       // "add", "additive" or "+"
+    Multiplicative  // "mult", "multiplicative" or "*"
+};
+
+/**
+ * Adjustment methods implemented in the class `CMethods`
+ */
+enum class AdjustmentMethod {
+    LinearScaling,
+    VarianceScaling,
+    DeltaMethod,
+    QuantileMapping,
+    QuantileDeltaMapping
+};
+
+/**
+ * How the distribution-based methods estimate the CDFs
+ */
+enum class CDFMethod {
+    Histogram,  // counts per quantile bin (`n_quantiles`)
+    Exact,      // empirical CDF based on the sorted samples
+    Sketch      // like `Histogram`, but the counts are estimated by quantile sketches (`sketch_error`)
+};
+
+/**
+ * Grouping of the time steps, where every group is adjusted on its own
+ */
+enum class TimeGrouping {
+    None,        // whole time series at once
+    Month,       // long-term months
+    Season,      // long-term seasons (DJF, MAM, JJA, SON)
+    DayOfYear31  // long-term 31-day intervals around every day of the year (scaling-based methods)
+};
+
+/**
+ * Type that stores the values of the slabs (see `BasicSlab`)
+ */
+enum class StorageType {
+    Float16,   // IEEE 754 half precision, halves the memory footprint and bandwidth
+    BFloat16,  // upper 16 bits of a float, range of a float with less precision
+    Float      // default
+};
+
+/**
+ * Outcome of the adjustment of a grid cell. The adjustment procedures report
+ * it instead of throwing exceptions, so that cells without data (e.g. over
+ * the ocean) neither interrupt nor slow down the threads of a data set.
+ */
+enum class CellStatus {
+    Ok,          // adjusted, missing values stay missing
+    AllMissing,  // the parameters can't be derived, because the input only consists of missing values
+    Constant,    // the CDFs can't be determined, because the input is constant (QM and QDM)
+    Fallback     // some days of the year, groups or values could not be adjusted
+};
+
+/**
+ * Sorted values of a moving window over a time series, e.g. of the long-term
+ * 31-day interval around a day of the year, where the window consists of
+ * one range of time steps per year. Moving the window only removes and
+ * inserts the values of the time steps that leave resp. enter the ranges,
+ * so that sliding the window by one day costs one merge instead of a sort.
+ */
+struct SortedWindow {
+    void clear();
+    void move(const std::vector<float>& v_in, const std::vector<std::pair<size_t, size_t>>& v_new_ranges);
+
+    std::vector<double> v_sorted;  // values of the window that are not nan
+
+   private:
+    std::vector<std::pair<size_t, size_t>> v_ranges;  // [start, end) of the current window per year
+    std::vector<double> v_removed;
+    std::vector<double> v_inserted;
+    std::vector<double> v_merged;
+};
+
+/**
+ * Buffers of the QM and QDM based on long-term 31-day moving windows for
+ * one range of days of the year, i.e. for one thread
+ */
+struct Interval31Buffers {
+    SortedWindow reference_window;
+    SortedWindow control_window;
+    SortedWindow scenario_window;
+    std::vector<std::pair<size_t, size_t>> v_ranges;
+    std::vector<std::pair<float, unsigned>> v_pairs;
+    // days of the year with scenario values resp. without CDFs
+    unsigned n_days = 0;
+    unsigned n_skipped = 0;
+};
+
+/**
+ * Partition of the time steps of a time series into groups (e.g. months),
+ * where the time steps of group `g` are
+ * `v_time_steps[v_offsets[g]]...v_time_steps[v_offsets[g + 1] - 1]`
+ */
+struct TimeGroups {
+    TimeGroups(){};
+    TimeGroups(const std::vector<unsigned>& v_groups, unsigned n_groups);
+
+    bool empty() const { return v_offsets.empty(); };
+    unsigned get_n_groups() const { return v_offsets.empty() ? 0 : (unsigned)v_offsets.size() - 1; };
+
+    std::vector<size_t> v_time_steps;  // sorted by group
+    std::vector<size_t> v_offsets;     // [n_groups + 1]
+};
+
+/**
+ * Day of the year (0...364) of every time step of a daily time series, as
+ * decoded from its calendar (see `utils::get_dayofyear`), and the time step
+ * at the center of the long-term 31-day interval of every day of every year.
+ * Days that are skipped by the calendar (360-day years) are centered on the
+ * following time step, February 29th is part of the interval of February
+ * 28th. Without an index, every year of a time series has 365 time steps.
+ */
+struct DayOfYearIndex {
+    DayOfYearIndex(){};
+    DayOfYearIndex(std::vector<unsigned> v_dayofyear);
+
+    bool empty() const { return v_dayofyear.empty(); };
+
+    std::vector<unsigned> v_dayofyear;  // [time]
+    std::vector<long> v_centers;        // [year][365], -1 if the year does not contain the day
+    size_t n_years = 0;
+};
+
 /**
  * Structure that stores parameters for the
  * adjustment methods LS, VS, DM, QM and QDM, implemented in
  * the class `CMethods`
  */
 struct AdjustmentSettings {
-    AdjustmentSettings() : max_scaling_factor(10),    // maximum scaling factor
-                           n_quantiles(250),          // number of quantiles to respect
-                           interval31_scaling(true),  // calculate the means based on long-term 31-day moving windows or on the whole data at once
-                           kind("add"){};             // adjustment kind => additive or multiplicative
+    AdjustmentSettings() : max_scaling_factor(10),          // maximum scaling factor
+                           n_quantiles(250),                // number of quantiles to respect
+                           interval31_scaling(true),        // calculate the means based on long-term 31-day moving windows or on the whole data at once
+                           kind(AdjustmentKind::Additive),  // adjustment kind => additive or multiplicative
+                           cdf_method(CDFMethod::Histogram),    // estimation of the CDFs for QM and QDM
+                           compensated_summation(false),        // carry the rounding errors of the cumulative sums of the batched LS and DM
+                           lookup_table_resolution(0),          // points per quantile bin of the QM and QDM lookup tables (0: no tables)
+                           sketch_error(0.01),                  // normalized rank error of the quantile sketches (CDFMethod::Sketch)
+                           interval31_mapping(false),           // map the quantiles of QM and QDM per day of the year based on long-term 31-day moving windows
+                           n_threads(1){};                      // threads that may be used within one grid cell (time chunks, days of the year)
 
     AdjustmentSettings(
         double max_scaling_factor,
         unsigned n_quantiles,
         bool interval31_scaling,
-        std::string kind
+        AdjustmentKind kind
     ) : max_scaling_factor(max_scaling_factor),
         n_quantiles(n_quantiles),
         interval31_scaling(interval31_scaling),
-        kind(kind){};
+        kind(kind),
+        cdf_method(CDFMethod::Histogram),
+        compensated_summation(false),
+        lookup_table_resolution(0),
+        sketch_error(0.01),
+        interval31_mapping(false),
+        n_threads(1){};
     double max_scaling_factor;
     unsigned n_quantiles;
     bool interval31_scaling;
-    std::string kind;
+    AdjustmentKind kind;
+    CDFMethod cdf_method;
+    bool compensated_summation;
+    unsigned lookup_table_resolution;
+    double sketch_error;
+    bool interval31_mapping;
+    unsigned n_threads;
+
+    // calendars of the time series for the long-term 31-day intervals (optional)
+    DayOfYearIndex reference_dayofyear;
+    DayOfYearIndex control_dayofyear;
+    DayOfYearIndex scenario_dayofyear;
+
+    // months or seasons of the time series that are adjusted separately (optional)
+    TimeGroups reference_groups;
+    TimeGroups control_groups;
+    TimeGroups scenario_groups;
+};
+
+/**
+ * Memory layout of the time series of several grid cells
+ */
+enum class SlabLayout {
+    CellTime,  // [cells][time] - every time series is contiguous
+    TimeCell   // [time][cells] - all cells of a time step are contiguous
+};
+
+/**
+ * Non-owning view of the time series of `n_cells` grid cells, where the
+ * value of cell `c` at time step `t` is `data[c * cell_stride + t * time_stride]`.
+ * The values are stored as `T` (float, float16 or bfloat16) but the
+ * adjustments are always computed in (at least) single precision, so the
+ * storage type only determines the memory footprint and bandwidth.
+ */
+template <typename T>
+struct BasicSlab {
+    BasicSlab(T* data, size_t n_cells, size_t n_time, SlabLayout layout)
+        : data(data),
+          n_cells(n_cells),
+          n_time(n_time),
+          cell_stride((layout == SlabLayout::CellTime) ? n_time : 1),
+          time_stride((layout == SlabLayout::CellTime) ? 1 : n_cells){};
+
+    BasicSlab(T* data, size_t n_cells, size_t n_time, size_t cell_stride, size_t time_stride)
+        : data(data),
+          n_cells(n_cells),
+          n_time(n_time),
+          cell_stride(cell_stride),
+          time_stride(time_stride){};
+
+    // view of the cells [first, first + count)
+    BasicSlab get_cells(size_t first, size_t count) const {
+        return BasicSlab(data + first * cell_stride, count, n_time, cell_stride, time_stride);
+    };
+    T& at(size_t cell, size_t ts) const { return data[cell * cell_stride + ts * time_stride]; };
+
+    T* data;
+    size_t n_cells;
+    size_t n_time;
+    size_t cell_stride;
+    size_t time_stride;
+};
+
+typedef BasicSlab<float> Slab;
+
+/**
+ * Buffers that are reused by the adjustment procedures for every grid cell,
+ * so that no memory has to be allocated once the buffers have grown to the
+ * size of the data. A workspace must not be shared between threads.
+ */
+struct CMethodsWorkspace {
+    CMethodsWorkspace(){};
+    CMethodsWorkspace(size_t n_time, unsigned n_quantiles);
+
+    // QM and QDM
+    std::vector<double> v_xbins;
+    std::vector<double> v_reference_cdf;
+    std::vector<double> v_control_cdf;
+    std::vector<double> v_scenario_cdf;
+
+    // QM and QDM based on the exact empirical CDFs
+    std::vector<double> v_reference_sorted;
+    std::vector<double> v_control_sorted;
+    std::vector<unsigned> v_scenario_order;
+    std::vector<std::pair<float, unsigned>> v_pairs;
+
+    // QM and QDM based on quantile sketches
+    QuantileSketch reference_sketch;
+    QuantileSketch control_sketch;
+
+    // QM and QDM based on long-term 31-day moving windows (one buffer per thread)
+    std::vector<Interval31Buffers> v_interval31_buffers;
+    std::vector<size_t> v_dayofyear_time_steps;
+    std::vector<size_t> v_dayofyear_offsets;
+
+    // QM and QDM based on lookup tables of the transfer functions
+    std::vector<double> v_transfer_table;
+    std::vector<double> v_transfer_table_denominator;
+
+    // CDFs of the time chunks of a time series that are counted in parallel
+    std::vector<double> v_chunk_cdfs;
+
+    // cumulative sums and long-term parameters (the batched LS, VS and DM)
+    std::vector<double> v_scratch;
+    std::vector<double> v_numerator_means;
+    std::vector<double> v_denominator_means;
+    std::vector<float> v_factors;
+    std::vector<double> v_dayofyear_tables;
+
+    // time series of a single cell of a slab
+    std::vector<float> v_output;
+    std::vector<float> v_reference;
+    std::vector<float> v_control;
+    std::vector<float> v_scenario;
+
+    // time steps of a single group of a time series
+    std::vector<float> v_group_output;
+    std::vector<float> v_group_reference;
+    std::vector<float> v_group_control;
+    std::vector<float> v_group_scenario;
+
+    // outcome of the last adjusted cell resp. of every cell of the last batch (LS and DM)
+    CellStatus status = CellStatus::Ok;
+    std::vector<CellStatus> v_cell_status;
+
+    // number of cells per `CellStatus`, accumulated by the slab procedures
+    size_t status_counts[4] = {0, 0, 0, 0};
 };
 
+typedef void (*AdjustmentFunction)(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+);
+
 class CMethods {
    public:
     CMethods();
@@ -65,8 +348,25 @@ class CMethods {
     static std::vector<std::string> scaling_method_names;
     static std::vector<std::string> distribution_method_names;
 
+    static AdjustmentKind get_adjustment_kind(std::string name);
+    static AdjustmentMethod get_adjustment_method(std::string name);
+    static std::string get_adjustment_kind_name(AdjustmentKind kind);
+    static CDFMethod get_cdf_method(std::string name);
+    static std::string get_cdf_method_name(CDFMethod cdf_method);
+    static TimeGrouping get_time_grouping(std::string name);
+    static std::string get_time_grouping_name(TimeGrouping grouping);
+    static StorageType get_storage_type(std::string name);
+    static std::string get_storage_type_name(StorageType storage_type);
+    static std::string get_cell_status_name(CellStatus status);
+    static AdjustmentFunction get_adjustment_function(
+        AdjustmentMethod method,
+        AdjustmentKind kind,
+        bool interval31_scaling
+    );
+
     static double get_adjusted_scaling_factor(double factor, double max_factor);
     static std::vector<std::vector<float>> get_long_term_dayofyear(std::vector<float>& v_in);
+    static std::vector<std::vector<float>> get_long_term_dayofyear(std::vector<float>& v_in, const DayOfYearIndex& index);
 
     static void Linear_Scaling(
         std::vector<float>& v_output,
@@ -75,6 +375,14 @@ class CMethods {
         std::vector<float>& v_scenario,
         AdjustmentSettings& settings
     );
+    static void Linear_Scaling(
+        std::vector<float>& v_output,
+        std::vector<float>& v_reference,
+        std::vector<float>& v_control,
+        std::vector<float>& v_scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
     static void Variance_Scaling(
         std::vector<float>& v_output,
         std::vector<float>& v_reference,
@@ -82,6 +390,14 @@ class CMethods {
         std::vector<float>& v_scenario,
         AdjustmentSettings& settings
     );
+    static void Variance_Scaling(
+        std::vector<float>& v_output,
+        std::vector<float>& v_reference,
+        std::vector<float>& v_control,
+        std::vector<float>& v_scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
     static void Delta_Method(
         std::vector<float>& v_output,
         std::vector<float>& v_reference,
@@ -89,6 +405,14 @@ class CMethods {
         std::vector<float>& v_scenario,
         AdjustmentSettings& settings
     );
+    static void Delta_Method(
+        std::vector<float>& v_output,
+        std::vector<float>& v_reference,
+        std::vector<float>& v_control,
+        std::vector<float>& v_scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
 
     static std::vector<double> get_xbins(
         std::vector<float>& a,
@@ -103,13 +427,109 @@ class CMethods {
         std::vector<float>& v_scenario,
         AdjustmentSettings& settings
     );
+    static void Quantile_Mapping(
+        std::vector<float>& v_output,
+        std::vector<float>& v_reference,
+        std::vector<float>& v_control,
+        std::vector<float>& v_scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+    static void Quantile_Delta_Mapping(
+        std::vector<float>& v_output,
+        std::vector<float>& v_reference,
+        std::vector<float>& v_control,
+        std::vector<float>& v_scenario,
+        AdjustmentSettings& settings
+    );
     static void Quantile_Delta_Mapping(
         std::vector<float>& v_output,
         std::vector<float>& v_reference,
         std::vector<float>& v_control,
         std::vector<float>& v_scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+
+    template <typename T>
+    static void Adjust_Slab(
+        AdjustmentMethod method,
+        const BasicSlab<T>& output,
+        const BasicSlab<T>& reference,
+        const BasicSlab<T>& control,
+        const BasicSlab<T>& scenario,
         AdjustmentSettings& settings
     );
+    template <typename T>
+    static void Adjust_Slab(
+        AdjustmentMethod method,
+        const BasicSlab<T>& output,
+        const BasicSlab<T>& reference,
+        const BasicSlab<T>& control,
+        const BasicSlab<T>& scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+    static void Adjust_Groups(
+        AdjustmentMethod method,
+        std::vector<float>& v_output,
+        std::vector<float>& v_reference,
+        std::vector<float>& v_control,
+        std::vector<float>& v_scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+
+    static size_t get_n_parameters(
+        AdjustmentMethod method,
+        AdjustmentSettings& settings,
+        size_t n_reference,
+        size_t n_control
+    );
+    static void Fit_Transfer_Function(
+        AdjustmentMethod method,
+        double* v_parameters,
+        std::vector<float>& v_reference,
+        std::vector<float>& v_control,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+    static void Fit_Transfer_Function(
+        AdjustmentMethod method,
+        double* v_parameters,
+        const QuantileSketch& reference,
+        const QuantileSketch& control,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+    static void Apply_Transfer_Function(
+        AdjustmentMethod method,
+        std::vector<float>& v_output,
+        const double* v_parameters,
+        std::vector<float>& v_scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+    template <typename T>
+    static void Fit_Slab(
+        AdjustmentMethod method,
+        double* v_parameters,
+        size_t n_parameters,
+        const BasicSlab<T>& reference,
+        const BasicSlab<T>& control,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
+    template <typename T>
+    static void Apply_Slab(
+        AdjustmentMethod method,
+        const BasicSlab<T>& output,
+        const double* v_parameters,
+        size_t n_parameters,
+        const BasicSlab<T>& scenario,
+        AdjustmentSettings& settings,
+        CMethodsWorkspace& workspace
+    );
 
    private:
 };
@@ -0,0 +1,77 @@
+// -*- lsst-c++ -*-
+
+/**
+ * @file Kernels.hxx
+ * @brief Declaration of the vectorized kernels used by the scaling-based methods
+ * @author Benjamin Thomas Schwertfeger
+ * @email: contact@b-schwertfeger.de
+ * @link https://github.com/btschwertfeger/BiasAdjustCXX
+ *
+ *  * Copyright (C) 2023 Benjamin Thomas Schwertfeger
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __KERNELS__
+#define __KERNELS__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Instruction sets the kernels are compiled for. `Scalar` is the plain
+ * reference implementation, `Baseline` the vectorized implementation for
+ * the instruction set the program was compiled for.
+ */
+enum class InstructionSet {
+    Scalar,
+    Baseline,
+    SSE4,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Apply loops of the scaling-based methods. The time series are processed
+ * year by year against tables of 365 values (one per day of year), the
+ * implementation is selected once based on the features of the CPU.
+ */
+class Kernels {
+   public:
+    Kernels();
+    ~Kernels();
+
+    static std::vector<InstructionSet> get_available_instruction_sets();
+    static InstructionSet get_instruction_set();
+    static void set_instruction_set(InstructionSet instruction_set);
+    static std::string get_instruction_set_name(InstructionSet instruction_set);
+
+    static void add_dayofyear(float* v_output, const float* v_input, size_t n_time, const float* v_table);
+    static void multiply_dayofyear(float* v_output, const float* v_input, size_t n_time, const float* v_table);
+    static void affine_dayofyear(
+        float* v_output,
+        const float* v_input,
+        size_t n_time,
+        const double* v_offsets,
+        const double* v_factors,
+        const double* v_means
+    );
+    static void affine(float* v_output, const float* v_input, size_t n_time, double offset, double factor, double mean);
+
+   private:
+};
+
+#endif
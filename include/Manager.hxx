@@ -31,14 +31,6 @@
 #include "NcFileHandler.hxx"
 #include "Utils.hxx"
 
-typedef void (*AdjustmentFunction)(
-    std::vector<float>& v_output,
-    std::vector<float>& v_reference,
-    std::vector<float>& v_control,
-    std::vector<float>& v_scenario,
-    AdjustmentSettings& settings
-);
-
 class Manager {
    public:
     Manager(int argc, char** argv);
@@ -57,24 +49,68 @@ class Manager {
         std::vector<float>& v_control,
         std::vector<float>& v_scenario
     );
+    // the slab-based functions are templates on the storage type of the slabs (see `storage_type`)
+    template <typename T>
+    void adjust_slab(BasicSlab<T> output, BasicSlab<T> reference, BasicSlab<T> control, BasicSlab<T> scenario, CMethodsWorkspace& workspace);
+    template <typename T>
     void adjust_3d(std::vector<std::vector<std::vector<float>>>& v_data_out);
+    template <typename T>
+    void adjust_2d(std::vector<float>& v_data_out);
+
+    void fit_transfer_functions();
+    template <typename T>
+    void fit_slab(double* v_parameters, size_t n_parameters, BasicSlab<T> reference, BasicSlab<T> control, CMethodsWorkspace& workspace);
+    template <typename T>
+    void fit_3d(std::vector<double>& v_parameters, size_t n_parameters);
+    template <typename T>
+    void fit_2d(std::vector<double>& v_parameters, size_t n_parameters);
+    template <typename ReadReference, typename ReadControl>
+    void fit_sketches(
+        double* v_parameters,
+        size_t n_parameters,
+        size_t n_cells,
+        ReadReference read_reference,
+        ReadControl read_control,
+        std::vector<CMethodsWorkspace>& v_workspaces
+    );
+    void get_lon_parameters(std::vector<double>& v_lon_parameters, size_t n_parameters, unsigned lon, std::vector<CMethodsWorkspace>& v_workspaces);
+    void get_station_parameters(std::vector<double>& v_block_parameters, size_t n_parameters, size_t block, size_t n_block, std::vector<CMethodsWorkspace>& v_workspaces);
+    template <typename T>
+    void apply_slab(BasicSlab<T> output, const double* v_parameters, size_t n_parameters, BasicSlab<T> scenario, CMethodsWorkspace& workspace);
+    template <typename T>
+    void apply_3d(std::vector<std::vector<std::vector<float>>>& v_data_out);
+    template <typename T>
+    void apply_2d(std::vector<float>& v_data_out);
+    void read_transfer_settings();
+    void set_threads_per_cell(size_t n_tasks);
+    void add_status_counts(const CMethodsWorkspace& workspace);
+    void log_status_counts();
 
     int argc;
     char** argv;
 
+    AdjustmentMethod adjustment_method;
     AdjustmentFunction adjustment_function;
     AdjustmentSettings adjustment_settings;
+    TimeGrouping time_grouping = TimeGrouping::DayOfYear31;
+    StorageType storage_type = StorageType::Float;  // type that stores the slabs of 2- and 3-dimensional data sets
 
-    NcFileHandler* ds_reference;
-    NcFileHandler* ds_control;
-    NcFileHandler* ds_scenario;
+    NcFileHandler* ds_reference = nullptr;
+    NcFileHandler* ds_control = nullptr;
+    NcFileHandler* ds_scenario = nullptr;
+    NcFileHandler* ds_transfer = nullptr;  // transfer functions (apply mode)
 
     std::string variable_name;
     std::string output_filepath;
     std::string adjustment_method_name;
+    std::string fit_filepath;    // only fit the transfer functions and save them here
+    std::string apply_filepath;  // apply the transfer functions saved here
+    bool stream_sketches = false;  // fit QM resp. QDM from quantile sketches that are filled time chunk by time chunk (`--cdf sketch`)
 
     bool one_dim;
+    std::string station_dimension;  // spatial dimension of 2-dimensional data sets (time x station), empty for 1 and 3 dimensions
     unsigned n_jobs;
+    size_t status_counts[4] = {0, 0, 0, 0};  // number of adjusted resp. fitted cells per `CellStatus`
     utils::Log log;
 };
 #endif
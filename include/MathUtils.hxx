@@ -27,6 +27,8 @@
 #ifndef __MathUtils__
 #define __MathUtils__
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -44,6 +46,7 @@ class MathUtils {
 
     static Func_one get_method_for_1_ds(std::string name);
     static Func_two get_method_for_2_ds(std::string name);
+    static void compute_indicators(const std::vector<std::string>& v_names, const float* x, const float* y, size_t n_values, double* v_results);
 
     static double correlation_coefficient(std::vector<float>& x, std::vector<float>& y);
 
@@ -58,18 +61,164 @@ class MathUtils {
     static double mean(std::vector<float>& a);
     static double mean(std::vector<double>& a);
 
-    static float median(std::vector<float>& a);
-    static double median(std::vector<double>& a);
+    static float median(const std::vector<float>& a);
+    static double median(const std::vector<double>& a);
+    static double quantile(const float* values, size_t n_values, double p, std::vector<float>& v_scratch);
+    static void quantiles(const float* values, size_t n_values, const std::vector<double>& v_probabilities, std::vector<double>& v_quantiles, std::vector<float>& v_scratch);
 
     static double lerp(double a, double b, double x);
 
     static std::vector<int> get_pdf(std::vector<float>& arr, std::vector<double>& bins);
     static std::vector<int> get_cdf(std::vector<float>& arr, std::vector<double>& bins);
+    static void get_cdf(std::vector<float>& arr, std::vector<double>& bins, std::vector<double>& v_cdf);
+    static void get_cdf(const float* arr, size_t n_values, const std::vector<double>& bins, double* v_cdf);
     static double interpolate(std::vector<double>& xData, std::vector<double>& yData, double x, bool extrapolate);
+    static void interpolate(const std::vector<double>& xData, const std::vector<double>& yData, const double* x, size_t n_values, double* y, bool extrapolate);
     static double ensure_devidable(double numerator, double denominator, double max_scaling_factor);
     static float ensure_devidable(float numerator, float denominator, double max_scaling_factor);
 
    private:
 };
 
+/**
+ * Streaming accumulator of the number of values, the mean, the sum of
+ * squared deviations from the mean (M2), the minimum and the maximum of a
+ * series (Welford (1962), https://doi.org/10.1080/00401706.1962.10490022).
+ * nan values are ignored. Accumulators of chunks of a series can be merged
+ * (Chan, Golub and LeVeque (1979): Updating Formulae and a Pairwise
+ * Algorithm for Computing Sample Variances), the result is the accumulator
+ * of the concatenated chunks, so that chunked and parallel reductions
+ * combine correctly.
+ *
+ * Arrays are added block-wise: the blocks are reduced in branch-free loops
+ * that can be vectorized by the compiler and merged pairwise, so the
+ * rounding error grows with the logarithm of the length of the array
+ * instead of linearly. Nothing is allocated.
+ */
+class Moments {
+   public:
+    Moments();
+
+    void reset();
+    void update(double value);
+    void update(const float* values, size_t n_values);
+    void update(const double* values, size_t n_values);
+    void update(const std::vector<float>& v_values);
+    void merge(const Moments& other);
+
+    bool empty() const { return n == 0; };
+    uint64_t get_n() const { return n; };
+    double get_mean() const;
+    double get_variance() const;
+    double get_sd() const;
+    double get_min() const;
+    double get_max() const;
+
+   private:
+    template <typename T>
+    static Moments get_block_moments(const T* values, unsigned n_values);
+    template <typename T>
+    static Moments get_pairwise_moments(const T* values, size_t n_values);
+
+    uint64_t n;
+    double mean, m2, min, max;
+};
+
+/**
+ * Streaming accumulator of the statistics of pairs of values ( `x`: reference,
+ * `y`: prediction ) that are needed by the indicators of `MathUtils`: the
+ * number of pairs, the means, the sums of squared deviations of `x`, `y`
+ * and `y - x` and the co-moment of `x` and `y`. Pairs that contain nan are
+ * ignored. Like `Moments`, accumulators of chunks can be merged and arrays
+ * are reduced block-wise and merged pairwise without allocations.
+ */
+class PairedMoments {
+   public:
+    PairedMoments();
+
+    void reset();
+    void update(double x, double y);
+    void update(const float* x, const float* y, size_t n_values);
+    void merge(const PairedMoments& other);
+
+    bool empty() const { return n == 0; };
+    uint64_t get_n() const { return n; };
+    double get_mean_x() const;
+    double get_mean_y() const;
+    double get_mbe() const;
+    double get_rmse() const;
+    double get_sum_of_squared_errors() const;
+    double get_correlation() const;
+
+   private:
+    static PairedMoments get_block_moments(const float* x, const float* y, unsigned n_values);
+    static PairedMoments get_pairwise_moments(const float* x, const float* y, size_t n_values);
+
+    uint64_t n;
+    double mean_x, mean_y, m2_x, m2_y, m2_d, c_xy;
+};
+
+/**
+ * Computes the indicators of `MathUtils::compute_indicators` separately for
+ * groups of time steps, e.g. per year, month or season. The group of every
+ * time step is fixed at construction, the accumulators of the groups are
+ * reused for every (pair of) time series.
+ */
+class GroupedIndicators {
+   public:
+    GroupedIndicators(const std::vector<std::string>& v_names, const std::vector<int>& v_groups, unsigned n_groups);
+
+    void compute(const float* x, const float* y, double* v_results);
+    unsigned get_n_groups() const { return n_groups; };
+
+   private:
+    std::vector<std::string> v_names;
+    std::vector<int> v_groups;  // group of every time step, negative values are skipped
+    unsigned n_groups;
+    bool one_ds, two_ds, needs_ioa;
+
+    std::vector<Moments> v_moments;
+    std::vector<PairedMoments> v_paired_moments;
+    std::vector<double> v_ioa_denominators;
+};
+
+/**
+ * Linear interpolation on parallel vectors ( `xData`, `yData` ) whose
+ * x values are evenly spaced, like the bins of `CMethods::get_xbins`.
+ * The interval is computed arithmetically instead of being searched,
+ * the results are identical to `MathUtils::interpolate`.
+ * The data is referenced, not copied and must outlive the interpolator.
+ */
+class UniformInterpolator {
+   public:
+    UniformInterpolator(const std::vector<double>& xData, const std::vector<double>& yData, bool extrapolate);
+    double operator()(double x) const;
+
+   private:
+    const double* xData;
+    const double* yData;
+    int size;
+    bool extrapolate;
+    double inverse_step;
+};
+
+/**
+ * Linear interpolation on parallel vectors ( `xData`, `yData` ) where
+ * `xData` is sorted but not necessarily evenly spaced or strictly
+ * increasing, like a CDF. The interval is found using binary search,
+ * the results are identical to `MathUtils::interpolate`.
+ * The data is referenced, not copied and must outlive the interpolator.
+ */
+class SortedInterpolator {
+   public:
+    SortedInterpolator(const std::vector<double>& xData, const std::vector<double>& yData, bool extrapolate);
+    double operator()(double x) const;
+
+   private:
+    const double* xData;
+    const double* yData;
+    int size;
+    bool extrapolate;
+};
+
 #endif
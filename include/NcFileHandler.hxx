@@ -27,7 +27,11 @@
 #ifndef __NcFileHandler__
 #define __NcFileHandler__
 
+#include <map>
 #include <netcdf>
+#include <string>
+#include <utility>
+#include <vector>
 
 class NcFileHandler {
    public:
@@ -36,9 +40,19 @@ class NcFileHandler {
     ~NcFileHandler();
 
     void get_lat_timeseries_for_lon(std::vector<std::vector<float>>& v_out_arr, unsigned lon);
+    void get_lat_slab_for_lon(std::vector<float>& v_out_arr, unsigned lon);
+    void get_lat_slab_for_lon(std::vector<float>& v_out_arr, unsigned lon, size_t first_time, size_t count_time);
+    void get_station_slab(std::vector<float>& v_out_arr, size_t first, size_t count);
+    void get_station_slab(std::vector<float>& v_out_arr, size_t first, size_t count, size_t first_time, size_t count_time);
     void get_timeseries(std::vector<float>& v_out_arr, unsigned lat, unsigned lon);
     void get_timeseries(std::vector<float>& v_out_arr);
 
+    void get_parameter_slab_for_lon(std::vector<double>& v_out_arr, unsigned lon);
+    void get_parameter_slab_for_stations(std::vector<double>& v_out_arr, size_t first, size_t count);
+    void get_parameters(std::vector<double>& v_out_arr);
+    std::string get_attribute(std::string name);
+    std::string get_time_attribute(std::string name);
+
     void to_netcdf(std::string out_fpath, std::string variable_name, float* out_data);
     void to_netcdf(std::string out_fpath, std::string variable_name, std::vector<float>& v_out_data);
     void to_netcdf(std::string out_fpath, std::string variable_name, float** out_data);
@@ -47,10 +61,27 @@ class NcFileHandler {
     void to_netcdf(std::string out_fpath, std::string variable_name, float*** out_data);
     void to_netcdf(std::string out_fpath, std::string variable_name, std::vector<std::vector<std::vector<float>>>& v_out_data);
     void to_netcdf(std::string out_fpath, std::vector<std::string> variable_names, std::vector<float**> out_data);
+    void to_netcdf(
+        std::string out_fpath,
+        std::vector<std::string> variable_names,
+        std::vector<std::vector<float>>& v_out_data,
+        std::string group_name,
+        std::vector<int>& v_group_values,
+        std::string group_description
+    );
+    void to_netcdf(
+        std::string out_fpath,
+        std::string variable_name,
+        std::vector<double>& v_parameters,
+        unsigned n_parameters,
+        std::vector<std::pair<std::string, std::string>> attributes
+    );
 
     static std::string time_name;
     static std::string lat_name;
     static std::string lon_name;
+    static std::string station_name;  // spatial dimension of 2-dimensional data sets, e.g. station or ncells
+    static std::string parameter_name;
 
     static std::string units;
     static std::string lat_unit;
@@ -61,10 +92,13 @@ class NcFileHandler {
     netCDF::NcDim time_dim;
     netCDF::NcDim lat_dim;
     netCDF::NcDim lon_dim;
+    netCDF::NcDim station_dim;
 
     unsigned int n_lat = 0;
     unsigned int n_lon = 0;
+    unsigned int n_stations = 0;
     unsigned int n_time = 0;
+    unsigned int n_parameters = 0;
 
     float* lat_values = nullptr;
     float* lon_values = nullptr;
@@ -75,14 +109,18 @@ class NcFileHandler {
     netCDF::NcVar lon_var;
     netCDF::NcVar lat_var;
     netCDF::NcVar time_var;
+    std::vector<std::string> station_variables;  // coordinates and IDs of the stations (2-dimensional data sets)
 
     bool handles_file;
     unsigned n_dimensions;
 
     void read_dataset(std::string filepath, std::string variable, unsigned n_dimensiions);
+    void read_parameters(std::string filepath, std::string variable, unsigned n_dimensions);
     void close_file();
 
    private:
+    void find_station_variables();
+    void put_station_variables(netCDF::NcFile& output_file, netCDF::NcDim& out_station_dim);
 };
 
 #endif
@@ -0,0 +1,147 @@
+// -*- lsst-c++ -*-
+
+/**
+ * @file Precision.hxx
+ * @brief Storage types of reduced precision and compensated summation
+ * @author Benjamin Thomas Schwertfeger
+ * @email: contact@b-schwertfeger.de
+ * @link https://github.com/btschwertfeger/BiasAdjustCXX
+ *
+ *  * Copyright (C) 2023 Benjamin Thomas Schwertfeger
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __PRECISION__
+#define __PRECISION__
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * IEEE 754 half-precision value (1 sign, 5 exponent and 10 mantissa bits)
+ * that is only used to store data. It has about 3 significant decimal
+ * digits and a range of +-65504, values are converted to float for any
+ * computation and rounded to the nearest representable value (ties to even)
+ * when stored.
+ */
+struct float16 {
+    float16() : bits(0){};
+    float16(float value) : bits(from_float(value)){};
+    operator float() const { return to_float(bits); };
+
+    static uint16_t from_float(float value) {
+        uint32_t x;
+        std::memcpy(&x, &value, sizeof(x));
+        const uint32_t sign = x & 0x80000000u;
+        x ^= sign;
+
+        uint16_t result;
+        if (x >= (127u + 16u) << 23) {  // overflow, inf and nan
+            result = (x > 0x7f800000u) ? 0x7e00 : 0x7c00;
+        } else if (x < (113u << 23)) {  // subnormal or zero: let the FPU round the mantissa
+            const uint32_t magic_bits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+            float f, magic;
+            std::memcpy(&f, &x, sizeof(f));
+            std::memcpy(&magic, &magic_bits, sizeof(magic));
+            f += magic;
+            std::memcpy(&x, &f, sizeof(x));
+            result = (uint16_t)(x - magic_bits);
+        } else {  // normal: rebias the exponent and round to nearest even
+            const uint32_t mantissa_odd = (x >> 13) & 1;
+            x += ((uint32_t)(15 - 127) << 23) + 0xfff + mantissa_odd;
+            result = (uint16_t)(x >> 13);
+        }
+        return result | (uint16_t)(sign >> 16);
+    };
+
+    static float to_float(uint16_t bits) {
+        const uint32_t exponent_mask = 0x7c00u << 13;
+        uint32_t x = (uint32_t)(bits & 0x7fff) << 13;
+        const uint32_t exponent = x & exponent_mask;
+        x += (127u - 15u) << 23;
+        if (exponent == exponent_mask) {  // inf and nan
+            x += (128u - 16u) << 23;
+        } else if (exponent == 0) {  // subnormal or zero: renormalize
+            const uint32_t magic_bits = 113u << 23;
+            float f, magic;
+            x += 1u << 23;
+            std::memcpy(&f, &x, sizeof(f));
+            std::memcpy(&magic, &magic_bits, sizeof(magic));
+            f -= magic;
+            std::memcpy(&x, &f, sizeof(x));
+        }
+        x |= (uint32_t)(bits & 0x8000) << 16;
+
+        float result;
+        std::memcpy(&result, &x, sizeof(result));
+        return result;
+    };
+
+    uint16_t bits;
+};
+
+/**
+ * bfloat16 value (the upper 16 bits of a float: 1 sign, 8 exponent and 7
+ * mantissa bits) that is only used to store data. It has the range of a
+ * float but only about 2 significant decimal digits, values are rounded to
+ * the nearest representable value (ties to even) when stored.
+ */
+struct bfloat16 {
+    bfloat16() : bits(0){};
+    bfloat16(float value) : bits(from_float(value)){};
+    operator float() const { return to_float(bits); };
+
+    static uint16_t from_float(float value) {
+        uint32_t x;
+        std::memcpy(&x, &value, sizeof(x));
+        if ((x & 0x7fffffffu) > 0x7f800000u) return (uint16_t)((x >> 16) | 0x40);  // quiet nan
+        x += 0x7fffu + ((x >> 16) & 1);
+        return (uint16_t)(x >> 16);
+    };
+
+    static float to_float(uint16_t bits) {
+        const uint32_t x = (uint32_t)bits << 16;
+        float result;
+        std::memcpy(&result, &x, sizeof(result));
+        return result;
+    };
+
+    uint16_t bits;
+};
+
+/**
+ * Running sum that carries the rounding error of every addition
+ * (Neumaier's variant of the Kahan summation), so that the error of the
+ * result does not grow with the number of summands.
+ */
+template <typename T>
+struct CompensatedSum {
+    void add(T x) {
+        const T t = sum + x;
+        if (std::abs(sum) >= std::abs(x))
+            compensation += (sum - t) + x;
+        else
+            compensation += (x - t) + sum;
+        sum = t;
+    };
+    T get() const { return sum + compensation; };
+
+    T sum = 0;
+    T compensation = 0;
+};
+
+#endif
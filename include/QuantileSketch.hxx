@@ -0,0 +1,81 @@
+// -*- lsst-c++ -*-
+
+/**
+ * @file QuantileSketch.hxx
+ * @brief Declaration of the QuantileSketch class
+ * @author Benjamin Thomas Schwertfeger
+ * @email: contact@b-schwertfeger.de
+ * @link https://github.com/btschwertfeger/BiasAdjustCXX
+ *
+ *  * Copyright (C) 2023 Benjamin Thomas Schwertfeger
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __QUANTILESKETCH__
+#define __QUANTILESKETCH__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Mergeable quantile sketch (KLL, Karnin, Lang and Liberty (2016): Optimal
+ * Quantile Approximation in Streams, https://doi.org/10.1109/FOCS.2016.17)
+ * that summarizes a stream of values in O(k) memory, independent of the
+ * length of the stream. The ranks returned by `get_rank` have an error of
+ * about `get_error(k)` (normalized by the number of values), the minimum
+ * and maximum are exact. Sketches of several time chunks or files can be
+ * merged, the result is the sketch of the concatenated streams.
+ * The compactions are seeded deterministically, so that the same stream
+ * always leads to the same sketch.
+ */
+class QuantileSketch {
+   public:
+    QuantileSketch(unsigned k = 200);
+    ~QuantileSketch();
+
+    static unsigned get_k(double error);
+    static double get_error(unsigned k);
+
+    void reset(unsigned k);
+    void update(float value);
+    void update(const std::vector<float>& v_values);
+    void merge(const QuantileSketch& other);
+
+    bool empty() const { return n == 0; };
+    uint64_t get_n() const { return n; };
+    unsigned get_k() const { return k; };
+    size_t get_n_retained() const { return n_retained; };
+    double get_min() const;
+    double get_max() const;
+    double get_rank(double value) const;
+    double get_quantile(double p) const;
+
+   private:
+    unsigned get_capacity(unsigned level) const;
+    void grow();
+    void compress();
+    void compact(unsigned level);
+
+    unsigned k;
+    uint64_t n;
+    float min, max;
+    std::vector<std::vector<float>> v_levels;  // values of level `h` have the weight 2^h
+    size_t n_retained, max_retained;
+    uint32_t random_state;
+};
+
+#endif
@@ -56,6 +56,10 @@ std::string get_version();
 void show_usage();
 void show_copyright_notice(std::string program_name);
 void show_license();
+
+std::vector<unsigned> get_dayofyear(const double* v_time, size_t n_time, std::string units, std::string calendar);
+std::vector<unsigned> get_month(const double* v_time, size_t n_time, std::string units, std::string calendar);
+std::vector<int> get_year(const double* v_time, size_t n_time, std::string units, std::string calendar);
 }  // namespace utils
 
 #endif
@@ -39,10 +39,14 @@
 
 #include <algorithm>
 #include <cmath>
+#include <future>
 #include <iostream>
 #include <limits>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "Kernels.hxx"
 #include "MathUtils.hxx"
 #include "Utils.hxx"
 #include "math.h"
@@ -128,6 +132,854 @@ std::vector<std::vector<float>> CMethods::get_long_term_dayofyear(std::vector<fl
     return v_out;
 }
 
+/**
+ * Get 365 long-term 31-day moving windows of a time series with an
+ * arbitrary calendar, where `index` determines the time steps at the
+ * centers of the windows. Without an index, this equals the function above.
+ *
+ * @param v_in input vector
+ * @param index day of the year of every entry of `v_in`
+ * @return 2D vector (dimensions: [365, ~31 * y]) containing the values with
+ *         index -15...0...+15 around a day over all years
+ */
+std::vector<std::vector<float>> CMethods::get_long_term_dayofyear(std::vector<float>& v_in, const DayOfYearIndex& index) {
+    if (index.empty()) return get_long_term_dayofyear(v_in);
+    if (index.v_dayofyear.size() != v_in.size())
+        throw std::runtime_error("The day-of-year index does not match the length of the time series!");
+
+    std::vector<std::vector<float>> v_out(365, std::vector<float>());
+    const long n = (long)v_in.size();
+    for (long day = 0; day < 365; day++) {
+        for (size_t year = 0; year < index.n_years; year++) {
+            const long center = index.v_centers[year * 365 + day];
+            if (center < 0) continue;
+            v_out[day].insert(
+                v_out[day].end(),
+                v_in.begin() + std::max(0L, center - 15),
+                v_in.begin() + std::min(n, center + 16)
+            );
+        }
+    }
+    return v_out;
+}
+
+/**
+ * Builds the index of the long-term 31-day intervals (see `DayOfYearIndex`).
+ * A new year starts whenever the day of the year decreases.
+ *
+ * @param v_dayofyear day of the year (0...364) of every time step
+ */
+DayOfYearIndex::DayOfYearIndex(std::vector<unsigned> v_dayofyear) : v_dayofyear(v_dayofyear) {
+    const size_t n_time = v_dayofyear.size();
+    for (size_t ts = 0; ts < n_time; ts++)
+        if (v_dayofyear[ts] >= 365) throw std::runtime_error("The day of the year must be in the range 0...364!");
+
+    size_t start = 0;
+    while (start < n_time) {
+        size_t end = start + 1;
+        while (end < n_time && v_dayofyear[end] >= v_dayofyear[end - 1]) end++;
+
+        v_centers.resize((n_years + 1) * 365, -1);
+        size_t ts = start;
+        for (unsigned day = 0; day < 365; day++) {
+            while (ts < end && v_dayofyear[ts] < day) ts++;
+            if (ts == end) break;
+            const bool
+                is_present = (v_dayofyear[ts] == day),
+                is_skipped = (ts > start && v_dayofyear[ts] == day + 1 && v_dayofyear[ts - 1] + 1 == day);
+            if (is_present || is_skipped) v_centers[n_years * 365 + day] = (long)ts;
+        }
+        n_years++;
+        start = end;
+    }
+}
+
+/**
+ * Sorts the time steps by their group (counting sort), so that the time
+ * steps of every group can be gathered without searching.
+ *
+ * @param v_groups group (0...`n_groups` - 1) of every time step
+ * @param n_groups number of groups
+ */
+TimeGroups::TimeGroups(const std::vector<unsigned>& v_groups, unsigned n_groups) : v_time_steps(v_groups.size()),
+                                                                                    v_offsets(n_groups + 1, 0) {
+    for (size_t ts = 0; ts < v_groups.size(); ts++) {
+        if (v_groups[ts] >= n_groups) throw std::runtime_error("Time step assigned to an unknown group!");
+        v_offsets[v_groups[ts] + 1]++;
+    }
+    for (unsigned group = 0; group < n_groups; group++) v_offsets[group + 1] += v_offsets[group];
+
+    std::vector<size_t> v_next(v_offsets.begin(), v_offsets.end() - 1);
+    for (size_t ts = 0; ts < v_groups.size(); ts++) v_time_steps[v_next[v_groups[ts]]++] = ts;
+}
+
+/**
+ * Empties the window, so that the next call of `move` inserts all values
+ */
+void SortedWindow::clear() {
+    v_sorted.clear();
+    v_ranges.clear();
+}
+
+/**
+ * Moves the window to the time steps of `v_new_ranges` (one [start, end)
+ * range per year, empty ranges are allowed). The values of the time steps
+ * that are only part of the current resp. the new ranges are sorted and
+ * merged into the sorted values in a single pass. The ranges must be passed
+ * in the same order on every call.
+ *
+ * @param v_in time series the window moves over
+ * @param v_new_ranges ranges of time steps of the new window
+ */
+void SortedWindow::move(const std::vector<float>& v_in, const std::vector<std::pair<size_t, size_t>>& v_new_ranges) {
+    v_ranges.resize(v_new_ranges.size(), std::make_pair((size_t)0, (size_t)0));
+    v_removed.clear();
+    v_inserted.clear();
+
+    // appends the values of the time steps [start, end) that are not nan
+    auto collect = [&v_in](size_t start, size_t end, std::vector<double>& v_out) {
+        for (size_t ts = start; ts < end; ts++)
+            if (!std::isnan(v_in[ts])) v_out.push_back(v_in[ts]);
+    };
+    for (size_t i = 0; i < v_new_ranges.size(); i++) {
+        const size_t
+            old_start = v_ranges[i].first, old_end = v_ranges[i].second,
+            new_start = v_new_ranges[i].first, new_end = v_new_ranges[i].second;
+        collect(old_start, std::min(old_end, new_start), v_removed);
+        collect(std::max(old_start, new_end), old_end, v_removed);
+        collect(new_start, std::min(new_end, old_start), v_inserted);
+        collect(std::max(new_start, old_end), new_end, v_inserted);
+    }
+    v_ranges = v_new_ranges;
+    if (v_removed.empty() && v_inserted.empty()) return;
+
+    std::sort(v_removed.begin(), v_removed.end());
+    std::sort(v_inserted.begin(), v_inserted.end());
+    v_merged.clear();
+    v_merged.reserve(v_sorted.size() + v_inserted.size());
+    size_t removed = 0, inserted = 0;
+    for (const double value : v_sorted) {
+        if (removed < v_removed.size() && value == v_removed[removed]) {
+            removed++;
+            continue;
+        }
+        while (inserted < v_inserted.size() && v_inserted[inserted] < value) v_merged.push_back(v_inserted[inserted++]);
+        v_merged.push_back(value);
+    }
+    v_merged.insert(v_merged.end(), v_inserted.begin() + inserted, v_inserted.end());
+    v_sorted.swap(v_merged);
+}
+
+/**
+ * Throws if `n_time` does not consist of complete years with 365 days each,
+ * which is required for the long-term 31-day interval based adjustment.
+ *
+ * @param n_time length of the time dimension
+ */
+static void check_complete_years(size_t n_time) {
+    if (n_time % 365 != 0)
+        throw std::runtime_error(
+            "The size of the time dimension of the "
+            "input data does not match `size` % 365!"
+        );
+}
+
+/**
+ * Returns `index` if it is not empty or NULL, in which case the time series
+ * must consist of complete years with 365 days each to compute long-term
+ * 31-day means.
+ *
+ * @param index day-of-year index of a time series
+ * @param n_time length of the time series
+ * @param complete_years throw if there is no index and the last year is incomplete
+ * @return pointer to `index` or NULL
+ */
+static const DayOfYearIndex* get_dayofyear_index(const DayOfYearIndex& index, size_t n_time, bool complete_years = true) {
+    if (index.empty()) {
+        if (complete_years) check_complete_years(n_time);
+        return NULL;
+    }
+    if (index.v_dayofyear.size() != n_time)
+        throw std::runtime_error("The day-of-year index does not match the length of the time series!");
+    return &index;
+}
+
+// number of (possibly incomplete) years of a time series
+static inline long get_n_years(const DayOfYearIndex* index, size_t n_time) {
+    return (index == NULL) ? (long)(n_time / 365) : (long)index->n_years;
+}
+
+// time step at the center of the 31-day interval of `day` in `year`, -1 if there is none
+static inline long get_center(const DayOfYearIndex* index, long year, long day) {
+    return (index == NULL) ? year * 365 + day : index->v_centers[year * 365 + day];
+}
+
+// day of the year of the time step `ts`
+static inline unsigned get_day(const DayOfYearIndex* index, size_t ts) {
+    return (index == NULL) ? (unsigned)(ts % 365) : index->v_dayofyear[ts];
+}
+
+/**
+ * Calls `f(start, count, day)` for every run of consecutive days of the
+ * year within the time steps [`first`, `last`), i.e., time step `start + i`
+ * belongs to day `day + i` for all `i < count`, so that the kernels can
+ * process the runs against tables of 365 values. Without an index, the
+ * range is only split at the first new year, so that the runs are periodic
+ * from their start.
+ *
+ * @param index day-of-year index of the time series (may be NULL)
+ * @param first first time step
+ * @param last end of the time steps
+ * @param f function to call for every run
+ */
+template <typename F>
+static void for_each_dayofyear_run(const DayOfYearIndex* index, size_t first, size_t last, F f) {
+    if (first >= last) return;
+    if (index == NULL) {
+        const size_t new_year = std::min(last, first + (365 - first % 365) % 365);
+        if (new_year > first) f(first, new_year - first, (unsigned)(first % 365));
+        if (last > new_year) f(new_year, last - new_year, 0);
+        return;
+    }
+    const unsigned* v_dayofyear = index->v_dayofyear.data();
+    for (size_t start = first, end = first + 1; start < last; start = end++) {
+        while (end < last && v_dayofyear[end] == v_dayofyear[end - 1] + 1) end++;
+        f(start, end - start, v_dayofyear[start]);
+    }
+}
+
+/**
+ * Calls `f(start, count, day)` for every run of consecutive days of the
+ * year of the whole time series (see above). Without an index, the whole
+ * time series is one run.
+ *
+ * @param index day-of-year index of the time series (may be NULL)
+ * @param n_time length of the time series
+ * @param f function to call for every run
+ */
+template <typename F>
+static void for_each_dayofyear_run(const DayOfYearIndex* index, size_t n_time, F f) {
+    for_each_dayofyear_run(index, 0, n_time, f);
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Parallelism within a grid cell
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+// minimum number of time steps that is worth a thread of its own
+static constexpr size_t min_time_chunk = 1 << 14;
+
+/**
+ * Returns the number of chunks that a loop over `n` elements is split into,
+ * at most `n_threads` and at least `min_chunk` elements per chunk
+ *
+ * @param n_threads threads that may be used (`AdjustmentSettings::n_threads`)
+ * @param n number of elements
+ * @param min_chunk minimum number of elements per chunk
+ * @return number of chunks, at least 1
+ */
+static unsigned get_n_chunks(unsigned n_threads, size_t n, size_t min_chunk) {
+    return (unsigned)std::max((size_t)1, std::min((size_t)n_threads, n / std::max(min_chunk, (size_t)1)));
+}
+
+/**
+ * Splits the elements [0, `n`) into `n_chunks` contiguous chunks and calls
+ * `f(first, last, chunk)` for every chunk. The first chunk is processed by
+ * the calling thread, the others in parallel by their own tasks like the
+ * slabs of the `Manager`, so the `Manager` can split its threads between the
+ * grid cells and the chunks without oversubscription.
+ *
+ * @param n_chunks number of chunks (see `get_n_chunks`)
+ * @param n number of elements
+ * @param f function to call for every chunk
+ */
+template <typename F>
+static void for_each_chunk(unsigned n_chunks, size_t n, F f) {
+    if (n_chunks <= 1) {
+        f((size_t)0, n, 0u);
+        return;
+    }
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(n_chunks - 1);
+    for (unsigned chunk = 1; chunk < n_chunks; chunk++)
+        tasks.push_back(std::async(std::launch::async, f, chunk * n / n_chunks, (chunk + 1) * n / n_chunks, chunk));
+    f((size_t)0, n / n_chunks, 0u);
+    for (auto& e : tasks) e.get();
+}
+
+/**
+ * Computes the CDF of `v_in` at the boundaries `v_bins` (see
+ * `MathUtils::get_cdf`) by counting the time chunks in parallel and adding
+ * up their CDFs, which yields exactly the CDF of the whole time series
+ *
+ * @param v_in 1D time series
+ * @param v_bins probability boundaries
+ * @param v_cdf output vector of the CDF
+ * @param n_threads threads that may be used
+ * @param v_chunk_cdfs scratch space for the CDFs of the chunks
+ */
+static void get_chunked_cdf(
+    const std::vector<float>& v_in,
+    const std::vector<double>& v_bins,
+    std::vector<double>& v_cdf,
+    unsigned n_threads,
+    std::vector<double>& v_chunk_cdfs
+) {
+    const unsigned n_chunks = get_n_chunks(n_threads, v_in.size(), min_time_chunk);
+    const size_t n_bins = v_bins.size();
+    v_cdf.resize(n_bins);
+    v_chunk_cdfs.resize((n_chunks - 1) * n_bins);
+    for_each_chunk(n_chunks, v_in.size(), [&](size_t first, size_t last, unsigned chunk) {
+        double* cdf = (chunk == 0) ? v_cdf.data() : &v_chunk_cdfs[(chunk - 1) * n_bins];
+        MathUtils::get_cdf(v_in.data() + first, last - first, v_bins, cdf);
+    });
+    for (unsigned chunk = 1; chunk < n_chunks; chunk++)
+        for (size_t i = 0; i < n_bins; i++) v_cdf[i] += v_chunk_cdfs[(chunk - 1) * n_bins + i];
+}
+
+// number of grid cells that are processed together by the batched kernels
+static constexpr unsigned batch_width = 16;
+
+// number of tables of 365 long-term parameters per cell used by Variance Scaling
+static constexpr unsigned n_dayofyear_tables = 15;
+
+/**
+ * Stores the first value of every cell [first, first + n_cells) of `slab`
+ * that is not NaN (or 0 if there is none) in `shift`. This is used to shift
+ * the time series before accumulating their moments, which avoids
+ * cancellation when computing the variance.
+ *
+ * @param slab input time series
+ * @param first index of the first cell
+ * @param n_cells number of cells (at most `batch_width`)
+ * @param shift output array (length: `batch_width`, cells without values: 0)
+ */
+template <typename T>
+static void get_batch_shifts(const BasicSlab<T>& slab, size_t first, unsigned n_cells, double* shift) {
+    for (unsigned c = 0; c < batch_width; c++) shift[c] = 0;
+    for (unsigned c = 0; c < n_cells; c++) {
+        for (size_t ts = 0; ts < slab.n_time; ts++) {
+            const double x = slab.at(first + c, ts);
+            if (!std::isnan(x)) {
+                shift[c] = x;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Fills `v_prefix` with the cumulative sums of the values returned by
+ * `value(ts, c)` of the cells [0, `n_cells`), `v_prefix_sq` (if not NULL)
+ * with the cumulative sums of the squared values and `v_prefix_nan` with the
+ * cumulative number of NaN values. All arrays have the shape
+ * [`n_time + 1`][`batch_width`], so that the loops over the cells of a time
+ * step can be vectorized, the columns of the unused cells are 0. NaN values
+ * are accumulated as 0, so that the windows that do not contain any NaN are
+ * not affected by them.
+ *
+ * @param n_time length of the time series
+ * @param n_cells number of cells (at most `batch_width`)
+ * @param value function that returns the (shifted) value of cell `c` at index `ts`
+ * @param v_prefix output array of cumulative sums
+ * @param v_prefix_sq output array of cumulative squared sums (optional)
+ * @param v_prefix_nan output array of cumulative NaN counts
+ */
+template <typename F>
+static void cumulative_sums(
+    size_t n_time,
+    unsigned n_cells,
+    F value,
+    double* v_prefix,
+    double* v_prefix_sq,
+    double* v_prefix_nan
+) {
+    for (unsigned c = 0; c < batch_width; c++) {
+        v_prefix[c] = v_prefix_nan[c] = 0;
+        if (v_prefix_sq != NULL) v_prefix_sq[c] = 0;
+    }
+
+    double row[batch_width] = {0};
+    for (size_t ts = 0; ts < n_time; ts++) {
+        for (unsigned c = 0; c < n_cells; c++) row[c] = value(ts, c);
+
+        const double
+            *previous = v_prefix + ts * batch_width,
+            *previous_nan = v_prefix_nan + ts * batch_width;
+        double
+            *current = v_prefix + (ts + 1) * batch_width,
+            *current_nan = v_prefix_nan + (ts + 1) * batch_width;
+        for (unsigned c = 0; c < batch_width; c++) {
+            const bool is_nan = std::isnan(row[c]);
+            current[c] = previous[c] + (is_nan ? 0 : row[c]);
+            current_nan[c] = previous_nan[c] + (is_nan ? 1 : 0);
+        }
+        if (v_prefix_sq != NULL) {
+            const double* previous_sq = v_prefix_sq + ts * batch_width;
+            double* current_sq = v_prefix_sq + (ts + 1) * batch_width;
+            for (unsigned c = 0; c < batch_width; c++)
+                current_sq[c] = previous_sq[c] + (std::isnan(row[c]) ? 0 : row[c] * row[c]);
+        }
+    }
+}
+
+/**
+ * Computes the sums over the long-term 31-day moving windows of all 365 days
+ * of the year from the cumulative sums of `batch_width` cells. The windows
+ * are the same as those returned by `get_long_term_dayofyear`, i.e., index
+ * -15...0...+15 around every occurrence of a day, clipped at the start and
+ * end of the series. NaN values have been accumulated as 0, so they are
+ * ignored.
+ *
+ * @param v_prefix cumulative sums (shape: [`n_time + 1`][`batch_width`])
+ * @param index day-of-year index (NULL: `n_time` is a multiple of 365)
+ * @param n_time length of the time series
+ * @param v_sums output array (shape: [365][`batch_width`])
+ */
+static void long_term_dayofyear_sums(
+    const double* v_prefix,
+    const DayOfYearIndex* index,
+    size_t n_time,
+    double* v_sums
+) {
+    const long n_years = get_n_years(index, n_time), n = (long)n_time;
+    for (long day = 0; day < 365; day++) {
+        double* sums = v_sums + day * batch_width;
+        for (unsigned c = 0; c < batch_width; c++) sums[c] = 0;
+        for (long year = 0; year < n_years; year++) {
+            const long center = get_center(index, year, day);
+            if (center < 0) continue;
+            const long
+                end = std::min(n, center + 16),
+                start = std::max(0L, center - 15);
+            for (unsigned c = 0; c < batch_width; c++)
+                sums[c] += v_prefix[end * batch_width + c] - v_prefix[start * batch_width + c];
+        }
+    }
+}
+
+/**
+ * Computes the number of entries within the long-term 31-day moving windows
+ * of all 365 days of the year.
+ *
+ * @param index day-of-year index (NULL: `n_time` is a multiple of 365)
+ * @param n_time length of the time series
+ * @param v_counts output array (length: 365)
+ */
+static void long_term_dayofyear_counts(const DayOfYearIndex* index, size_t n_time, double* v_counts) {
+    const long n_years = get_n_years(index, n_time), n = (long)n_time;
+    for (long day = 0; day < 365; day++) {
+        long count = 0;
+        for (long year = 0; year < n_years; year++) {
+            const long center = get_center(index, year, day);
+            if (center >= 0) count += std::min(n, center + 16) - std::max(0L, center - 15);
+        }
+        v_counts[day] = (double)count;
+    }
+}
+
+/**
+ * Computes the number of values that are not NaN within the long-term 31-day
+ * moving windows of all 365 days of the year of `batch_width` cells.
+ *
+ * @param v_prefix_nan cumulative NaN counts (shape: [`n_time + 1`][`batch_width`])
+ * @param index day-of-year index (NULL: `n_time` is a multiple of 365)
+ * @param n_time length of the time series
+ * @param v_counts output array (shape: [365][`batch_width`])
+ */
+static void long_term_dayofyear_counts(const double* v_prefix_nan, const DayOfYearIndex* index, size_t n_time, double* v_counts) {
+    double counts[365];
+    long_term_dayofyear_counts(index, n_time, counts);
+    long_term_dayofyear_sums(v_prefix_nan, index, n_time, v_counts);
+    for (unsigned day = 0; day < 365; day++)
+        for (unsigned c = 0; c < batch_width; c++) v_counts[day * batch_width + c] = counts[day] - v_counts[day * batch_width + c];
+}
+
+/**
+ * Computes the means of the periodic series `v_table[ts % 365]` resp.
+ * `v_table[dayofyear[ts]]` of the cells [first, first + n_cells) over the
+ * long-term 31-day moving windows, respecting only the time steps at which
+ * `mask` is not NaN. The series of cells without an index and without NaN
+ * values are not materialized, otherwise their cumulative sums are stored in
+ * `v_prefix` and `v_prefix_nan`.
+ *
+ * @param v_table 365 values per cell that are repeated every year (shape: [365][`batch_width`])
+ * @param mask time series whose NaN values are excluded from the windows
+ * @param first index of the first cell of `mask`
+ * @param n_cells number of cells (at most `batch_width`)
+ * @param index day-of-year index (NULL: `n_time` is a multiple of 365)
+ * @param v_counts number of values within the windows if there are no NaN values (shape: [365][`batch_width`])
+ * @param n_nan number of NaN values of every cell of `mask` (length: `batch_width`)
+ * @param v_prefix scratch space (shape: [`n_time + 1`][`batch_width`])
+ * @param v_prefix_nan scratch space (shape: [`n_time + 1`][`batch_width`])
+ * @param v_window_counts scratch space (shape: [365][`batch_width`])
+ * @param v_means output array (shape: [365][`batch_width`])
+ */
+template <typename T>
+static void periodic_dayofyear_means(
+    const double* v_table,
+    const BasicSlab<T>& mask,
+    size_t first,
+    unsigned n_cells,
+    const DayOfYearIndex* index,
+    const double* v_counts,
+    const double* n_nan,
+    double* v_prefix,
+    double* v_prefix_nan,
+    double* v_window_counts,
+    double* v_means
+) {
+    const size_t n_time = mask.n_time;
+    bool complete[batch_width] = {false}, all_complete = true;
+    for (unsigned c = 0; c < n_cells; c++) {
+        complete[c] = (index == NULL) && n_nan[c] == 0;
+        for (unsigned day = 0; complete[c] && day < 365; day++) complete[c] = !std::isnan(v_table[day * batch_width + c]);
+        all_complete = all_complete && complete[c];
+    }
+
+    if (!all_complete) {
+        cumulative_sums(
+            n_time, n_cells,
+            [&](size_t ts, unsigned c) {
+                const double x = mask.at(first + c, ts);
+                return std::isnan(x) ? x : v_table[get_day(index, ts) * batch_width + c];
+            },
+            v_prefix, NULL, v_prefix_nan
+        );
+        long_term_dayofyear_sums(v_prefix, index, n_time, v_means);
+        long_term_dayofyear_counts(v_prefix_nan, index, n_time, v_window_counts);
+        for (unsigned i = 0; i < 365 * batch_width; i++) v_means[i] /= v_window_counts[i];
+    }
+
+    const long n_years = (long)(n_time / 365), n = (long)n_time;
+    for (unsigned c = 0; c < n_cells; c++) {
+        if (!complete[c]) continue;
+
+        double v_table_prefix[366];
+        v_table_prefix[0] = 0;
+        for (unsigned day = 0; day < 365; day++) v_table_prefix[day + 1] = v_table_prefix[day] + v_table[day * batch_width + c];
+
+        // cumulative sums of the periodic series up to (excluding) index `ts`
+        auto periodic = [&v_table_prefix](long ts) {
+            return (double)(ts / 365) * v_table_prefix[365] + v_table_prefix[ts % 365];
+        };
+
+        for (long day = 0; day < 365; day++) {
+            double sum = 0;
+            for (long year = 0; year < n_years; year++) {
+                const long
+                    end = std::min(n, year * 365 + day + 16),
+                    start = std::max(0L, year * 365 + day - 15);
+                sum += periodic(end) - periodic(start);
+            }
+            v_means[day * batch_width + c] = sum / v_counts[day * batch_width + c];
+        }
+    }
+}
+
+/**
+ * Reserves the buffers for time series of `n_time` values and `n_quantiles`
+ * quantiles, so that adjusting grid cells of this size does not allocate
+ * any memory. Longer time series let the buffers grow once.
+ *
+ * @param n_time (max) number of time steps of the input time series
+ * @param n_quantiles number of quantiles used by QM and QDM
+ */
+CMethodsWorkspace::CMethodsWorkspace(size_t n_time, unsigned n_quantiles) {
+    const size_t n_bins = (size_t)n_quantiles + 2;
+    v_xbins.reserve(n_bins);
+    v_reference_cdf.reserve(n_bins);
+    v_control_cdf.reserve(n_bins);
+    v_scenario_cdf.reserve(n_bins);
+
+    v_reference_sorted.reserve(n_time);
+    v_control_sorted.reserve(n_time);
+    v_scenario_order.reserve(n_time);
+    v_pairs.reserve(n_time);
+
+    v_scratch.reserve(3 * (n_time + 1) * batch_width);
+    v_dayofyear_tables.reserve(n_dayofyear_tables * 365 * batch_width);
+    v_numerator_means.reserve(365 * batch_width);
+    v_denominator_means.reserve(365 * batch_width);
+    v_factors.reserve(365 * batch_width);
+
+    v_output.reserve(n_time);
+    v_reference.reserve(n_time);
+    v_control.reserve(n_time);
+    v_scenario.reserve(n_time);
+
+    v_group_output.reserve(n_time);
+    v_group_reference.reserve(n_time);
+    v_group_control.reserve(n_time);
+    v_group_scenario.reserve(n_time);
+}
+
+/**
+ * Computes the means of the cells [first, first + n_cells) of `slab` at once,
+ * either over the long-term 31-day moving windows of all 365 days of the
+ * year (`v_means`: [365][batch_width]) or over the whole time series
+ * (`v_means`: [1][batch_width]). The cumulative sums of all cells of a time
+ * step are computed together, so that the loops over the cells can be
+ * vectorized. NaN values are ignored, means of windows that only consist of
+ * NaN values are NaN. With
+ * `compensated`, the rounding errors of the cumulative sums are accumulated
+ * separately (see `CompensatedSum`) and added to the window sums.
+ *
+ * @param slab input time series
+ * @param dayofyear day-of-year index of the time series (may be empty)
+ * @param first index of the first cell
+ * @param n_cells number of cells (at most `batch_width`)
+ * @param v_scratch scratch space, resized if too small
+ * @param v_means output array
+ */
+template <bool interval31_scaling, bool compensated, typename T>
+static void get_batch_means(
+    const BasicSlab<T>& slab,
+    const DayOfYearIndex& dayofyear,
+    size_t first,
+    unsigned n_cells,
+    std::vector<double>& v_scratch,
+    double* v_means
+) {
+    const size_t n_time = slab.n_time, n_rows = n_time + 1, n_arrays = compensated ? 3 : 2;
+    if (v_scratch.size() < n_arrays * n_rows * batch_width) v_scratch.resize(n_arrays * n_rows * batch_width);
+    double
+        *v_prefix = &v_scratch[0],
+        *v_prefix_nan = v_prefix + n_rows * batch_width,
+        *v_prefix_error = v_prefix_nan + n_rows * batch_width;  // only if `compensated`
+
+    // shift every cell by its first valid value to avoid cancellation
+    double shift[batch_width], row[batch_width] = {0};
+    get_batch_shifts(slab, first, n_cells, shift);
+
+    for (unsigned c = 0; c < batch_width; c++) {
+        v_prefix[c] = v_prefix_nan[c] = 0;
+        if constexpr (compensated) v_prefix_error[c] = 0;
+    }
+    for (size_t ts = 0; ts < n_time; ts++) {
+        const T* values = &slab.at(first, ts);
+        for (unsigned c = 0; c < n_cells; c++) row[c] = values[c * slab.cell_stride];
+
+        const double
+            *previous = v_prefix + ts * batch_width,
+            *previous_nan = v_prefix_nan + ts * batch_width;
+        double
+            *current = v_prefix + (ts + 1) * batch_width,
+            *current_nan = v_prefix_nan + (ts + 1) * batch_width;
+        if constexpr (compensated) {
+            const double* previous_error = v_prefix_error + ts * batch_width;
+            double* current_error = v_prefix_error + (ts + 1) * batch_width;
+            for (unsigned c = 0; c < batch_width; c++) {
+                const double x = row[c] - shift[c];
+                const bool is_nan = std::isnan(x);
+                CompensatedSum<double> sum = {previous[c], previous_error[c]};
+                sum.add(is_nan ? 0 : x);
+                current[c] = sum.sum;
+                current_error[c] = sum.compensation;
+                current_nan[c] = previous_nan[c] + (is_nan ? 1 : 0);
+            }
+        } else {
+            for (unsigned c = 0; c < batch_width; c++) {
+                const double x = row[c] - shift[c];
+                const bool is_nan = std::isnan(x);
+                current[c] = previous[c] + (is_nan ? 0 : x);
+                current_nan[c] = previous_nan[c] + (is_nan ? 1 : 0);
+            }
+        }
+    }
+
+    // sum of the cell `c` over the time steps [start, end)
+    auto window_sum = [&](size_t start, size_t end, unsigned c) {
+        const double sum = v_prefix[end * batch_width + c] - v_prefix[start * batch_width + c];
+        if constexpr (compensated)
+            return sum + (v_prefix_error[end * batch_width + c] - v_prefix_error[start * batch_width + c]);
+        else
+            return sum;
+    };
+
+    if constexpr (!interval31_scaling) {
+        const double* n_nan = v_prefix_nan + n_time * batch_width;
+        for (unsigned c = 0; c < batch_width; c++)
+            v_means[c] = shift[c] + window_sum(0, n_time, c) / ((double)n_time - n_nan[c]);
+
+    } else {
+        const DayOfYearIndex* index = get_dayofyear_index(dayofyear, n_time);
+        double v_counts[365];
+        long_term_dayofyear_counts(index, n_time, v_counts);
+
+        const long n_years = get_n_years(index, n_time), n = (long)n_time;
+        for (long day = 0; day < 365; day++) {
+            double sums[batch_width] = {0}, n_nan[batch_width] = {0};
+            for (long year = 0; year < n_years; year++) {
+                const long center = get_center(index, year, day);
+                if (center < 0) continue;
+                const long
+                    end = std::min(n, center + 16),
+                    start = std::max(0L, center - 15);
+                for (unsigned c = 0; c < batch_width; c++) {
+                    sums[c] += window_sum(start, end, c);
+                    n_nan[c] += v_prefix_nan[end * batch_width + c] - v_prefix_nan[start * batch_width + c];
+                }
+            }
+            for (unsigned c = 0; c < batch_width; c++)
+                v_means[day * batch_width + c] = shift[c] + sums[c] / (v_counts[day] - n_nan[c]);
+        }
+    }
+}
+
+/**
+ * Returns the difference (additive) or the ratio (multiplicative) of two
+ * means, i.e. the scaling factor of Linear Scaling and the Delta Method
+ *
+ * @param numerator_mean mean that forms the numerator resp. minuend
+ * @param denominator_mean mean that forms the denominator resp. subtrahend
+ * @param settings adjustment settings (uses `max_scaling_factor`)
+ * @return the scaling factor
+ */
+template <AdjustmentKind kind, typename T>
+static T get_scaling_factor(T numerator_mean, T denominator_mean, AdjustmentSettings& settings) {
+    if constexpr (kind == AdjustmentKind::Additive)
+        return numerator_mean - denominator_mean;
+    else
+        return MathUtils::ensure_devidable(numerator_mean, denominator_mean, settings.max_scaling_factor);
+}
+
+/**
+ * Adjusts the time series of `target` by the difference (additive) or ratio
+ * (multiplicative) of the means of `numerator` and `denominator`, i.e.
+ * Linear Scaling (numerator: reference, target: scenario) and the Delta
+ * Method (numerator: scenario, target: reference). The means are computed
+ * for `batch_width` cells at once. NaN values are ignored by the means and
+ * stay NaN, periods without any value are not adjusted and the outcome of
+ * every cell is stored in `workspace.v_cell_status`.
+ *
+ * @param output output time series (same shape as `target`)
+ * @param numerator time series whose means form the numerator resp. minuend
+ * @param denominator time series whose means form the denominator resp. subtrahend
+ * @param target time series to adjust
+ * @param numerator_dayofyear day-of-year index of `numerator` (may be empty)
+ * @param denominator_dayofyear day-of-year index of `denominator` (may be empty)
+ * @param target_dayofyear day-of-year index of `target` (may be empty)
+ * @param settings adjustment settings (uses `max_scaling_factor`)
+ * @param workspace buffers for the cumulative sums, means and factors
+ */
+template <AdjustmentKind kind, bool interval31_scaling, typename T>
+static void scale_by_means(
+    const BasicSlab<T>& output,
+    const BasicSlab<T>& numerator,
+    const BasicSlab<T>& denominator,
+    const BasicSlab<T>& target,
+    const DayOfYearIndex& numerator_dayofyear,
+    const DayOfYearIndex& denominator_dayofyear,
+    const DayOfYearIndex& target_dayofyear,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    constexpr unsigned n_periods = interval31_scaling ? 365 : 1;
+    const size_t n_time = target.n_time;
+    // the vectorized kernels process float time series
+    const bool contiguous_time = std::is_same<T, float>::value && target.time_stride == 1 && output.time_stride == 1;
+    const DayOfYearIndex* target_index = interval31_scaling ? get_dayofyear_index(target_dayofyear, n_time, false) : NULL;
+
+    std::vector<double>
+        &v_scratch = workspace.v_scratch,
+        &v_numerator_means = workspace.v_numerator_means,
+        &v_denominator_means = workspace.v_denominator_means;
+    std::vector<float>& v_factors = workspace.v_factors;
+    std::vector<CellStatus>& v_cell_status = workspace.v_cell_status;
+    v_numerator_means.resize(n_periods * batch_width);
+    v_denominator_means.resize(n_periods * batch_width);
+    v_factors.resize(n_periods * batch_width);
+    v_cell_status.resize(target.n_cells);
+
+    // scaling factor that leaves the time series unchanged
+    constexpr float neutral_factor = (kind == AdjustmentKind::Additive) ? 0 : 1;
+    // the time series of few cells are additionally split into time chunks
+    const unsigned n_chunks = get_n_chunks(settings.n_threads, n_time, min_time_chunk);
+
+    for (size_t first = 0; first < target.n_cells; first += batch_width) {
+        const unsigned n_cells = (unsigned)std::min((size_t)batch_width, target.n_cells - first);
+        if (settings.compensated_summation) {
+            get_batch_means<interval31_scaling, true>(numerator, numerator_dayofyear, first, n_cells, v_scratch, v_numerator_means.data());
+            get_batch_means<interval31_scaling, true>(denominator, denominator_dayofyear, first, n_cells, v_scratch, v_denominator_means.data());
+        } else {
+            get_batch_means<interval31_scaling, false>(numerator, numerator_dayofyear, first, n_cells, v_scratch, v_numerator_means.data());
+            get_batch_means<interval31_scaling, false>(denominator, denominator_dayofyear, first, n_cells, v_scratch, v_denominator_means.data());
+        }
+
+        if constexpr (interval31_scaling) {
+            // ? 365 scaling factors per cell, in single precision like the 365 means
+            unsigned n_missing[batch_width] = {0};
+            for (unsigned i = 0; i < n_periods * batch_width; i++) {
+                v_factors[i] = get_scaling_factor<kind>((float)v_numerator_means[i], (float)v_denominator_means[i], settings);
+                if (std::isnan(v_factors[i])) {
+                    v_factors[i] = neutral_factor;
+                    n_missing[i % batch_width]++;
+                }
+            }
+            for (unsigned c = 0; c < n_cells; c++)
+                v_cell_status[first + c] = (n_missing[c] == 0)         ? CellStatus::Ok
+                                           : (n_missing[c] == n_periods) ? CellStatus::AllMissing
+                                                                         : CellStatus::Fallback;
+
+            if (contiguous_time) {  // ? vectorized along the time
+                if constexpr (std::is_same<T, float>::value) {
+                    float table[365];
+                    for (unsigned c = 0; c < n_cells; c++) {
+                        for (unsigned day = 0; day < 365; day++) table[day] = v_factors[day * batch_width + c];
+                        for_each_chunk(n_chunks, n_time, [&](size_t chunk_first, size_t chunk_last, unsigned) {
+                            for_each_dayofyear_run(target_index, chunk_first, chunk_last, [&](size_t start, size_t count, unsigned day) {
+                                if constexpr (kind == AdjustmentKind::Additive)
+                                    Kernels::add_dayofyear(&output.at(first + c, start), &target.at(first + c, start), count, table + day);
+                                else
+                                    Kernels::multiply_dayofyear(&output.at(first + c, start), &target.at(first + c, start), count, table + day);
+                            });
+                        });
+                    }
+                }
+            } else {  // ? along the cells
+                for_each_chunk(n_chunks, n_time, [&](size_t chunk_first, size_t chunk_last, unsigned) {
+                    for (size_t ts = chunk_first, day = chunk_first % 365; ts < chunk_last; ts++, day = (day == 364) ? 0 : day + 1) {
+                        const T* input = &target.at(first, ts);
+                        const float* factors = &v_factors[((target_index == NULL) ? day : get_day(target_index, ts)) * batch_width];
+                        T* result = &output.at(first, ts);
+                        for (unsigned c = 0; c < n_cells; c++) {
+                            if constexpr (kind == AdjustmentKind::Additive)
+                                result[c * output.cell_stride] = input[c * target.cell_stride] + factors[c];
+                            else
+                                result[c * output.cell_stride] = input[c * target.cell_stride] * factors[c];
+                        }
+                    }
+                });
+            }
+
+        } else {
+            for (unsigned c = 0; c < n_cells; c++) {
+                double scaling_factor = get_scaling_factor<kind>(v_numerator_means[c], v_denominator_means[c], settings);
+                v_cell_status[first + c] = std::isnan(scaling_factor) ? CellStatus::AllMissing : CellStatus::Ok;
+                if (std::isnan(scaling_factor)) scaling_factor = neutral_factor;
+
+                const double
+                    offset = (kind == AdjustmentKind::Additive) ? scaling_factor : 0,
+                    factor = (kind == AdjustmentKind::Additive) ? 1 : scaling_factor;
+
+                for_each_chunk(n_chunks, n_time, [&](size_t chunk_first, size_t chunk_last, unsigned) {
+                    if constexpr (std::is_same<T, float>::value) {
+                        if (contiguous_time) {
+                            Kernels::affine(&output.at(first + c, chunk_first), &target.at(first + c, chunk_first), chunk_last - chunk_first, offset, factor, 0);
+                            return;
+                        }
+                    }
+                    for (size_t ts = chunk_first; ts < chunk_last; ts++)
+                        output.at(first + c, ts) = (T)(((double)target.at(first + c, ts) + offset) * factor);
+                });
+            }
+        }
+    }
+}
+
 /**
  * Checks and returns the desired scaling factor based on `max_factor`
  *
@@ -166,7 +1018,7 @@ double CMethods::get_adjusted_scaling_factor(double factor, double max_factor) {
  *      double max_scaling_factor,
  *      unsigned n_quantiles,
  *      bool interval31_scaling,
- *      std::string kind
+ *      AdjustmentKind kind
  *
  * Add ('+'):
  *  (1.)    $T^{*}_{contr}(d) = T_{contr}(d) + \mu_{m}(T_{obs}(d)) - \mu_{m}(T_{contr}(d))$
@@ -175,7 +1027,33 @@ double CMethods::get_adjusted_scaling_factor(double factor, double max_factor) {
  *  (3.)    $ T_{contr}^{*}(d) = \mu_{m}(T_{obs}(d)) \cdot \left[\frac{T_{contr}(d)}{\mu_{m}(T_{contr}(d))}\right]$
  *  (4.)    $ T_{scen}^{*}(d) = \mu_{m}(T_{obs}(d)) \cdot \left[\frac{T_{contr}(d)}{\mu_{m}(T_{scen}(d))}\right]$
  */
+template <AdjustmentKind kind, bool interval31_scaling>
+static void linear_scaling(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    scale_by_means<kind, interval31_scaling>(
+        Slab(v_output.data(), 1, v_scenario.size(), SlabLayout::CellTime),
+        Slab(v_reference.data(), 1, v_reference.size(), SlabLayout::CellTime),
+        Slab(v_control.data(), 1, v_control.size(), SlabLayout::CellTime),
+        Slab(v_scenario.data(), 1, v_scenario.size(), SlabLayout::CellTime),
+        settings.reference_dayofyear,
+        settings.control_dayofyear,
+        settings.scenario_dayofyear,
+        settings,
+        workspace
+    );  // Eq. 2 resp. Eq. 4
+    workspace.status = workspace.v_cell_status[0];
+}
 
+/**
+ * Linear Scaling (see `linear_scaling`) using the kernel that is specialized
+ * for `settings.kind` and `settings.interval31_scaling`
+ */
 void CMethods::Linear_Scaling(
     std::vector<float>& v_output,
     std::vector<float>& v_reference,
@@ -183,63 +1061,270 @@ void CMethods::Linear_Scaling(
     std::vector<float>& v_scenario,
     AdjustmentSettings& settings
 ) {
-    if (!settings.interval31_scaling) {
-        if (settings.kind == "add" || settings.kind == "+") {
-            const double scaling_factor = MathUtils::mean(v_reference) - MathUtils::mean(v_control);
-            for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-                v_output[ts] = v_scenario[ts] + scaling_factor;  // Eq. 2
-
-        } else if (settings.kind == "mult" || settings.kind == "*") {
-            const double
-                adjusted_scaling_factor = MathUtils::ensure_devidable(
-                    MathUtils::mean(v_reference), MathUtils::mean(v_control),
-                    settings.max_scaling_factor
-                );
-            for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-                v_output[ts] = v_scenario[ts] * adjusted_scaling_factor;  // Eq. 4
+    CMethodsWorkspace workspace;
+    Linear_Scaling(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
 
-        } else
-            throw std::runtime_error("Unknown Adjustment kind" + settings.kind + " for Linear Scaling.");
+/**
+ * Linear Scaling (see `linear_scaling`) using the kernel that is specialized
+ * for `settings.kind` and `settings.interval31_scaling`
+ * and the buffers of `workspace`
+ */
+void CMethods::Linear_Scaling(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    get_adjustment_function(
+        AdjustmentMethod::LinearScaling, settings.kind, settings.interval31_scaling
+    )(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
 
-    } else {
-        std::vector<float>
-            ref_365_means,
-            contr_365_means;
+/**
+ * Adjusts the time series of `scenario` by Variance Scaling (see
+ * `variance_scaling`), `batch_width` cells at once. The equations are
+ * computed without intermediate time series: The long-term means and
+ * standard deviations of Eq. 1-4 are derived from the cumulative sums of all
+ * cells of a batch (`workspace.v_scratch`) and the adjusted scenario is
+ * computed in one final loop over the data. Only the additive variant is
+ * available. NaN values are ignored by the means and standard deviations
+ * and stay NaN, days of the year (resp. time series) without any value are
+ * not adjusted and the outcome of every cell is stored in
+ * `workspace.v_cell_status`.
+ *
+ * @param output output time series (same shape as `scenario`)
+ * @param reference reference time series (control period)
+ * @param control modeled time series (control period)
+ * @param scenario time series to adjust (scenario period)
+ * @param settings adjustment settings (uses `max_scaling_factor` and the day-of-year indices)
+ * @param workspace buffers for the cumulative sums and the long-term parameters
+ */
+template <bool interval31_scaling, typename T>
+static void scale_by_variances(
+    const BasicSlab<T>& output,
+    const BasicSlab<T>& reference,
+    const BasicSlab<T>& control,
+    const BasicSlab<T>& scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    const size_t
+        n_reference = reference.n_time,
+        n_control = control.n_time,
+        n_scenario = scenario.n_time,
+        n_rows = std::max(n_reference, std::max(n_control, n_scenario)) + 1;
+    // the vectorized kernels process float time series
+    const bool contiguous_time = std::is_same<T, float>::value && scenario.time_stride == 1 && output.time_stride == 1;
+
+    std::vector<double>& v_scratch = workspace.v_scratch;
+    if (v_scratch.size() < 3 * n_rows * batch_width) v_scratch.resize(3 * n_rows * batch_width);
+    double
+        *v_prefix = &v_scratch[0],
+        *v_prefix_sq = v_prefix + n_rows * batch_width,
+        *v_prefix_nan = v_prefix_sq + n_rows * batch_width;
+
+    std::vector<CellStatus>& v_cell_status = workspace.v_cell_status;
+    v_cell_status.resize(scenario.n_cells);
+    const unsigned n_chunks = get_n_chunks(settings.n_threads, n_scenario, min_time_chunk);
+
+    for (size_t first = 0; first < scenario.n_cells; first += batch_width) {
+        const unsigned n_cells = (unsigned)std::min((size_t)batch_width, scenario.n_cells - first);
+        double ref_shift[batch_width], contr_shift[batch_width], scen_shift[batch_width];
+        get_batch_shifts(reference, first, n_cells, ref_shift);
+        get_batch_shifts(control, first, n_cells, contr_shift);
+        get_batch_shifts(scenario, first, n_cells, scen_shift);
+
+        // values of the cells of `slab` shifted by `shift`
+        auto shifted = [first](const BasicSlab<T>& slab, const double* shift) {
+            return [&slab, shift, first](size_t ts, unsigned c) { return (double)slab.at(first + c, ts) - shift[c]; };
+        };
+
+        if constexpr (!interval31_scaling) {
+            // number of values, mean and standard deviation (optional) of the (shifted) cells
+            auto get_moments = [&](size_t n_time, double* count, double* mean, double* sd) {
+                for (unsigned c = 0; c < n_cells; c++) {
+                    count[c] = n_time - v_prefix_nan[n_time * batch_width + c];
+                    mean[c] = v_prefix[n_time * batch_width + c] / count[c];
+                    if (sd != NULL) sd[c] = sqrt(std::max(0.0, v_prefix_sq[n_time * batch_width + c] / count[c] - mean[c] * mean[c]));
+                }
+            };
+            double
+                ref_count[batch_width], ref_mean[batch_width], ref_sd[batch_width],
+                contr_count[batch_width], contr_mean[batch_width], contr_sd[batch_width],
+                scen_count[batch_width], scen_mean[batch_width];
+            cumulative_sums(n_reference, n_cells, shifted(reference, ref_shift), v_prefix, v_prefix_sq, v_prefix_nan);
+            get_moments(n_reference, ref_count, ref_mean, ref_sd);
+            cumulative_sums(n_control, n_cells, shifted(control, contr_shift), v_prefix, v_prefix_sq, v_prefix_nan);
+            get_moments(n_control, contr_count, contr_mean, contr_sd);
+            cumulative_sums(n_scenario, n_cells, shifted(scenario, scen_shift), v_prefix, NULL, v_prefix_nan);
+            get_moments(n_scenario, scen_count, scen_mean, NULL);
+
+            // Eq. 1-4: VS1_contr = contr - mean(contr) and VS1_scen = scen - mean(scen)
+            // LS_scen_mean = mean(scen) + mean(ref) - mean(contr)
+            double offsets[batch_width], scaling_factors[batch_width], LS_scen_means[batch_width];
+            for (unsigned c = 0; c < n_cells; c++) {
+                const bool is_missing = ref_count[c] == 0 || contr_count[c] == 0 || scen_count[c] == 0;
+                v_cell_status[first + c] = is_missing ? CellStatus::AllMissing : CellStatus::Ok;
+                scaling_factors[c] = MathUtils::ensure_devidable(ref_sd[c], contr_sd[c], settings.max_scaling_factor);
+                LS_scen_means[c] = (scen_shift[c] + scen_mean[c]) + (ref_shift[c] + ref_mean[c]) - (contr_shift[c] + contr_mean[c]);
+                offsets[c] = -(scen_shift[c] + scen_mean[c]);
+            }
 
-        std::vector<std::vector<float>>
-            ref_long_term_dayofyear = get_long_term_dayofyear(v_reference),
-            contr_long_term_dayofyear = get_long_term_dayofyear(v_control);
+            for_each_chunk(n_chunks, n_scenario, [&](size_t chunk_first, size_t chunk_last, unsigned) {
+                for (unsigned c = 0; c < n_cells; c++) {
+                    if (v_cell_status[first + c] == CellStatus::AllMissing) {  // ? not adjusted
+                        for (size_t ts = chunk_first; ts < chunk_last; ts++) output.at(first + c, ts) = scenario.at(first + c, ts);
+                        continue;
+                    }
+                    if constexpr (std::is_same<T, float>::value) {
+                        if (contiguous_time) {
+                            Kernels::affine(  // Eq. 6 and 8
+                                &output.at(first + c, chunk_first), &scenario.at(first + c, chunk_first), chunk_last - chunk_first,
+                                offsets[c], scaling_factors[c], LS_scen_means[c]
+                            );
+                            continue;
+                        }
+                    }
+                    for (size_t ts = chunk_first; ts < chunk_last; ts++)
+                        output.at(first + c, ts) = (T)(((double)scenario.at(first + c, ts) + offsets[c]) * scaling_factors[c] + LS_scen_means[c]);
+                }
+            });
+
+        } else {
+            const DayOfYearIndex
+                *ref_index = get_dayofyear_index(settings.reference_dayofyear, n_reference),
+                *contr_index = get_dayofyear_index(settings.control_dayofyear, n_control),
+                *scen_index = get_dayofyear_index(settings.scenario_dayofyear, n_scenario);
+
+            // ? tables of 365 long-term parameters per cell (shape: [365][batch_width])
+            constexpr size_t n_table = 365 * batch_width;
+            std::vector<double>& v_tables = workspace.v_dayofyear_tables;
+            v_tables.resize(n_dayofyear_tables * n_table);
+            double
+                *ref_365_means = &v_tables[0],
+                *ref_365_standard_deviations = ref_365_means + n_table,
+                *contr_365_means = ref_365_standard_deviations + n_table,
+                *contr_counts = contr_365_means + n_table,
+                *scen_365_means = contr_counts + n_table,
+                *scen_counts = scen_365_means + n_table,
+                *LS_offsets = scen_counts + n_table,
+                *VS1_offsets = LS_offsets + n_table,
+                *VS1_contr_365_standard_deviations = VS1_offsets + n_table,
+                *counts = VS1_contr_365_standard_deviations + n_table,
+                *sums = counts + n_table,
+                *squared_sums = sums + n_table,
+                *v_offsets = squared_sums + n_table,
+                *v_scaling_factors = v_offsets + n_table,
+                *LS_scen_365_means = v_scaling_factors + n_table;
+            double contr_nan[batch_width], scen_nan[batch_width];
+
+            // ? compute 365 means and standard deviations of the reference
+            cumulative_sums(n_reference, n_cells, shifted(reference, ref_shift), v_prefix, v_prefix_sq, v_prefix_nan);
+            long_term_dayofyear_counts(v_prefix_nan, ref_index, n_reference, counts);
+            long_term_dayofyear_sums(v_prefix, ref_index, n_reference, sums);
+            long_term_dayofyear_sums(v_prefix_sq, ref_index, n_reference, squared_sums);
+            for (unsigned i = 0; i < n_table; i++) {
+                const double mean = sums[i] / counts[i];
+                ref_365_means[i] = ref_shift[i % batch_width] + mean;
+                ref_365_standard_deviations[i] = sqrt(std::max(0.0, squared_sums[i] / counts[i] - mean * mean));
+            }
 
-        // ? compute 365 means based on long-term 31-day moving windows
-        for (unsigned day = 0; day < 365; day++) {
-            ref_365_means.push_back(MathUtils::mean(ref_long_term_dayofyear[day]));
-            contr_365_means.push_back(MathUtils::mean(contr_long_term_dayofyear[day]));
-        }
+            // ? compute 365 means of the control period
+            cumulative_sums(n_control, n_cells, shifted(control, contr_shift), v_prefix, NULL, v_prefix_nan);
+            for (unsigned c = 0; c < batch_width; c++) contr_nan[c] = v_prefix_nan[n_control * batch_width + c];
+            long_term_dayofyear_counts(v_prefix_nan, contr_index, n_control, contr_counts);
+            long_term_dayofyear_sums(v_prefix, contr_index, n_control, sums);
+            for (unsigned i = 0; i < n_table; i++) {
+                contr_365_means[i] = contr_shift[i % batch_width] + sums[i] / contr_counts[i];
+                LS_offsets[i] = ref_365_means[i] - contr_365_means[i];  // Eq. 1 and 2
+            }
 
-        if (settings.kind == "add" || settings.kind == "+") {
-            for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-                v_output[ts] = v_scenario[ts] + (ref_365_means[ts % 365] - contr_365_means[ts % 365]);  // Eq. 2
-
-        } else if (settings.kind == "mult" || settings.kind == "*") {
-            std::vector<float> adj_scaling_factors;
-            for (unsigned day = 0; day < 365; day++)
-                adj_scaling_factors.push_back(
-                    MathUtils::ensure_devidable(
-                        ref_365_means[day], contr_365_means[day],
-                        settings.max_scaling_factor
-                    )
-                );
+            // ? compute the 365 means of LS_contr = contr + LS_offsets (Eq. 1)
+            periodic_dayofyear_means(LS_offsets, control, first, n_cells, contr_index, contr_counts, contr_nan, v_prefix, v_prefix_nan, counts, sums);
+            for (unsigned i = 0; i < n_table; i++)
+                VS1_offsets[i] = LS_offsets[i] - (contr_365_means[i] + sums[i]);  // Eq. 3
 
-            for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-                v_output[ts] = v_scenario[ts] * adj_scaling_factors[ts % 365];  // Eq. 4
+            // ? compute 365 standard deviations of VS1_contr = contr + VS1_offsets
+            cumulative_sums(
+                n_control, n_cells,
+                [&](size_t ts, unsigned c) { return (double)control.at(first + c, ts) + VS1_offsets[get_day(contr_index, ts) * batch_width + c]; },
+                v_prefix, v_prefix_sq, v_prefix_nan
+            );
+            long_term_dayofyear_counts(v_prefix_nan, contr_index, n_control, counts);
+            long_term_dayofyear_sums(v_prefix, contr_index, n_control, sums);
+            long_term_dayofyear_sums(v_prefix_sq, contr_index, n_control, squared_sums);
+            for (unsigned i = 0; i < n_table; i++) {
+                const double mean = sums[i] / counts[i];
+                VS1_contr_365_standard_deviations[i] = sqrt(std::max(0.0, squared_sums[i] / counts[i] - mean * mean));
+            }
 
-        } else
-            throw std::runtime_error("Unknown Adjustment kind" + settings.kind + " for Linear Scaling.");
+            // ? compute the 365 means of LS_scen = scen + LS_offsets (Eq. 2)
+            cumulative_sums(n_scenario, n_cells, shifted(scenario, scen_shift), v_prefix, NULL, v_prefix_nan);
+            for (unsigned c = 0; c < batch_width; c++) scen_nan[c] = v_prefix_nan[n_scenario * batch_width + c];
+            long_term_dayofyear_counts(v_prefix_nan, scen_index, n_scenario, scen_counts);
+            long_term_dayofyear_sums(v_prefix, scen_index, n_scenario, sums);
+            for (unsigned i = 0; i < n_table; i++) scen_365_means[i] = scen_shift[i % batch_width] + sums[i] / scen_counts[i];
+            periodic_dayofyear_means(LS_offsets, scenario, first, n_cells, scen_index, scen_counts, scen_nan, v_prefix, v_prefix_nan, counts, sums);
+
+            // ? days of the year whose parameters can't be determined are not adjusted
+            unsigned n_missing[batch_width] = {0};
+            for (unsigned i = 0; i < n_table; i++) {
+                LS_scen_365_means[i] = scen_365_means[i] + sums[i];
+                v_offsets[i] = LS_offsets[i] - LS_scen_365_means[i];  // Eq. 4
+                v_scaling_factors[i] = MathUtils::ensure_devidable(
+                    ref_365_standard_deviations[i], VS1_contr_365_standard_deviations[i],
+                    settings.max_scaling_factor
+                );
+                if (std::isnan(v_offsets[i]) || std::isnan(v_scaling_factors[i]) || std::isnan(LS_scen_365_means[i])) {
+                    v_offsets[i] = LS_scen_365_means[i] = 0;
+                    v_scaling_factors[i] = 1;
+                    n_missing[i % batch_width]++;
+                }
+            }
+            for (unsigned c = 0; c < n_cells; c++)
+                v_cell_status[first + c] = (n_missing[c] == 0)     ? CellStatus::Ok
+                                           : (n_missing[c] == 365) ? CellStatus::AllMissing
+                                                                   : CellStatus::Fallback;
+
+            // ? Eq. 6 and Eq. 8 applied year by year
+            if (contiguous_time) {  // ? vectorized along the time
+                if constexpr (std::is_same<T, float>::value) {
+                    double offsets[365], scaling_factors[365], LS_scen_means[365];
+                    for (unsigned c = 0; c < n_cells; c++) {
+                        for (unsigned day = 0; day < 365; day++) {
+                            offsets[day] = v_offsets[day * batch_width + c];
+                            scaling_factors[day] = v_scaling_factors[day * batch_width + c];
+                            LS_scen_means[day] = LS_scen_365_means[day * batch_width + c];
+                        }
+                        for_each_chunk(n_chunks, n_scenario, [&](size_t chunk_first, size_t chunk_last, unsigned) {
+                            for_each_dayofyear_run(scen_index, chunk_first, chunk_last, [&](size_t start, size_t count, unsigned day) {
+                                Kernels::affine_dayofyear(
+                                    &output.at(first + c, start), &scenario.at(first + c, start), count,
+                                    offsets + day, scaling_factors + day, LS_scen_means + day
+                                );
+                            });
+                        });
+                    }
+                }
+            } else {  // ? along the cells
+                for_each_chunk(n_chunks, n_scenario, [&](size_t chunk_first, size_t chunk_last, unsigned) {
+                    for (size_t ts = chunk_first; ts < chunk_last; ts++) {
+                        const size_t i = get_day(scen_index, ts) * batch_width;
+                        for (unsigned c = 0; c < n_cells; c++)
+                            output.at(first + c, ts) = (T)(((double)scenario.at(first + c, ts) + v_offsets[i + c]) * v_scaling_factors[i + c] + LS_scen_365_means[i + c]);
+                    }
+                });
+            }
+        }
     }
 }
 
 /**
  * Method to adjust 1 dimensional climate data by variance scaling method.
+
  * Based on the equations of Teutschbein, Claudia and Seibert, Jan (2012)
  * Bias correction of regional climate model simulations for hydrological
  * climate-change impact studies: Review and evaluation of different methods
@@ -253,7 +1338,7 @@ void CMethods::Linear_Scaling(
  *      double max_scaling_factor = 10,
  *      unsigned n_quantiles = 250,
  *      bool interval31_scaling = false,
- *      std::string kind
+ *      AdjustmentKind kind
  *
  * (1.) $T^{*1}_{contr}(d) = T_{contr}(d) + \mu_{m}(T_{obs}(d)) - \mu_{m}(T_{contr}(d))$
  * (2.) $T^{*1}_{scen}(d) = T_{scen}(d) + \mu_{m}(T_{obs}(d)) - \mu_{m}(T_{scen}(d))$
@@ -267,6 +1352,30 @@ void CMethods::Linear_Scaling(
  * (7.) $T^{*}_{contr}(d) = T^{*3}_{contr}(d) + \mu_{m}(T^{*1}_{contr}(d))$
  * (8.) $T^{*}_{scen}(d) = T^{*3}_{scen}(d) + \mu_{m}(T^{*1}_{scen}(d))$
  */
+template <bool interval31_scaling>
+static void variance_scaling(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    scale_by_variances<interval31_scaling>(
+        Slab(v_output.data(), 1, v_scenario.size(), SlabLayout::CellTime),
+        Slab(v_reference.data(), 1, v_reference.size(), SlabLayout::CellTime),
+        Slab(v_control.data(), 1, v_control.size(), SlabLayout::CellTime),
+        Slab(v_scenario.data(), 1, v_scenario.size(), SlabLayout::CellTime),
+        settings,
+        workspace
+    );
+    workspace.status = workspace.v_cell_status[0];
+}
+
+/**
+ * Variance Scaling (see `variance_scaling`) using the kernel that is
+ * specialized for `settings.interval31_scaling`
+ */
 void CMethods::Variance_Scaling(
     std::vector<float>& v_output,
     std::vector<float>& v_reference,
@@ -274,78 +1383,26 @@ void CMethods::Variance_Scaling(
     std::vector<float>& v_scenario,
     AdjustmentSettings& settings
 ) {
-    std::vector<float> LS_contr(v_reference.size());
-    std::vector<float> LS_scen(v_reference.size());
-
-    Linear_Scaling(LS_contr, v_reference, v_control, v_control, settings);  // Eq. 1
-    Linear_Scaling(LS_scen, v_reference, v_control, v_scenario, settings);  // Eq. 2
-
-    if (!settings.interval31_scaling) {
-        double
-            LS_contr_mean = MathUtils::mean(LS_contr),
-            LS_scen_mean = MathUtils::mean(LS_scen);
-
-        std::vector<float>
-            VS1_contr(v_control.size()),
-            VS1_scen(v_scenario.size());
+    CMethodsWorkspace workspace;
+    Variance_Scaling(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
 
-        for (unsigned ts = 0; ts < v_control.size(); ts++)
-            VS1_contr[ts] = LS_contr[ts] - LS_contr_mean;  // Eq. 3
-
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            VS1_scen[ts] = LS_scen[ts] - LS_scen_mean;  // Eq. 4
-
-        const double
-            adjusted_scaling_factor = MathUtils::ensure_devidable(
-                MathUtils::sd(v_reference), MathUtils::sd(VS1_contr),
-                settings.max_scaling_factor
-            );
-
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            v_output[ts] = (VS1_scen[ts] * adjusted_scaling_factor) + LS_scen_mean;  // Eq. 6 and 8
-
-    } else {
-        std::vector<std::vector<float>>
-            LS_contr_long_term_dayofyear = get_long_term_dayofyear(LS_contr),
-            LS_scen_long_term_dayofyear = get_long_term_dayofyear(LS_scen);
-
-        std::vector<float> LS_contr_365_means, LS_scen_365_means;
-        for (unsigned day = 0; day < 365; day++) {
-            LS_contr_365_means.push_back(MathUtils::mean(LS_contr_long_term_dayofyear[day]));
-            LS_scen_365_means.push_back(MathUtils::mean(LS_scen_long_term_dayofyear[day]));
-        }
-
-        std::vector<float>
-            VS1_contr(v_control.size()),
-            VS1_scen(v_scenario.size());
-
-        for (unsigned ts = 0; ts < v_control.size(); ts++)
-            VS1_contr[ts] = LS_contr[ts] - LS_contr_365_means[ts % 365];  // Eq. 3
-
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            VS1_scen[ts] = LS_scen[ts] - LS_scen_365_means[ts % 365];  // Eq. 4
-
-        std::vector<std::vector<float>>
-            ref_long_term_dayofyear = get_long_term_dayofyear(v_reference),
-            VS1_contr_long_term_dayofyear = get_long_term_dayofyear(VS1_contr);
-
-        // ? compute 365 standard deviations based on long-term 31-day moving windows
-        std::vector<float> ref_365_standard_deviations, VS1_contr_365_standard_deviations;
-        for (unsigned day = 0; day < 365; day++) {
-            ref_365_standard_deviations.push_back(MathUtils::sd(ref_long_term_dayofyear[day]));
-            VS1_contr_365_standard_deviations.push_back(MathUtils::sd(VS1_contr_long_term_dayofyear[day]));
-        }
-
-        std::vector<double> adj_scaling_factors;
-        for (unsigned day = 0; day < 365; day++)
-            adj_scaling_factors.push_back(MathUtils::ensure_devidable(
-                ref_365_standard_deviations[day], VS1_contr_365_standard_deviations[day],
-                settings.max_scaling_factor
-            ));
-
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            v_output[ts] = (VS1_scen[ts] * adj_scaling_factors[ts % 365]) + LS_scen_365_means[ts % 365];  // Eq. 6 and Eq. 8
-    }
+/**
+ * Variance Scaling (see `variance_scaling`) using the kernel that is
+ * specialized for `settings.interval31_scaling`
+ * and the buffers of `workspace`
+ */
+void CMethods::Variance_Scaling(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    get_adjustment_function(
+        AdjustmentMethod::VarianceScaling, settings.kind, settings.interval31_scaling
+    )(v_output, v_reference, v_control, v_scenario, settings, workspace);
 }
 
 /**
@@ -363,19 +1420,21 @@ void CMethods::Variance_Scaling(
  *      double max_scaling_factor,
  *      unsigned n_quantiles,
  *      bool interval31_scaling,
- *      std::string kind
+ *      AdjustmentKind kind
  *
  * Add (+):
  *   (1.) $T^{*}_{contr}(d) = T_{contr}(d) + (\mu_{m}(T_{scen}(d)) - \mu_{m}(T_{obs}(d)))$
  * Mult (*):
  *   (2.) $T^{*}_{contr}(d) = T_{contr}(d) \cdot \left[\frac{\mu_{m}(T_{scen}(d))}{\mu_{m}(T_{obs}(d))}\right]
  */
-void CMethods::Delta_Method(
+template <AdjustmentKind kind, bool interval31_scaling>
+static void delta_method(
     std::vector<float>& v_output,
     std::vector<float>& v_reference,
     std::vector<float>& v_control,
     std::vector<float>& v_scenario,
-    AdjustmentSettings& settings
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
 ) {
     if (v_reference.size() != v_scenario.size())
         throw std::runtime_error(
@@ -383,100 +1442,128 @@ void CMethods::Delta_Method(
             "not have the same length! This is required for the delta method."
         );
 
-    if (!settings.interval31_scaling) {
-        if (settings.kind == "add" || settings.kind == "+") {
-            const double scaling_factor = MathUtils::mean(v_scenario) - MathUtils::mean(v_control);
-            for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-                v_output[ts] = v_reference[ts] + scaling_factor;  // Eq. 1
-
-        } else if (settings.kind == "mult" || settings.kind == "*") {
-            const double adjusted_scaling_factor = MathUtils::ensure_devidable(
-                MathUtils::mean(v_scenario), MathUtils::mean(v_control),
-                settings.max_scaling_factor
-            );
-            for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-                v_output[ts] = v_reference[ts] * adjusted_scaling_factor;  // Eq. 2
-
-        } else
-            throw std::runtime_error("Unknown Adjustment kind" + settings.kind + " for Delta Method.");
-
-    } else {
-        std::vector<float>
-            contr_365_means,
-            scen_365_means;
-
-        std::vector<std::vector<float>>
-            contr_long_term_dayofyear = get_long_term_dayofyear(v_control),
-            scen_long_term_dayofyear = get_long_term_dayofyear(v_scenario);
-
-        // ? compute 365 means based on long-term 31-day moving windows
-        for (unsigned day = 0; day < 365; day++) {
-            contr_365_means.push_back(MathUtils::mean(contr_long_term_dayofyear[day]));
-            scen_365_means.push_back(MathUtils::mean(scen_long_term_dayofyear[day]));
-        }
-
-        if (settings.kind == "add" || settings.kind == "+") {
-            for (unsigned ts = 0; ts < v_reference.size(); ts++)
-                v_output[ts] = v_reference[ts] + (scen_365_means[ts % 365] - contr_365_means[ts % 365]);  // Eq. 1
-
-        } else if (settings.kind == "mult" || settings.kind == "*") {
-            std::vector<float> adj_scaling_factors;
-            for (unsigned day = 0; day < 365; day++)
-                adj_scaling_factors.push_back(
-                    MathUtils::ensure_devidable(
-                        scen_365_means[day], contr_365_means[day],
-                        settings.max_scaling_factor
-                    )
-                );
+    scale_by_means<kind, interval31_scaling>(
+        Slab(v_output.data(), 1, v_reference.size(), SlabLayout::CellTime),
+        Slab(v_scenario.data(), 1, v_scenario.size(), SlabLayout::CellTime),
+        Slab(v_control.data(), 1, v_control.size(), SlabLayout::CellTime),
+        Slab(v_reference.data(), 1, v_reference.size(), SlabLayout::CellTime),
+        settings.scenario_dayofyear,
+        settings.control_dayofyear,
+        settings.reference_dayofyear,
+        settings,
+        workspace
+    );  // Eq. 1 resp. Eq. 2
+    workspace.status = workspace.v_cell_status[0];
+}
 
-            for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-                v_output[ts] = v_reference[ts] * adj_scaling_factors[ts % 365];  // Eq. 2
+/**
+ * Delta Method (see `delta_method`) using the kernel that is specialized for
+ * `settings.kind` and `settings.interval31_scaling`
+ */
+void CMethods::Delta_Method(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings
+) {
+    CMethodsWorkspace workspace;
+    Delta_Method(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
 
-        } else
-            throw std::runtime_error("Unknown Adjustment kind" + settings.kind + " for Delta Method.");
-    }
+/**
+ * Delta Method (see `delta_method`) using the kernel that is specialized for
+ * `settings.kind` and `settings.interval31_scaling`
+ * and the buffers of `workspace`
+ */
+void CMethods::Delta_Method(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    get_adjustment_function(
+        AdjustmentMethod::DeltaMethod, settings.kind, settings.interval31_scaling
+    )(v_output, v_reference, v_control, v_scenario, settings, workspace);
 }
 
 /**
- * Helper function used in `get_xbins`
- *
- * It takes two float values and returns a bool indicating whether the first
- * value is considered smaller than the second.
- * example:
- *     a_max = *std::max_element(a.begin(), a.end(), is_smaller),
+ * Determines the minimum and maximum of the values of `v_in` that are not
+ * NaN, both are NaN if there is no such value
  *
- * @param a some value
- * @param b what a wonder... another value to compare to
- *
- * … will return the maximum value without failing if any value is NaN
+ * @param v_in 1D time series
+ * @param min output: minimum
+ * @param max output: maximum
  */
-bool is_smaller(double a, double b) {
-    if (std::isnan(a))
-        return false;  // a is NaN, consider it as larger
-    if (std::isnan(b))
-        return true;  // b is NaN, consider a as smaller
-    return a < b;     // neither a nor b is NaN, compare normally
+static void get_range(const std::vector<float>& v_in, double& min, double& max) {
+    float v_min = std::numeric_limits<float>::infinity(), v_max = -v_min;
+    bool is_empty = true;
+    for (float x : v_in) {
+        if (std::isnan(x)) continue;
+        v_min = std::min(v_min, x);
+        v_max = std::max(v_max, x);
+        is_empty = false;
+    }
+    min = is_empty ? std::numeric_limits<double>::quiet_NaN() : v_min;
+    max = is_empty ? std::numeric_limits<double>::quiet_NaN() : v_max;
 }
 
 /**
- * Helper function used in `get_xbins`
+ * Computes the probability boundaries (see `compute_xbins` below) based on
+ * the minimum and maximum values of two time series
  *
- * It takes two float values and returns a bool indicating whether the first
- * value is considered larger than the second.
- * example:
- *     a_max = *std::min_element(a.begin(), a.end(), is_larger),
- *
- * @param a some value
- * @param b what a wonder... another value to compare to
- *
- * … will return the minimum value without failing if any value is NaN.
+ * @param a_min minimum of the first time series (not used for multiplicative)
+ * @param a_max maximum of the first time series
+ * @param b_min minimum of the second time series (not used for multiplicative)
+ * @param b_max maximum of the second time series
+ * @param n_quantiles number of quantiles to use/respect
+ * @param v_xbins output vector for the probability boundaries
+ * @return `CellStatus::Ok` or the reason why the boundaries can't be determined
  */
-bool is_larger(double a, double b) {
-    if (std::isnan(a))
-        return true;
-    if (std::isnan(b))
-        return false;
-    return a < b;
+template <AdjustmentKind kind>
+static CellStatus compute_xbins_of_range(
+    double a_min,
+    double a_max,
+    double b_min,
+    double b_max,
+    unsigned n_quantiles,
+    std::vector<double>& v_xbins
+) {
+    if constexpr (kind == AdjustmentKind::Additive) {
+        // check if probability boundaries can be determined
+        if (std::isnan(a_max) || std::isnan(b_max) || std::isnan(a_min) || std::isnan(b_min))
+            return CellStatus::AllMissing;
+        if (a_max == b_max || a_min == b_min)
+            return CellStatus::Constant;
+
+        const double
+            global_max = std::max(a_max, b_max),
+            global_min = std::min(a_min, b_min);
+        const double wide = std::abs(global_max - global_min) / n_quantiles;
+
+        v_xbins.clear();
+        v_xbins.push_back((double)global_min);
+        while (v_xbins[v_xbins.size() - 1] < global_max)
+            v_xbins.push_back(v_xbins[v_xbins.size() - 1] + wide);
+
+    } else {
+        // check if probability boundaries can be determined
+        if (std::isnan(a_max) || std::isnan(b_max))
+            return CellStatus::AllMissing;
+        if (a_max == b_max)
+            return CellStatus::Constant;
+
+        const double global_max = std::max(a_max, b_max);
+        const double wide = global_max / n_quantiles;
+
+        v_xbins.clear();
+        v_xbins.push_back((double)0);
+        while (v_xbins[v_xbins.size() - 1] < global_max)
+            v_xbins.push_back(v_xbins[v_xbins.size() - 1] + wide);
+    }
+    return CellStatus::Ok;
 }
 
 /**
@@ -489,10 +1576,40 @@ bool is_larger(double a, double b) {
  * @param a time series
  * @param b another time series
  * @param n_quantiles number of quantiles to use/respect
+ * @param v_xbins output vector for the probability boundaries mentioned above
+ * @tparam kind additive (regular) or multiplicative (bounded): defines if
+ *              minimum value of a (climate) variable can be lower than in the
+ *              data or is set to 0 (ratio based variables => 0)
+ * @return `CellStatus::Ok` or the reason why the boundaries can't be determined
+ */
+template <AdjustmentKind kind>
+static CellStatus compute_xbins(
+    std::vector<float>& a,
+    std::vector<float>& b,
+    unsigned n_quantiles,
+    std::vector<double>& v_xbins
+) {
+    double a_min, a_max, b_min, b_max;
+    get_range(a, a_min, a_max);
+    get_range(b, b_min, b_max);
+    if constexpr (kind == AdjustmentKind::Additive)
+        return compute_xbins_of_range<kind>(a_min, a_max, b_min, b_max, n_quantiles, v_xbins);
+    else
+        return compute_xbins_of_range<kind>(0, a_max, 0, b_max, n_quantiles, v_xbins);
+}
+
+/**
+ * Returns the probability boundaries based on two input time series
+ * (see `compute_xbins` above)
+ *
+ * @param a time series
+ * @param b another time series
+ * @param n_quantiles number of quantiles to use/respect
  * @param kind regular or bounded: defines if minimum value of a (climate)
  *             variable can be lower than in the data
  *             or is set to 0 (ratio based variables => 0)
  * @return the probability boundaries mentioned above
+ * @throws utils::NaNException if the boundaries can't be determined
  */
 std::vector<double> CMethods::get_xbins(
     std::vector<float>& a,
@@ -500,241 +1617,1838 @@ std::vector<double> CMethods::get_xbins(
     unsigned n_quantiles,
     std::string kind
 ) {
-    if (kind == "regular") {
-        const double
-            a_max = *std::max_element(a.begin(), a.end(), is_smaller),
-            a_min = *std::min_element(a.begin(), a.end(), is_larger),
-            b_max = *std::max_element(b.begin(), b.end(), is_smaller),
-            b_min = *std::min_element(b.begin(), b.end(), is_larger);
+    std::vector<double> v_xbins(0);
+    CellStatus status;
+    if (kind == "regular")
+        status = compute_xbins<AdjustmentKind::Additive>(a, b, n_quantiles, v_xbins);
+    else if (kind == "bounded")
+        status = compute_xbins<AdjustmentKind::Multiplicative>(a, b, n_quantiles, v_xbins);
+    else
+        throw std::runtime_error("Unknown kind " + kind + " for get_xbins-function.");
+    if (status != CellStatus::Ok) throw utils::NaNException();
+    return v_xbins;
+}
 
-        // check if probability boundaries can be determined
-        // clang-format off
-        if (
-               std::isnan(a_max) || std::isnan(b_max)
-            || std::isnan(a_min) || std::isnan(b_min)
-            || a_max == b_max    || a_min == b_min
-        )
-            throw utils::NaNException();
-         // clang-format off
+/**
+ * Copies the values of `v_in` that are not nan into `v_sorted` and sorts
+ * them, i.e. computes the order statistics of `v_in`
+ *
+ * @param v_in 1D time series
+ * @param v_sorted output vector containing the sorted values
+ */
+static void get_order_statistics(std::vector<float>& v_in, std::vector<double>& v_sorted) {
+    v_sorted.clear();
+    v_sorted.reserve(v_in.size());
+    for (unsigned ts = 0; ts < v_in.size(); ts++)
+        if (!std::isnan(v_in[ts])) v_sorted.push_back(v_in[ts]);
+    std::sort(v_sorted.begin(), v_sorted.end());
+}
 
-        const double
-            global_max = std::max(a_max, b_max),
-            global_min = std::min(a_min, b_min);
-        const double wide = std::abs(global_max - global_min) / n_quantiles;
+/**
+ * Computes the indices of the values of `v_in` that are not nan,
+ * ordered ascending by their values
+ *
+ * @param v_in 1D time series
+ * @param v_pairs scratch space for the values and their indices
+ * @param v_indices output vector containing the sorted indices
+ */
+static void get_sorted_indices(
+    std::vector<float>& v_in,
+    std::vector<std::pair<float, unsigned>>& v_pairs,
+    std::vector<unsigned>& v_indices
+) {
+    // sorting the values together with their indices avoids the indirection
+    v_pairs.clear();
+    for (unsigned ts = 0; ts < v_in.size(); ts++)
+        if (!std::isnan(v_in[ts])) v_pairs.push_back({v_in[ts], ts});
+    std::sort(v_pairs.begin(), v_pairs.end());
+
+    v_indices.resize(v_pairs.size());
+    for (unsigned k = 0; k < v_pairs.size(); k++)
+        v_indices[k] = v_pairs[k].second;
+}
 
-        std::vector<double> v_xbins(0);
-        v_xbins.push_back((double)global_min);
-        while (v_xbins[v_xbins.size() - 1] < global_max)
-            v_xbins.push_back(v_xbins[v_xbins.size() - 1] + wide);
-        return v_xbins;
+/**
+ * Returns the empirical CDF of the order statistics `v_sorted` at `x`,
+ * linearly interpolated between the positions of the order statistics.
+ * Repeated values are mapped to their lowest position, like in
+ * `MathUtils::interpolate`.
+ *
+ * Since `i` is only moved forward, evaluating the CDF for ascending `x`
+ * is a single sweep over `v_sorted`.
+ *
+ * @param v_sorted at least two sorted values
+ * @param x value to get the probability for
+ * @param i left end of the interval found for the previous (smaller) `x`,
+ *          start with 0
+ * @return the probability of `x`
+ */
+template <bool extrapolate>
+static double get_empirical_probability(const std::vector<double>& v_sorted, double x, size_t& i) {
+    const size_t n = v_sorted.size();
+    while (i < n - 2 && x > v_sorted[i + 1]) i++;
+
+    const double width = v_sorted[i + 1] - v_sorted[i];
+    double position = i + ((width > 0) ? (x - v_sorted[i]) / width : 0);
+    if constexpr (!extrapolate)
+        position = std::min(std::max(position, 0.0), (double)(n - 1));
+    return position / (n - 1);
+}
 
-    } else if (kind == "bounded") {
-        const double
-            a_max = *std::max_element(std::begin(a), std::end(a), is_smaller),
-            b_max = *std::max_element(std::begin(b), std::end(b), is_smaller);
+/**
+ * Returns the empirical quantile of the order statistics `v_sorted` for
+ * the probability `p`, linearly interpolated between the order statistics
+ *
+ * @param v_sorted at least two sorted values
+ * @param p probability
+ * @return the quantile of `p`
+ */
+template <bool extrapolate>
+static double get_empirical_quantile(const std::vector<double>& v_sorted, double p) {
+    const size_t n = v_sorted.size();
+    double position = p * (n - 1);
+    if constexpr (!extrapolate)
+        position = std::min(std::max(position, 0.0), (double)(n - 1));
+
+    const size_t i = (size_t)std::min(std::max(std::floor(position), 0.0), (double)(n - 2));
+    return v_sorted[i] + (position - i) * (v_sorted[i + 1] - v_sorted[i]);
+}
 
-        // check if probability boundaries can be determined
-        if (std::isnan(a_max) or std::isnan(b_max) || a_max == b_max)
-            throw utils::NaNException();
+/**
+ * Computes the probability boundaries and CDFs of the reference and control
+ * period like `CDFMethod::Histogram` (see `fit_distributions` below), but
+ * based on quantile sketches, so the time series do not have to be kept in
+ * memory. The CDF at a boundary is the (estimated) number of values that are
+ * smaller, like the cumulative counts of the histograms, the minimum and
+ * maximum and thus the boundaries are exact.
+ *
+ * @param reference sketch of the reference time series (control period)
+ * @param control sketch of the modeled time series (control period)
+ * @param settings adjustment settings (uses `n_quantiles`)
+ * @param workspace buffers to store the distributions in
+ * @return `CellStatus::Ok` or the reason why the distributions can't be
+ *         determined, e.g. because a sketch is empty
+ */
+template <AdjustmentKind kind>
+static CellStatus fit_sketch_distributions(
+    const QuantileSketch& reference,
+    const QuantileSketch& control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    std::vector<double>& v_xbins = workspace.v_xbins;
+    const CellStatus status = compute_xbins_of_range<kind>(
+        reference.get_min(), reference.get_max(), control.get_min(), control.get_max(),
+        settings.n_quantiles, v_xbins
+    );
+    if (status != CellStatus::Ok) return status;
+
+    // values beyond the last boundary are counted in the last bin
+    auto get_cdf = [&v_xbins](const QuantileSketch& sketch, std::vector<double>& v_cdf) {
+        const size_t n_bins = v_xbins.size();
+        v_cdf.resize(n_bins);
+        v_cdf[0] = 0;
+        for (size_t i = 1; i < n_bins - 1; i++) v_cdf[i] = sketch.get_rank(v_xbins[i]);
+        v_cdf[n_bins - 1] = (double)sketch.get_n();
+    };
+    get_cdf(reference, workspace.v_reference_cdf);
+    get_cdf(control, workspace.v_control_cdf);
+    return CellStatus::Ok;
+}
 
-        const double global_max = std::max(a_max, b_max);
-        const double wide = global_max / n_quantiles;
+/**
+ * Computes the distributions of the reference and control time series
+ * that QM and QDM are based on and stores them in `workspace`, i.e. the
+ * probability boundaries and CDFs (`CDFMethod::Histogram` and
+ * `CDFMethod::Sketch`) or the order statistics (`CDFMethod::Exact`). They don't depend on the scenario, so
+ * they can be fitted once and applied to any number of scenarios.
+ *
+ * @param v_reference 1D reference time series (control period)
+ * @param v_control 1D modeled time series (control period)
+ * @param settings adjustment settings (uses `n_quantiles` and `cdf_method`)
+ * @param workspace buffers to store the distributions in
+ * @return `CellStatus::Ok` or the reason why the distributions can't be
+ *         determined, e.g. because a time series only consists of nan values
+ */
+template <AdjustmentKind kind>
+static CellStatus fit_distributions(
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (settings.cdf_method == CDFMethod::Exact) {
+        // ? the reference is sorted by a task of its own if more than one thread may be used
+        if (get_n_chunks(settings.n_threads, v_reference.size() + v_control.size(), 2 * min_time_chunk) > 1) {
+            std::future<void> task = std::async(std::launch::async, get_order_statistics, std::ref(v_reference), std::ref(workspace.v_reference_sorted));
+            get_order_statistics(v_control, workspace.v_control_sorted);
+            task.get();
+        } else {
+            get_order_statistics(v_reference, workspace.v_reference_sorted);
+            get_order_statistics(v_control, workspace.v_control_sorted);
+        }
+        const size_t n_min = std::min(workspace.v_reference_sorted.size(), workspace.v_control_sorted.size());
+        return (n_min == 0) ? CellStatus::AllMissing : (n_min < 2) ? CellStatus::Constant : CellStatus::Ok;
+    }
 
-        std::vector<double> v_xbins(0);
-        v_xbins.push_back((double)0);
-        while (v_xbins[v_xbins.size() - 1] < global_max)
-            v_xbins.push_back(v_xbins[v_xbins.size() - 1] + wide);
-        return v_xbins;
+    if (settings.cdf_method == CDFMethod::Sketch) {
+        const unsigned k = QuantileSketch::get_k(settings.sketch_error);
+        workspace.reference_sketch.reset(k);
+        workspace.reference_sketch.update(v_reference);
+        workspace.control_sketch.reset(k);
+        workspace.control_sketch.update(v_control);
+        return fit_sketch_distributions<kind>(workspace.reference_sketch, workspace.control_sketch, settings, workspace);
+    }
 
-    } else {
-        throw std::runtime_error("Unknown kind " + kind + " for get_xbins-function.");
-        return std::vector<double>(0);  // just to avoid warnings ...
+    const CellStatus status = compute_xbins<kind>(v_reference, v_control, settings.n_quantiles, workspace.v_xbins);
+    if (status != CellStatus::Ok) return status;
+    get_chunked_cdf(v_reference, workspace.v_xbins, workspace.v_reference_cdf, settings.n_threads, workspace.v_chunk_cdfs);
+    get_chunked_cdf(v_control, workspace.v_xbins, workspace.v_control_cdf, settings.n_threads, workspace.v_chunk_cdfs);
+    return CellStatus::Ok;
+}
+
+/**
+ * Returns the value of the reference period that QM maps a value with the
+ * probability `p` within the control period to (Eq. 1 resp. 2 of
+ * `quantile_mapping`), based on the order statistics
+ *
+ * @param ref_sorted order statistics of the reference period
+ * @param p probability
+ * @return the adjusted value
+ */
+template <AdjustmentKind kind>
+static inline float get_mapped_quantile(const std::vector<double>& ref_sorted, double p) {
+    if constexpr (kind == AdjustmentKind::Additive)
+        return (float)get_empirical_quantile<false>(ref_sorted, p);  // Eq. 1
+    else {
+        const float y = (float)get_empirical_quantile<true>(ref_sorted, (p >= 0) ? p : 0);  // Eq. 2
+        return (y >= 0) ? y : 0;
     }
 }
 
 /**
- * Quantile Mapping bias correction based on
- * Tong, Y., Gao, X., Han, Z. et al. Bias correction of temperature and
- * precipitation over China for RCM simulations using the QM and QDM methods.
- * Clim Dyn 57, 1425–1443 (2021). https://doi.org/10.1007/s00382-020-05447-4
+ * Quantile Mapping based on the exact empirical CDFs instead of
+ * histograms (see `quantile_mapping` below). The reference and control
+ * time series have been sorted by `fit_distributions`, the scenario
+ * values are mapped in ascending order, so no bins are needed and the
+ * costs are O(n log n). Nan values in the scenario time series stay nan.
  *
  * @param v_output 1D output vector that stores the adjusted time series
- * @param v_reference 1D reference time series (control period)
- * @param v_control 1D modeled time series (control period)
  * @param v_scenario 1D time series to adjust (scenario period)
- * @param settings struct with attributes:
- *      double max_scaling_factor,
- *      unsigned n_quantiles,
- *      bool interval31_scaling,
- *      std::string kind
- *
- * (add):
- *      (1.) $T^{*QM}_{sim,p}(d) = F^{-1}_{obs,h} \left\{F_{sim,h}\left[T_{sim,p}(d)\right]\right\}$
- * (mult):
- *      same but with bounded values => 0 is the minimum value
+ * @param settings adjustment settings (uses `n_threads`)
+ * @param workspace order statistics of the reference and control period
  */
-void CMethods::Quantile_Mapping(
+template <AdjustmentKind kind>
+static void map_quantiles_exact(
     std::vector<float>& v_output,
-    std::vector<float>& v_reference,
-    std::vector<float>& v_control,
     std::vector<float>& v_scenario,
-    AdjustmentSettings& settings
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
 ) {
-    const bool isAdd = (settings.kind == "add" || settings.kind == "+") ? true : false;
-    if (!isAdd && !(settings.kind == "mult" || settings.kind == "*"))
-        throw("Adjustment kind " + settings.kind + " unknown for quantile mapping!");
-
-    // -------------------------------------------------------------------------
-    // If the xbins / probability boundaries can't be determined, because
-    // at least one of the time series only consists of nan values
-    // just return the uncorrected scenario time series.
-
-    std::vector<double> v_xbins;
-    try {
-        v_xbins = get_xbins(
-            v_reference,
-            v_control,
-            settings.n_quantiles,
-            (isAdd) ? "regular" : "bounded"
-        );
-    } catch (const utils::NaNException& e) {
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            v_output[ts] = v_scenario[ts];
-        return;
-    }
+    const std::vector<double>
+        &ref_sorted = workspace.v_reference_sorted,
+        &contr_sorted = workspace.v_control_sorted;
 
-    // -------------------------------------------------------------------------
+    std::vector<unsigned>& scen_order = workspace.v_scenario_order;
+    get_sorted_indices(v_scenario, workspace.v_pairs, scen_order);
+    for (unsigned ts = 0; ts < v_scenario.size(); ts++)
+        if (std::isnan(v_scenario[ts])) v_output[ts] = v_scenario[ts];
+
+    // ? every chunk of the ascending values is mapped in a sweep of its own
+    constexpr bool extrapolate = (kind == AdjustmentKind::Multiplicative);
+    const unsigned n_chunks = get_n_chunks(settings.n_threads, scen_order.size(), min_time_chunk);
+    for_each_chunk(n_chunks, scen_order.size(), [&](size_t first, size_t last, unsigned) {
+        size_t i = 0;
+        for (size_t k = first; k < last; k++) {
+            const unsigned ts = scen_order[k];
+            const double p = get_empirical_probability<extrapolate>(contr_sorted, v_scenario[ts], i);
+            v_output[ts] = get_mapped_quantile<kind>(ref_sorted, p);
+        }
+    });
+}
 
-    std::vector<int>  // ? create CDFs
-        vi_ref_cdf = MathUtils::get_cdf(v_reference, v_xbins),
-        vi_contr_cdf = MathUtils::get_cdf(v_control, v_xbins);
+/**
+ * Returns the value of the reference period that QDM maps a scenario value
+ * `x` with the probability `epsilon` to (Eq. 1.2ff. resp. 2.2ff. of
+ * `quantile_delta_mapping`), based on the order statistics
+ *
+ * @param x scenario value
+ * @param epsilon probability of `x` within the scenario period
+ * @param ref_sorted order statistics of the reference period
+ * @param contr_sorted order statistics of the control period
+ * @param settings adjustment settings (uses `max_scaling_factor`)
+ * @return the adjusted value
+ */
+template <AdjustmentKind kind>
+static inline float get_mapped_quantile_delta(
+    double x,
+    double epsilon,
+    const std::vector<double>& ref_sorted,
+    const std::vector<double>& contr_sorted,
+    AdjustmentSettings& settings
+) {
+    const double
+        QDM1 = get_empirical_quantile<false>(ref_sorted, epsilon),  // Eq. 1.2
+        contr_value = get_empirical_quantile<false>(contr_sorted, epsilon);
+
+    if constexpr (kind == AdjustmentKind::Additive)
+        return (float)(QDM1 + x - contr_value);  // Eq. 1.3f.
+    else
+        return QDM1 * MathUtils::ensure_devidable(x, contr_value, settings.max_scaling_factor);  // Eq. 2.3f.
+}
 
-    std::vector<double>  // ? change CDF values to type double
-        ref_cdf(vi_ref_cdf.begin(), vi_ref_cdf.end()),
-        contr_cdf(vi_contr_cdf.begin(), vi_contr_cdf.end());
+/**
+ * Quantile Delta Mapping based on the exact empirical CDFs instead of
+ * histograms (see `quantile_delta_mapping` below). The probabilities of
+ * the scenario values are their (lowest) positions within the sorted
+ * scenario time series. Nan values in the scenario time series stay nan.
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings (uses `max_scaling_factor`)
+ * @param workspace order statistics of the reference and control period
+ */
+template <AdjustmentKind kind>
+static void map_quantile_deltas_exact(
+    std::vector<float>& v_output,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    const std::vector<double>
+        &ref_sorted = workspace.v_reference_sorted,
+        &contr_sorted = workspace.v_control_sorted;
 
-    std::vector<double> cdf_values;
-    if (isAdd) {
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            cdf_values.push_back(
-                MathUtils::interpolate(v_xbins, contr_cdf, (double)v_scenario[ts], false)
-            );  // Eq. 1
+    std::vector<unsigned>& scen_order = workspace.v_scenario_order;
+    get_sorted_indices(v_scenario, workspace.v_pairs, scen_order);
 
-        // ? Invert in invers CDF and return
+    // ? the CDF of the scenario can't be determined - return the uncorrected time series
+    if (scen_order.size() < 2) {
         for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            v_output[ts] = (float)MathUtils::interpolate(ref_cdf, v_xbins, cdf_values[ts], false);  // Eq. 1
+            v_output[ts] = v_scenario[ts];
+        workspace.status = scen_order.empty() ? CellStatus::AllMissing : CellStatus::Constant;
+        return;
+    }
 
-    } else {
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++) {
-            double y = MathUtils::interpolate(v_xbins, contr_cdf, (double)v_scenario[ts], true);  // Eq. 2
-            cdf_values.push_back((y >= 0) ? y : 0);
+    for (unsigned ts = 0; ts < v_scenario.size(); ts++)
+        if (std::isnan(v_scenario[ts])) v_output[ts] = v_scenario[ts];
+
+    // ? every chunk of the ascending values is mapped in a sweep of its own
+    const double n_scen = scen_order.size();
+    const unsigned n_chunks = get_n_chunks(settings.n_threads, scen_order.size(), min_time_chunk);
+    for_each_chunk(n_chunks, scen_order.size(), [&](size_t chunk_first, size_t chunk_last, unsigned) {
+        size_t first = chunk_first;  // lowest position of the current value
+        while (first > 0 && v_scenario[scen_order[first - 1]] == v_scenario[scen_order[chunk_first]]) first--;
+        for (size_t k = chunk_first; k < chunk_last; k++) {
+            const unsigned ts = scen_order[k];
+            if (k > chunk_first && v_scenario[ts] > v_scenario[scen_order[k - 1]]) first = k;
+
+            const double epsilon = first / (n_scen - 1);  // Eq. 1.1
+            v_output[ts] = get_mapped_quantile_delta<kind>(v_scenario[ts], epsilon, ref_sorted, contr_sorted, settings);
         }
+    });
+}
 
-        // ? Invert in invers CDF and return
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++) {
-            float y = (float)MathUtils::interpolate(ref_cdf, v_xbins, cdf_values[ts], true);  // Eq. 2
-            v_output[ts] = (y >= 0) ? y : 0;
-        }
+/**
+ * Returns the ranges of the time steps of the long-term 31-day interval
+ * around `day`, one range per year, empty if a year does not contain `day`
+ *
+ * @param index day-of-year index of the time series (may be NULL)
+ * @param n_time length of the time series
+ * @param day day of the year
+ * @param v_ranges output vector of the [start, end) ranges
+ */
+static void get_interval31_ranges(
+    const DayOfYearIndex* index,
+    size_t n_time,
+    long day,
+    std::vector<std::pair<size_t, size_t>>& v_ranges
+) {
+    const long n_years = get_n_years(index, n_time);
+    v_ranges.resize(n_years);
+    for (long year = 0; year < n_years; year++) {
+        const long center = get_center(index, year, day);
+        if (center < 0)
+            v_ranges[year] = std::make_pair((size_t)0, (size_t)0);
+        else
+            v_ranges[year] = std::make_pair((size_t)std::max(0L, center - 15), (size_t)std::min((long)n_time, center + 16));
     }
 }
 
 /**
- * Quantile Delta Mapping bias correction based on
- * Tong, Y., Gao, X., Han, Z. et al. Bias correction of temperature and
- * precipitation over China for RCM simulations using the QM and QDM methods.
- * Clim Dyn 57, 1425–1443 (2021). https://doi.org/10.1007/s00382-020-05447-4
+ * Quantile Mapping resp. Quantile Delta Mapping (`delta_mapping`) where
+ * every time step of the scenario is mapped based on the exact empirical
+ * CDFs of the long-term 31-day intervals around its day of the year, i.e.
+ * the +-15 days of all years (see `get_long_term_dayofyear`). The sorted
+ * windows are moved from one day to the next (see `SortedWindow`), so the
+ * costs stay close to sorting every time series once instead of sorting
+ * 365 windows. The time series either have day-of-year indices (`settings`)
+ * or consist of complete years with 365 days each. Nan values are ignored by
+ * the windows and stay nan, days without at least two values in every
+ * window are not adjusted (`CellStatus::Fallback`).
  *
  * @param v_output 1D output vector that stores the adjusted time series
  * @param v_reference 1D reference time series (control period)
  * @param v_control 1D modeled time series (control period)
  * @param v_scenario 1D time series to adjust (scenario period)
- * @param settings struct with attributes:
- *      double max_scaling_factor,
- *      unsigned n_quantiles,
- *      bool interval31_scaling,
- *      std::string kind
- *
- * Add (+):
- *  (1.1) $\varepsilon(t) = F^{(t)}_{sim,p}\left[T_{sim,p}(t)\right]$
- *  (1.2) $\T^{*1QDM}_{sim,p}(t) = F^{-1}_{obs,h}\left[\varepsilon(t)\right]$
- *  (1.3) $\Delta(t) = F^{-1}_{sim,p}(t)\left[\varepsilon(t)\right] = T_{sim,p}(t)-F^{-1}_{sim,h} \left\{F^{}_{sim,p}(t)\left[T_{sim,p}(t)\right]\right\}$
- *  (1.4) $T^{*QDM}_{sim,p}(t) = T^{*1QDM}_{sim,p}(t) + \Delta(t)$
- *
- * Mult (*):
- *   (2.1) --//-- (same as 1.1)
- *   (2.2) --//-- (same as 1.2)
- *   (2.3) \Delta(i) & = \frac{F^{-1}_{sim,p}\left[\varepsilon(i)\right] }{ F^{-1}_{sim,h}\left[\varepsilon(i)\right] } \\
- *                   & = \frac{X_{sim,p}(i) }{ F^{-1}_{sim,h}\left\{F^{}_{sim,p}\left[X_{sim,p}(i)\right]\right\} }
- *   (2.4) X^{*QDM}_{sim,p}(i) = X^{QDM(1)}_{sim,p}(i) \cdot \Delta(i)
+ * @param settings adjustment settings
+ * @param workspace buffers for the windows
  */
-void CMethods::Quantile_Delta_Mapping(
+template <AdjustmentKind kind, bool delta_mapping>
+static void map_interval31(
     std::vector<float>& v_output,
     std::vector<float>& v_reference,
     std::vector<float>& v_control,
     std::vector<float>& v_scenario,
-    AdjustmentSettings& settings
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
 ) {
-    const bool isAdd = (settings.kind == "add" || settings.kind == "+") ? true : false;
+    const DayOfYearIndex
+        *ref_index = get_dayofyear_index(settings.reference_dayofyear, v_reference.size()),
+        *contr_index = get_dayofyear_index(settings.control_dayofyear, v_control.size()),
+        *scen_index = get_dayofyear_index(settings.scenario_dayofyear, v_scenario.size(), delta_mapping);
+
+    // ? sort the time steps of the scenario by their day of the year (counting sort)
+    const size_t n_scen = v_scenario.size();
+    std::vector<size_t>
+        &v_time_steps = workspace.v_dayofyear_time_steps,
+        &v_offsets = workspace.v_dayofyear_offsets;
+    v_time_steps.resize(n_scen);
+    v_offsets.assign(366, 0);
+    for (size_t ts = 0; ts < n_scen; ts++) v_offsets[get_day(scen_index, ts) + 1]++;
+    for (unsigned day = 0; day < 365; day++) v_offsets[day + 1] += v_offsets[day];
+    for (size_t ts = 0; ts < n_scen; ts++) v_time_steps[v_offsets[get_day(scen_index, ts)]++] = ts;
+    for (unsigned day = 365; day > 0; day--) v_offsets[day] = v_offsets[day - 1];
+    v_offsets[0] = 0;
+
+    // ? the days of the year are split into ranges whose windows are moved by tasks of their own
+    const unsigned n_chunks = get_n_chunks(settings.n_threads, n_scen, min_time_chunk);
+    std::vector<Interval31Buffers>& v_buffers = workspace.v_interval31_buffers;
+    if (v_buffers.size() < n_chunks) v_buffers.resize(n_chunks);
+
+    constexpr bool extrapolate = (kind == AdjustmentKind::Multiplicative);
+    for_each_chunk(n_chunks, 365, [&](size_t first_day, size_t last_day, unsigned chunk) {
+        Interval31Buffers& buffers = v_buffers[chunk];
+        SortedWindow
+            &ref_window = buffers.reference_window,
+            &contr_window = buffers.control_window,
+            &scen_window = buffers.scenario_window;
+        ref_window.clear();
+        contr_window.clear();
+        scen_window.clear();
+        std::vector<std::pair<size_t, size_t>>& v_ranges = buffers.v_ranges;
+        std::vector<std::pair<float, unsigned>>& v_pairs = buffers.v_pairs;
+        buffers.n_days = buffers.n_skipped = 0;
+
+        for (long day = (long)first_day; day < (long)last_day; day++) {
+            get_interval31_ranges(ref_index, v_reference.size(), day, v_ranges);
+            ref_window.move(v_reference, v_ranges);
+            get_interval31_ranges(contr_index, v_control.size(), day, v_ranges);
+            contr_window.move(v_control, v_ranges);
+            if constexpr (delta_mapping) {
+                get_interval31_ranges(scen_index, n_scen, day, v_ranges);
+                scen_window.move(v_scenario, v_ranges);
+            }
 
-    if (!isAdd && !(settings.kind == "mult" || settings.kind == "*"))
-        throw std::runtime_error("Adjustment kind " + settings.kind + " unknown for quantile delta mapping!");
+            // ? the values of the day in ascending order, so the CDFs are evaluated in one sweep
+            v_pairs.clear();
+            for (size_t k = v_offsets[day]; k < v_offsets[day + 1]; k++) {
+                const size_t ts = v_time_steps[k];
+                if (std::isnan(v_scenario[ts]))
+                    v_output[ts] = v_scenario[ts];
+                else
+                    v_pairs.push_back({v_scenario[ts], (unsigned)ts});
+            }
+            std::sort(v_pairs.begin(), v_pairs.end());
+
+            const std::vector<double>
+                &ref_sorted = ref_window.v_sorted,
+                &contr_sorted = contr_window.v_sorted,
+                &scen_sorted = scen_window.v_sorted;
+            if (!v_pairs.empty()) buffers.n_days++;
+            if (ref_sorted.size() < 2 || contr_sorted.size() < 2 || (delta_mapping && scen_sorted.size() < 2)) {
+                for (const std::pair<float, unsigned>& pair : v_pairs) v_output[pair.second] = pair.first;
+                if (!v_pairs.empty()) buffers.n_skipped++;
+                continue;
+            }
 
-    // -------------------------------------------------------------------------
-    // If the xbins / probability boundaries can't be determined, because
-    // at least one of the time series only consists of nan values
-    // just return the uncorrected scenario time series.
-
-    std::vector<double> v_xbins;
-    try {
-        v_xbins = get_xbins(
-            v_reference,
-            v_control,
-            settings.n_quantiles,
-            (isAdd) ? "regular" : "bounded"
-        );
-    } catch (const utils::NaNException& e) {
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            v_output[ts] = v_scenario[ts];
-        return;
-    }
+            size_t i = 0;
+            for (const std::pair<float, unsigned>& pair : v_pairs) {
+                if constexpr (delta_mapping) {
+                    const double epsilon = get_empirical_probability<false>(scen_sorted, pair.first, i);  // Eq. 1.1
+                    v_output[pair.second] = get_mapped_quantile_delta<kind>(pair.first, epsilon, ref_sorted, contr_sorted, settings);
+                } else {
+                    const double p = get_empirical_probability<extrapolate>(contr_sorted, pair.first, i);
+                    v_output[pair.second] = get_mapped_quantile<kind>(ref_sorted, p);
+                }
+            }
+        }
+    });
 
-    // -------------------------------------------------------------------------
+    unsigned n_days = 0, n_skipped = 0;
+    for (unsigned chunk = 0; chunk < n_chunks; chunk++) {
+        n_days += v_buffers[chunk].n_days;
+        n_skipped += v_buffers[chunk].n_skipped;
+    }
+    workspace.status = (n_skipped == 0)        ? CellStatus::Ok
+                       : (n_skipped == n_days) ? CellStatus::AllMissing
+                                               : CellStatus::Fallback;
+}
+
+/**
+ * Even grid that refines the xbins by `resolution` points per bin. The
+ * transfer functions of QM and QDM are piecewise linear, so they can be
+ * tabulated on this grid once per cell and interpolated by a single index
+ * computation and lerp instead of searching the CDFs for every value.
+ * Values outside of the xbins must be passed to the exact transfer function,
+ * so that the extrapolation is not affected by the table.
+ */
+class TransferTable {
+   public:
+    TransferTable(const std::vector<double>& v_xbins, unsigned resolution)
+        : x0(v_xbins.front()),
+          x1(v_xbins.back()),
+          n_intervals((v_xbins.size() - 1) * resolution) {
+        inverse_step = (x1 > x0) ? n_intervals / (x1 - x0) : 0;
+    };
+
+    /**
+     * Stores the (increasing) points of the grid, the transfer function
+     * is evaluated at these points in place
+     *
+     * @param v_table output vector (length: number of intervals + 1)
+     */
+    void get_grid(std::vector<double>& v_table) const {
+        const double step = (x1 - x0) / n_intervals;
+        v_table.resize(n_intervals + 1);
+        for (size_t k = 0; k < n_intervals; k++) v_table[k] = x0 + k * step;
+        v_table[n_intervals] = x1;
+    };
+
+    /**
+     * Locates `x` on the grid
+     *
+     * @param x value to locate
+     * @param i output: index of the interval that contains `x`
+     * @param t output: relative position of `x` within the interval
+     * @return false if `x` is outside of the grid or nan
+     */
+    bool locate(double x, size_t& i, double& t) const {
+        const double position = (x - x0) * inverse_step;
+        if (inverse_step == 0 || !(position >= 0 && position <= n_intervals)) return false;
+        i = std::min((size_t)position, n_intervals - 1);
+        t = position - i;
+        return true;
+    };
+
+    static double lerp(const std::vector<double>& v_table, size_t i, double t) {
+        return v_table[i] + t * (v_table[i + 1] - v_table[i]);
+    };
+
+   private:
+    double x0, x1, inverse_step;
+    size_t n_intervals;
+};
+
+/**
+ * Adjusts the scenario time series by Quantile Mapping (see
+ * `quantile_mapping` below) based on the distributions of the reference
+ * and control period computed by `fit_distributions`
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings (uses `cdf_method` and `lookup_table_resolution`)
+ * @param workspace distributions of the reference and control period
+ */
+template <AdjustmentKind kind>
+static void map_quantiles(
+    std::vector<float>& v_output,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (settings.cdf_method == CDFMethod::Exact)
+        return map_quantiles_exact<kind>(v_output, v_scenario, settings, workspace);
+
+    // ? the xbins are evenly spaced, the CDFs are only sorted
+    constexpr bool extrapolate = (kind == AdjustmentKind::Multiplicative);
+    const UniformInterpolator contr_cdf_at(workspace.v_xbins, workspace.v_control_cdf, extrapolate);
+    const SortedInterpolator ref_inverse_cdf_at(workspace.v_reference_cdf, workspace.v_xbins, extrapolate);
+
+    auto transfer_function = [&](double x) -> float {
+        if constexpr (kind == AdjustmentKind::Additive) {
+            const double cdf_value = contr_cdf_at(x);  // Eq. 1
+
+            // ? Invert in invers CDF and return
+            return (float)ref_inverse_cdf_at(cdf_value);  // Eq. 1
+        } else {
+            double y = contr_cdf_at(x);  // Eq. 2
+            const double cdf_value = (y >= 0) ? y : 0;
+
+            // ? Invert in invers CDF and return
+            float z = (float)ref_inverse_cdf_at(cdf_value);  // Eq. 2
+            return (z >= 0) ? z : 0;
+        }
+    };
+
+    const unsigned n_chunks = get_n_chunks(settings.n_threads, v_scenario.size(), min_time_chunk);
+    if (settings.lookup_table_resolution == 0) {
+        for_each_chunk(n_chunks, v_scenario.size(), [&](size_t first, size_t last, unsigned) {
+            for (size_t ts = first; ts < last; ts++)
+                v_output[ts] = transfer_function((double)v_scenario[ts]);
+        });
+        return;
+    }
+
+    // ? the grid is sorted and the CDFs are monotonic, so that both
+    // ? interpolations are done by a single sweep over the bins
+    const TransferTable table(workspace.v_xbins, settings.lookup_table_resolution);
+    std::vector<double>& v_table = workspace.v_transfer_table;
+    table.get_grid(v_table);
+    MathUtils::interpolate(workspace.v_xbins, workspace.v_control_cdf, v_table.data(), v_table.size(), v_table.data(), extrapolate);  // Eq. 1/2
+    if constexpr (kind == AdjustmentKind::Multiplicative)
+        for (double& cdf_value : v_table) cdf_value = (cdf_value >= 0) ? cdf_value : 0;
+    MathUtils::interpolate(workspace.v_reference_cdf, workspace.v_xbins, v_table.data(), v_table.size(), v_table.data(), extrapolate);  // Eq. 1/2
+    for (double& value : v_table) {
+        const float z = (float)value;
+        value = (kind == AdjustmentKind::Multiplicative && !(z >= 0)) ? 0 : z;
+    }
+    for_each_chunk(n_chunks, v_scenario.size(), [&](size_t first, size_t last, unsigned) {
+        for (size_t ts = first; ts < last; ts++) {
+            size_t i;
+            double t;
+            if (table.locate(v_scenario[ts], i, t))
+                v_output[ts] = (float)TransferTable::lerp(v_table, i, t);
+            else
+                v_output[ts] = transfer_function((double)v_scenario[ts]);
+        }
+    });
+}
+
+/**
+ * Quantile Mapping bias correction based on
+ * Tong, Y., Gao, X., Han, Z. et al. Bias correction of temperature and
+ * precipitation over China for RCM simulations using the QM and QDM methods.
+ * Clim Dyn 57, 1425–1443 (2021). https://doi.org/10.1007/s00382-020-05447-4
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_reference 1D reference time series (control period)
+ * @param v_control 1D modeled time series (control period)
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings struct with attributes:
+ *      double max_scaling_factor,
+ *      unsigned n_quantiles,
+ *      bool interval31_scaling,
+ *      AdjustmentKind kind,
+ *      CDFMethod cdf_method,
+ *      bool interval31_mapping (see `map_interval31`)
+ *
+ * (add):
+ *      (1.) $T^{*QM}_{sim,p}(d) = F^{-1}_{obs,h} \left\{F_{sim,h}\left[T_{sim,p}(d)\right]\right\}$
+ * (mult):
+ *      same but with bounded values => 0 is the minimum value
+ */
+template <AdjustmentKind kind>
+static void quantile_mapping(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (settings.interval31_mapping)
+        return map_interval31<kind, false>(v_output, v_reference, v_control, v_scenario, settings, workspace);
+
+    // If the xbins / probability boundaries can't be determined, because
+    // at least one of the time series only consists of nan values or is
+    // constant just return the uncorrected scenario time series.
+    workspace.status = fit_distributions<kind>(v_reference, v_control, settings, workspace);
+    if (workspace.status != CellStatus::Ok) {
+        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
+            v_output[ts] = v_scenario[ts];
+        return;
+    }
+    map_quantiles<kind>(v_output, v_scenario, settings, workspace);
+}
 
-    // ? create CDF
-    std::vector<int>
-        vi_ref_cdf = MathUtils::get_cdf(v_reference, v_xbins),
-        vi_contr_cdf = MathUtils::get_cdf(v_control, v_xbins),
-        vi_scen_cdf = MathUtils::get_cdf(v_scenario, v_xbins);
+/**
+ * Quantile Mapping (see `quantile_mapping`) using the kernel that is
+ * specialized for `settings.kind`
+ */
+void CMethods::Quantile_Mapping(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings
+) {
+    CMethodsWorkspace workspace;
+    Quantile_Mapping(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
 
-    // ? change to double
+/**
+ * Quantile Mapping (see `quantile_mapping`) using the kernel that is
+ * specialized for `settings.kind`
+ * and the buffers of `workspace`
+ */
+void CMethods::Quantile_Mapping(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    get_adjustment_function(
+        AdjustmentMethod::QuantileMapping, settings.kind, settings.interval31_scaling
+    )(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
+
+/**
+ * Adjusts the scenario time series by Quantile Delta Mapping (see
+ * `quantile_delta_mapping` below) based on the distributions of the
+ * reference and control period computed by `fit_distributions`
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings (uses `max_scaling_factor`, `cdf_method` and `lookup_table_resolution`)
+ * @param workspace distributions of the reference and control period
+ */
+template <AdjustmentKind kind>
+static void map_quantile_deltas(
+    std::vector<float>& v_output,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (settings.cdf_method == CDFMethod::Exact)
+        return map_quantile_deltas_exact<kind>(v_output, v_scenario, settings, workspace);
+
+    // ? create CDF of the scenario
     std::vector<double>
-        ref_cdf(vi_ref_cdf.begin(), vi_ref_cdf.end()),
-        contr_cdf(vi_contr_cdf.begin(), vi_contr_cdf.end()),
-        scen_cdf(vi_scen_cdf.begin(), vi_scen_cdf.end());
+        &v_xbins = workspace.v_xbins,
+        &scen_cdf = workspace.v_scenario_cdf;
+    get_chunked_cdf(v_scenario, v_xbins, scen_cdf, settings.n_threads, workspace.v_chunk_cdfs);
+
+    // ? the xbins are evenly spaced, the CDFs are only sorted
+    const UniformInterpolator scen_cdf_at(v_xbins, scen_cdf, false);
+    const SortedInterpolator
+        ref_inverse_cdf_at(workspace.v_reference_cdf, v_xbins, false),
+        contr_inverse_cdf_at(workspace.v_control_cdf, v_xbins, false);
+
+    const unsigned n_chunks = get_n_chunks(settings.n_threads, v_scenario.size(), min_time_chunk);
+    if (settings.lookup_table_resolution == 0) {
+        for_each_chunk(n_chunks, v_scenario.size(), [&](size_t first, size_t last, unsigned) {
+            for (size_t ts = first; ts < last; ts++) {
+                const double epsilon = scen_cdf_at(v_scenario[ts]);  // Eq. 1.1
+
+                // ? insert simulated values into inverse CDF of observed
+                const double QDM1 = ref_inverse_cdf_at(epsilon);  // Eq. 1.2
+
+                // ? Invert, insert in invers CDF and return
+                if constexpr (kind == AdjustmentKind::Additive)
+                    v_output[ts] = (float)(QDM1 + v_scenario[ts] - contr_inverse_cdf_at(epsilon));  // Eq. 1.3f.
+                else
+                    v_output[ts] = QDM1 * MathUtils::ensure_devidable(
+                                              (double)v_scenario[ts],
+                                              contr_inverse_cdf_at(epsilon),
+                                              settings.max_scaling_factor
+                                          );  // Eq. 2.3f.
+            }
+        });
+        return;
+    }
 
-    std::vector<double> epsilon;
-    for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-        epsilon.push_back(MathUtils::interpolate(v_xbins, scen_cdf, v_scenario[ts], false));  // Eq. 1.1
+    // ? tabulate QDM1 and the inverse control CDF (resp. their difference) as functions of the scenario values
+    const TransferTable table(v_xbins, settings.lookup_table_resolution);
+    std::vector<double>
+        &v_table = workspace.v_transfer_table,
+        &v_table_denominator = workspace.v_transfer_table_denominator;
+    // ? the grid is sorted and the CDFs are monotonic, so that all
+    // ? interpolations are done by a single sweep over the bins
+    table.get_grid(v_table_denominator);
+    MathUtils::interpolate(v_xbins, scen_cdf, v_table_denominator.data(), v_table_denominator.size(), v_table_denominator.data(), false);  // Eq. 1.1
+    v_table.resize(v_table_denominator.size());
+    MathUtils::interpolate(workspace.v_reference_cdf, v_xbins, v_table_denominator.data(), v_table_denominator.size(), v_table.data(), false);  // Eq. 1.2
+    MathUtils::interpolate(workspace.v_control_cdf, v_xbins, v_table_denominator.data(), v_table_denominator.size(), v_table_denominator.data(), false);
+    if constexpr (kind == AdjustmentKind::Additive)
+        for (size_t k = 0; k < v_table.size(); k++) v_table[k] -= v_table_denominator[k];
+
+    for_each_chunk(n_chunks, v_scenario.size(), [&](size_t first, size_t last, unsigned) {
+        for (size_t ts = first; ts < last; ts++) {
+            size_t i;
+            double t, QDM1, contr_value;
+            if (table.locate(v_scenario[ts], i, t)) {
+                QDM1 = TransferTable::lerp(v_table, i, t);  // additive: the difference to the inverse control CDF
+                contr_value = (kind == AdjustmentKind::Additive) ? 0 : TransferTable::lerp(v_table_denominator, i, t);
+            } else {
+                const double epsilon = scen_cdf_at(v_scenario[ts]);
+                QDM1 = ref_inverse_cdf_at(epsilon);
+                contr_value = contr_inverse_cdf_at(epsilon);
+            }
 
-    std::vector<double> QDM1;
-    // ? insert simulated values into inverse CDF of observed
-    for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-        QDM1.push_back(MathUtils::interpolate(ref_cdf, v_xbins, epsilon[ts], false));  // Eq. 1.2
+            if constexpr (kind == AdjustmentKind::Additive)
+                v_output[ts] = (float)(QDM1 + v_scenario[ts] - contr_value);  // Eq. 1.3f.
+            else
+                v_output[ts] = QDM1 * MathUtils::ensure_devidable(
+                                          (double)v_scenario[ts],
+                                          contr_value,
+                                          settings.max_scaling_factor
+                                      );  // Eq. 2.3f.
+        }
+    });
+}
+
+/**
+ * Quantile Delta Mapping bias correction based on
+ * Tong, Y., Gao, X., Han, Z. et al. Bias correction of temperature and
+ * precipitation over China for RCM simulations using the QM and QDM methods.
+ * Clim Dyn 57, 1425–1443 (2021). https://doi.org/10.1007/s00382-020-05447-4
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_reference 1D reference time series (control period)
+ * @param v_control 1D modeled time series (control period)
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings struct with attributes:
+ *      double max_scaling_factor,
+ *      unsigned n_quantiles,
+ *      bool interval31_scaling,
+ *      AdjustmentKind kind,
+ *      CDFMethod cdf_method,
+ *      bool interval31_mapping (see `map_interval31`)
+ *
+ * Add (+):
+ *  (1.1) $\varepsilon(t) = F^{(t)}_{sim,p}\left[T_{sim,p}(t)\right]$
+ *  (1.2) $\T^{*1QDM}_{sim,p}(t) = F^{-1}_{obs,h}\left[\varepsilon(t)\right]$
+ *  (1.3) $\Delta(t) = F^{-1}_{sim,p}(t)\left[\varepsilon(t)\right] = T_{sim,p}(t)-F^{-1}_{sim,h} \left\{F^{}_{sim,p}(t)\left[T_{sim,p}(t)\right]\right\}$
+ *  (1.4) $T^{*QDM}_{sim,p}(t) = T^{*1QDM}_{sim,p}(t) + \Delta(t)$
+ *
+ * Mult (*):
+ *   (2.1) --//-- (same as 1.1)
+ *   (2.2) --//-- (same as 1.2)
+ *   (2.3) \Delta(i) & = \frac{F^{-1}_{sim,p}\left[\varepsilon(i)\right] }{ F^{-1}_{sim,h}\left[\varepsilon(i)\right] } \\
+ *                   & = \frac{X_{sim,p}(i) }{ F^{-1}_{sim,h}\left\{F^{}_{sim,p}\left[X_{sim,p}(i)\right]\right\} }
+ *   (2.4) X^{*QDM}_{sim,p}(i) = X^{QDM(1)}_{sim,p}(i) \cdot \Delta(i)
+ */
+template <AdjustmentKind kind>
+static void quantile_delta_mapping(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (settings.interval31_mapping)
+        return map_interval31<kind, true>(v_output, v_reference, v_control, v_scenario, settings, workspace);
 
-    // ? Invert, insert in invers CDF and return
-    if (isAdd) {
+    // If the xbins / probability boundaries can't be determined, because
+    // at least one of the time series only consists of nan values or is
+    // constant just return the uncorrected scenario time series.
+    workspace.status = fit_distributions<kind>(v_reference, v_control, settings, workspace);
+    if (workspace.status != CellStatus::Ok) {
         for (unsigned ts = 0; ts < v_scenario.size(); ts++)
-            v_output[ts] = (float)(QDM1[ts] + v_scenario[ts] - MathUtils::interpolate(contr_cdf, v_xbins, epsilon[ts], false));  // Eq. 1.3f.
+            v_output[ts] = v_scenario[ts];
+        return;
+    }
+    map_quantile_deltas<kind>(v_output, v_scenario, settings, workspace);
+}
+
+/**
+ * Quantile Delta Mapping (see `quantile_delta_mapping`) using the kernel that
+ * is specialized for `settings.kind`
+ */
+void CMethods::Quantile_Delta_Mapping(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings
+) {
+    CMethodsWorkspace workspace;
+    Quantile_Delta_Mapping(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
+
+/**
+ * Quantile Delta Mapping (see `quantile_delta_mapping`) using the kernel that
+ * is specialized for `settings.kind`
+ * and the buffers of `workspace`
+ */
+void CMethods::Quantile_Delta_Mapping(
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    get_adjustment_function(
+        AdjustmentMethod::QuantileDeltaMapping, settings.kind, settings.interval31_scaling
+    )(v_output, v_reference, v_control, v_scenario, settings, workspace);
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *              Dispatching
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+/**
+ * Returns the adjustment kind that matches `name`
+ *
+ * @param name "add", "additive" or "+" resp. "mult", "multiplicative" or "*"
+ * @return the respective adjustment kind
+ */
+AdjustmentKind CMethods::get_adjustment_kind(std::string name) {
+    if (name == "add" || name == "additive" || name == "+")
+        return AdjustmentKind::Additive;
+    else if (name == "mult" || name == "multiplicative" || name == "*")
+        return AdjustmentKind::Multiplicative;
+    throw std::runtime_error("Unknown adjustment kind " + name + "!");
+}
+
+/**
+ * Returns the CDF estimation that matches `name`
+ *
+ * @param name "histogram", "exact" or "sketch"
+ * @return the respective CDF estimation
+ */
+CDFMethod CMethods::get_cdf_method(std::string name) {
+    if (name == "histogram")
+        return CDFMethod::Histogram;
+    else if (name == "exact")
+        return CDFMethod::Exact;
+    else if (name == "sketch")
+        return CDFMethod::Sketch;
+    throw std::runtime_error("Unknown CDF estimation " + name + "!");
+}
+
+/**
+ * Returns the name of the CDF estimation `cdf_method`
+ *
+ * @param cdf_method the CDF estimation
+ * @return "histogram", "exact" or "sketch"
+ */
+std::string CMethods::get_cdf_method_name(CDFMethod cdf_method) {
+    if (cdf_method == CDFMethod::Exact) return "exact";
+    return (cdf_method == CDFMethod::Sketch) ? "sketch" : "histogram";
+}
+
+/**
+ * Returns the grouping of the time steps that matches `name`
+ *
+ * @param name "none", "month", "season" or "dayofyear31"
+ * @return the respective grouping
+ */
+TimeGrouping CMethods::get_time_grouping(std::string name) {
+    if (name == "none")
+        return TimeGrouping::None;
+    else if (name == "month")
+        return TimeGrouping::Month;
+    else if (name == "season")
+        return TimeGrouping::Season;
+    else if (name == "dayofyear31")
+        return TimeGrouping::DayOfYear31;
+    throw std::runtime_error("Unknown grouping " + name + "!");
+}
+
+/**
+ * Returns the name of the grouping `grouping`
+ *
+ * @param grouping the grouping of the time steps
+ * @return "none", "month", "season" or "dayofyear31"
+ */
+std::string CMethods::get_time_grouping_name(TimeGrouping grouping) {
+    switch (grouping) {
+        case TimeGrouping::Month:
+            return "month";
+        case TimeGrouping::Season:
+            return "season";
+        case TimeGrouping::DayOfYear31:
+            return "dayofyear31";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * Returns the storage type of the slabs that matches `name`
+ *
+ * @param name "float16", "bfloat16" or "float"
+ * @return the respective storage type
+ */
+StorageType CMethods::get_storage_type(std::string name) {
+    if (name == "float16")
+        return StorageType::Float16;
+    else if (name == "bfloat16")
+        return StorageType::BFloat16;
+    else if (name == "float")
+        return StorageType::Float;
+    throw std::runtime_error("Unknown storage type " + name + "!");
+}
+
+/**
+ * Returns the name of the storage type `storage_type`
+ *
+ * @param storage_type the storage type of the slabs
+ * @return "float16", "bfloat16" or "float"
+ */
+std::string CMethods::get_storage_type_name(StorageType storage_type) {
+    switch (storage_type) {
+        case StorageType::Float16:
+            return "float16";
+        case StorageType::BFloat16:
+            return "bfloat16";
+        default:
+            return "float";
+    }
+}
+
+/**
+ * Returns the name of the status `status` of an adjusted grid cell
+ *
+ * @param status outcome of the adjustment of a cell
+ * @return "ok", "all-missing", "constant" or "fallback"
+ */
+std::string CMethods::get_cell_status_name(CellStatus status) {
+    switch (status) {
+        case CellStatus::AllMissing:
+            return "all-missing";
+        case CellStatus::Constant:
+            return "constant";
+        case CellStatus::Fallback:
+            return "fallback";
+        default:
+            return "ok";
+    }
+}
+
+/**
+ * Returns the adjustment method that matches `name`
+ *
+ * @param name one of `scaling_method_names` or `distribution_method_names`
+ * @return the respective adjustment method
+ */
+AdjustmentMethod CMethods::get_adjustment_method(std::string name) {
+    if (name == "linear_scaling")
+        return AdjustmentMethod::LinearScaling;
+    else if (name == "variance_scaling")
+        return AdjustmentMethod::VarianceScaling;
+    else if (name == "delta_method")
+        return AdjustmentMethod::DeltaMethod;
+    else if (name == "quantile_mapping")
+        return AdjustmentMethod::QuantileMapping;
+    else if (name == "quantile_delta_mapping")
+        return AdjustmentMethod::QuantileDeltaMapping;
+    throw std::runtime_error("Method " + name + " not found!");
+}
+
+/**
+ * Returns the short name of an adjustment kind
+ *
+ * @param kind adjustment kind
+ * @return "add" or "mult"
+ */
+std::string CMethods::get_adjustment_kind_name(AdjustmentKind kind) {
+    return (kind == AdjustmentKind::Additive) ? "add" : "mult";
+}
+
+/**
+ * Table of the specialized kernels. The first index is the adjustment method,
+ * the second the adjustment kind and the third one whether long-term 31-day
+ * intervals are used (1) or not (0). NULL entries are not available.
+ */
+static const AdjustmentFunction adjustment_functions[5][2][2] = {
+    // AdjustmentMethod::LinearScaling
+    {{linear_scaling<AdjustmentKind::Additive, false>, linear_scaling<AdjustmentKind::Additive, true>},
+     {linear_scaling<AdjustmentKind::Multiplicative, false>, linear_scaling<AdjustmentKind::Multiplicative, true>}},
+    // AdjustmentMethod::VarianceScaling
+    {{variance_scaling<false>, variance_scaling<true>},
+     {NULL, NULL}},
+    // AdjustmentMethod::DeltaMethod
+    {{delta_method<AdjustmentKind::Additive, false>, delta_method<AdjustmentKind::Additive, true>},
+     {delta_method<AdjustmentKind::Multiplicative, false>, delta_method<AdjustmentKind::Multiplicative, true>}},
+    // AdjustmentMethod::QuantileMapping (no long-term 31-day intervals)
+    {{quantile_mapping<AdjustmentKind::Additive>, quantile_mapping<AdjustmentKind::Additive>},
+     {quantile_mapping<AdjustmentKind::Multiplicative>, quantile_mapping<AdjustmentKind::Multiplicative>}},
+    // AdjustmentMethod::QuantileDeltaMapping (no long-term 31-day intervals)
+    {{quantile_delta_mapping<AdjustmentKind::Additive>, quantile_delta_mapping<AdjustmentKind::Additive>},
+     {quantile_delta_mapping<AdjustmentKind::Multiplicative>, quantile_delta_mapping<AdjustmentKind::Multiplicative>}},
+};
+
+/**
+ * Returns the adjustment procedure that is specialized for the given method,
+ * kind and grouping. This is meant to be invoked once before adjusting the
+ * data set, so that the adjustment of the individual grid cells does not
+ * have to evaluate these settings again.
+ *
+ * @param method adjustment method
+ * @param kind adjustment kind
+ * @param interval31_scaling use long-term 31-day intervals (scaling-based methods only)
+ * @return pointer to the specialized adjustment procedure
+ */
+AdjustmentFunction CMethods::get_adjustment_function(
+    AdjustmentMethod method,
+    AdjustmentKind kind,
+    bool interval31_scaling
+) {
+    AdjustmentFunction function = adjustment_functions[(int)method][(int)kind][interval31_scaling ? 1 : 0];
+    if (function == NULL) {
+        if (method == AdjustmentMethod::VarianceScaling)
+            throw std::runtime_error("Multiplicative Variance Scaling not available!");
+        throw std::runtime_error("Adjustment procedure not available!");
+    }
+    return function;
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *              Batched Adjustment
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+template <typename T>
+using SlabFunction = void (*)(
+    const BasicSlab<T>& output,
+    const BasicSlab<T>& numerator,
+    const BasicSlab<T>& denominator,
+    const BasicSlab<T>& target,
+    const DayOfYearIndex& numerator_dayofyear,
+    const DayOfYearIndex& denominator_dayofyear,
+    const DayOfYearIndex& target_dayofyear,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+);
+
+// Linear Scaling and the Delta Method for slabs - indices: [kind][interval31_scaling]
+template <typename T>
+static const SlabFunction<T> scale_by_means_functions[2][2] = {
+    {scale_by_means<AdjustmentKind::Additive, false, T>, scale_by_means<AdjustmentKind::Additive, true, T>},
+    {scale_by_means<AdjustmentKind::Multiplicative, false, T>, scale_by_means<AdjustmentKind::Multiplicative, true, T>},
+};
+
+template <typename T>
+using VarianceSlabFunction = void (*)(
+    const BasicSlab<T>& output,
+    const BasicSlab<T>& reference,
+    const BasicSlab<T>& control,
+    const BasicSlab<T>& scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+);
+
+// Variance Scaling for slabs - index: [interval31_scaling]
+template <typename T>
+static const VarianceSlabFunction<T> scale_by_variances_functions[2] = {
+    scale_by_variances<false, T>, scale_by_variances<true, T>
+};
+
+/**
+ * Adjusts the time series of all grid cells of a slab. Linear Scaling, Variance
+ * Scaling and the Delta Method compute the moments of several cells at once,
+ * the other methods adjust one cell after another but reuse the buffers, so the
+ * setup costs are paid once per slab instead of once per cell. Values of
+ * slabs stored in reduced precision are converted on the fly,
+ * the means are always accumulated in double precision. The number of cells
+ * per `CellStatus` is added to `workspace.status_counts`.
+ *
+ * @param method adjustment method
+ * @param output slab to store the adjusted time series in
+ * @param reference reference time series (control period)
+ * @param control modeled time series (control period)
+ * @param scenario time series to adjust (scenario period)
+ * @param settings adjustment settings
+ */
+template <typename T>
+void CMethods::Adjust_Slab(
+    AdjustmentMethod method,
+    const BasicSlab<T>& output,
+    const BasicSlab<T>& reference,
+    const BasicSlab<T>& control,
+    const BasicSlab<T>& scenario,
+    AdjustmentSettings& settings
+) {
+    CMethodsWorkspace workspace(
+        std::max(reference.n_time, std::max(control.n_time, scenario.n_time)), settings.n_quantiles
+    );
+    Adjust_Slab(method, output, reference, control, scenario, settings, workspace);
+}
+
+/**
+ * Adjusts the time series of all grid cells of a slab (see above) using the
+ * buffers of `workspace`, which is meant to be reused for all slabs that are
+ * processed by the same thread.
+ */
+template <typename T>
+void CMethods::Adjust_Slab(
+    AdjustmentMethod method,
+    const BasicSlab<T>& output,
+    const BasicSlab<T>& reference,
+    const BasicSlab<T>& control,
+    const BasicSlab<T>& scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (reference.n_cells != scenario.n_cells || control.n_cells != scenario.n_cells || output.n_cells != scenario.n_cells)
+        throw std::runtime_error("All slabs must contain the same number of grid cells!");
+
+    const bool is_grouped = !settings.scenario_groups.empty();
+    if (!is_grouped && (method == AdjustmentMethod::LinearScaling || method == AdjustmentMethod::DeltaMethod)) {
+        const bool is_delta_method = (method == AdjustmentMethod::DeltaMethod);
+        if (is_delta_method && reference.n_time != scenario.n_time)
+            throw std::runtime_error(
+                "Time dimension of reference and scenario input files does "
+                "not have the same length! This is required for the delta method."
+            );
+        const BasicSlab<T>& target = is_delta_method ? reference : scenario;
+        if (output.n_time != target.n_time)
+            throw std::runtime_error("The output slab does not match the length of the time series to adjust!");
+
+        scale_by_means_functions<T>[(int)settings.kind][settings.interval31_scaling ? 1 : 0](
+            output, is_delta_method ? scenario : reference, control, target,
+            is_delta_method ? settings.scenario_dayofyear : settings.reference_dayofyear,
+            settings.control_dayofyear,
+            is_delta_method ? settings.reference_dayofyear : settings.scenario_dayofyear,
+            settings, workspace
+        );
+        for (size_t cell = 0; cell < scenario.n_cells; cell++)
+            workspace.status_counts[(int)workspace.v_cell_status[cell]]++;
+        return;
+    }
+    if (!is_grouped && method == AdjustmentMethod::VarianceScaling) {
+        get_adjustment_function(method, settings.kind, settings.interval31_scaling);  // ? throws if not available
+        if (output.n_time != scenario.n_time)
+            throw std::runtime_error("The output slab does not match the length of the time series to adjust!");
+
+        scale_by_variances_functions<T>[settings.interval31_scaling ? 1 : 0](output, reference, control, scenario, settings, workspace);
+        for (size_t cell = 0; cell < scenario.n_cells; cell++)
+            workspace.status_counts[(int)workspace.v_cell_status[cell]]++;
+        return;
+    }
+
+    const BasicSlab<T>& target = (method == AdjustmentMethod::DeltaMethod) ? reference : scenario;
+    if (output.n_time != target.n_time)
+        throw std::runtime_error("The output slab does not match the length of the time series to adjust!");
+
+    // ? adjust one cell (resp. one group of a cell) after another
+    AdjustmentFunction adjustment_function = get_adjustment_function(method, settings.kind, settings.interval31_scaling);
+    std::vector<float>
+        &v_output = workspace.v_output,
+        &v_reference = workspace.v_reference,
+        &v_control = workspace.v_control,
+        &v_scenario = workspace.v_scenario;
+    v_output.resize(output.n_time);
+    v_reference.resize(reference.n_time);
+    v_control.resize(control.n_time);
+    v_scenario.resize(scenario.n_time);
+    for (size_t cell = 0; cell < scenario.n_cells; cell++) {
+        for (size_t ts = 0; ts < reference.n_time; ts++) v_reference[ts] = reference.at(cell, ts);
+        for (size_t ts = 0; ts < control.n_time; ts++) v_control[ts] = control.at(cell, ts);
+        for (size_t ts = 0; ts < scenario.n_time; ts++) v_scenario[ts] = scenario.at(cell, ts);
+
+        if (is_grouped)
+            Adjust_Groups(method, v_output, v_reference, v_control, v_scenario, settings, workspace);
+        else
+            adjustment_function(v_output, v_reference, v_control, v_scenario, settings, workspace);
+        for (size_t ts = 0; ts < output.n_time; ts++) output.at(cell, ts) = v_output[ts];
+        workspace.status_counts[(int)workspace.status]++;
+    }
+}
+
+/**
+ * Adjusts every group of time steps (see `TimeGroups`), e.g. every long-term
+ * month, on its own by the variant of `method` that is based on the whole
+ * time series, so that the input data sets do not have to be split into
+ * separate files beforehand. The groups are taken from `settings`, the
+ * output has the groups of the scenario (resp. the reference for the Delta
+ * Method). The status of the cell is the one of its groups if they all have
+ * the same, `CellStatus::Fallback` otherwise.
+ *
+ * @param method adjustment method
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_reference 1D reference time series (control period)
+ * @param v_control 1D modeled time series (control period)
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings including the groups of the time series
+ * @param workspace buffers of the calling thread
+ */
+void CMethods::Adjust_Groups(
+    AdjustmentMethod method,
+    std::vector<float>& v_output,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    const TimeGroups
+        &reference_groups = settings.reference_groups,
+        &control_groups = settings.control_groups,
+        &scenario_groups = settings.scenario_groups,
+        &output_groups = (method == AdjustmentMethod::DeltaMethod) ? reference_groups : scenario_groups;
+    const unsigned n_groups = scenario_groups.get_n_groups();
+    if (n_groups == 0 || reference_groups.get_n_groups() != n_groups || control_groups.get_n_groups() != n_groups)
+        throw std::runtime_error("The reference, control and scenario time series must have the same groups!");
+    if (reference_groups.v_time_steps.size() != v_reference.size() ||
+        control_groups.v_time_steps.size() != v_control.size() ||
+        scenario_groups.v_time_steps.size() != v_scenario.size())
+        throw std::runtime_error("The groups do not match the length of the time series!");
+
+    AdjustmentFunction adjustment_function = get_adjustment_function(method, settings.kind, false);
+    std::vector<float>
+        &v_group_output = workspace.v_group_output,
+        &v_group_reference = workspace.v_group_reference,
+        &v_group_control = workspace.v_group_control,
+        &v_group_scenario = workspace.v_group_scenario;
+
+    // copies the time steps of `group` of `v_in` into `v_out`
+    auto gather = [](const TimeGroups& groups, unsigned group, std::vector<float>& v_in, std::vector<float>& v_out) {
+        const size_t* v_time_steps = &groups.v_time_steps[groups.v_offsets[group]];
+        v_out.resize(groups.v_offsets[group + 1] - groups.v_offsets[group]);
+        for (size_t i = 0; i < v_out.size(); i++) v_out[i] = v_in[v_time_steps[i]];
+    };
+
+    bool is_first = true;
+    CellStatus status = CellStatus::Ok;
+    for (unsigned group = 0; group < n_groups; group++) {
+        const size_t n_output = output_groups.v_offsets[group + 1] - output_groups.v_offsets[group];
+        if (n_output == 0) continue;
+
+        gather(reference_groups, group, v_reference, v_group_reference);
+        gather(control_groups, group, v_control, v_group_control);
+        gather(scenario_groups, group, v_scenario, v_group_scenario);
+        v_group_output.resize(n_output);
+        adjustment_function(v_group_output, v_group_reference, v_group_control, v_group_scenario, settings, workspace);
+        status = (is_first || workspace.status == status) ? workspace.status : CellStatus::Fallback;
+        is_first = false;
+
+        const size_t* v_time_steps = &output_groups.v_time_steps[output_groups.v_offsets[group]];
+        for (size_t i = 0; i < n_output; i++) v_output[v_time_steps[i]] = v_group_output[i];
+    }
+    workspace.status = status;
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *              Transfer Functions
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
 
+/**
+ * Linear Scaling, QM and QDM only derive parameters from the reference and
+ * control period, so these can be fitted once per grid cell and applied to
+ * any number of scenarios. The parameters of a cell are stored as:
+ *
+ * Linear Scaling: 365 (long-term 31-day intervals) or 1 scaling factor(s)
+ * QM and QDM (CDFMethod::Histogram and CDFMethod::Sketch):
+ *      [n_bins, xbins[n_bins], reference CDF[n_bins], control CDF[n_bins]]
+ * QM and QDM (CDFMethod::Exact):
+ *      [n_ref, n_contr, sorted reference[n_ref], sorted control[n_contr]]
+ *
+ * Unused parameters are nan, `n_bins` resp. `n_ref` is 0 if the
+ * distributions could not be determined. Scaling factors that could not be
+ * determined leave the scenario unchanged. Fitting and applying store the
+ * outcome of the cell in `workspace.status`, applying reports cells without
+ * distributions as `CellStatus::Fallback`.
+ */
+
+typedef void (*FitFunction)(
+    double* v_parameters,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+);
+
+typedef void (*ApplyFunction)(
+    std::vector<float>& v_output,
+    const double* v_parameters,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+);
+
+/**
+ * Fits the scaling factors of Linear Scaling (see `linear_scaling`)
+ *
+ * @param v_parameters output array of 365 resp. 1 scaling factor(s)
+ * @param v_reference 1D reference time series (control period)
+ * @param v_control 1D modeled time series (control period)
+ * @param settings adjustment settings
+ * @param workspace buffers for the cumulative sums and means
+ */
+template <AdjustmentKind kind, bool interval31_scaling>
+static void fit_linear_scaling(
+    double* v_parameters,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    constexpr unsigned n_periods = interval31_scaling ? 365 : 1;
+    workspace.v_numerator_means.resize(n_periods * batch_width);
+    workspace.v_denominator_means.resize(n_periods * batch_width);
+    const Slab
+        reference(v_reference.data(), 1, v_reference.size(), SlabLayout::CellTime),
+        control(v_control.data(), 1, v_control.size(), SlabLayout::CellTime);
+    if (settings.compensated_summation) {
+        get_batch_means<interval31_scaling, true>(reference, settings.reference_dayofyear, 0, 1, workspace.v_scratch, workspace.v_numerator_means.data());
+        get_batch_means<interval31_scaling, true>(control, settings.control_dayofyear, 0, 1, workspace.v_scratch, workspace.v_denominator_means.data());
     } else {
-        // clang-format off
-        for (unsigned ts = 0; ts < v_scenario.size(); ts++) {
-            v_output[ts] = QDM1[ts] * MathUtils::ensure_devidable(
-                (double) v_scenario[ts],
-                MathUtils::interpolate(contr_cdf, v_xbins, epsilon[ts], false),
-                settings.max_scaling_factor
-            ); // Eq. 2.3f.
+        get_batch_means<interval31_scaling, false>(reference, settings.reference_dayofyear, 0, 1, workspace.v_scratch, workspace.v_numerator_means.data());
+        get_batch_means<interval31_scaling, false>(control, settings.control_dayofyear, 0, 1, workspace.v_scratch, workspace.v_denominator_means.data());
+    }
+
+    unsigned n_missing = 0;
+    for (unsigned period = 0; period < n_periods; period++) {
+        const double
+            numerator_mean = workspace.v_numerator_means[period * batch_width],
+            denominator_mean = workspace.v_denominator_means[period * batch_width];
+        if constexpr (interval31_scaling)  // ? single precision like in `scale_by_means`
+            v_parameters[period] = get_scaling_factor<kind>((float)numerator_mean, (float)denominator_mean, settings);
+        else
+            v_parameters[period] = get_scaling_factor<kind>(numerator_mean, denominator_mean, settings);
+        if (std::isnan(v_parameters[period])) {
+            v_parameters[period] = (kind == AdjustmentKind::Additive) ? 0 : 1;
+            n_missing++;
         }
-        // clang-format on
+    }
+    workspace.status = (n_missing == 0)           ? CellStatus::Ok
+                       : (n_missing == n_periods) ? CellStatus::AllMissing
+                                                  : CellStatus::Fallback;
+}
+
+/**
+ * Applies the scaling factors fitted by `fit_linear_scaling` to the
+ * scenario time series
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_parameters 365 resp. 1 scaling factor(s)
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings (uses `scenario_dayofyear`)
+ * @param workspace buffers of the calling thread (only the status)
+ */
+template <AdjustmentKind kind, bool interval31_scaling>
+static void apply_linear_scaling(
+    std::vector<float>& v_output,
+    const double* v_parameters,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if constexpr (interval31_scaling) {
+        float table[365];
+        for (unsigned day = 0; day < 365; day++) table[day] = (float)v_parameters[day];
+        const DayOfYearIndex* index = get_dayofyear_index(settings.scenario_dayofyear, v_scenario.size(), false);
+        for_each_dayofyear_run(index, v_scenario.size(), [&](size_t start, size_t count, unsigned day) {
+            if constexpr (kind == AdjustmentKind::Additive)
+                Kernels::add_dayofyear(v_output.data() + start, v_scenario.data() + start, count, table + day);
+            else
+                Kernels::multiply_dayofyear(v_output.data() + start, v_scenario.data() + start, count, table + day);
+        });
+    } else {
+        const double
+            offset = (kind == AdjustmentKind::Additive) ? v_parameters[0] : 0,
+            factor = (kind == AdjustmentKind::Additive) ? 1 : v_parameters[0];
+        Kernels::affine(v_output.data(), v_scenario.data(), v_scenario.size(), offset, factor, 0);
+    }
+    workspace.status = CellStatus::Ok;
+}
+
+/**
+ * Stores the probability boundaries and CDFs of `workspace` in
+ * `v_parameters` (`CDFMethod::Histogram` and `CDFMethod::Sketch`)
+ *
+ * @param v_parameters output array (see above)
+ * @param n_parameters length of `v_parameters`
+ * @param workspace buffers that contain the distributions
+ */
+static void store_histograms(double* v_parameters, size_t n_parameters, CMethodsWorkspace& workspace) {
+    const size_t n_bins = workspace.v_xbins.size();
+    if (1 + 3 * n_bins > n_parameters)
+        throw std::runtime_error("The probability boundaries exceed the number of quantiles!");
+    v_parameters[0] = n_bins;
+    std::copy(workspace.v_xbins.begin(), workspace.v_xbins.end(), v_parameters + 1);
+    std::copy(workspace.v_reference_cdf.begin(), workspace.v_reference_cdf.end(), v_parameters + 1 + n_bins);
+    std::copy(workspace.v_control_cdf.begin(), workspace.v_control_cdf.end(), v_parameters + 1 + 2 * n_bins);
+}
+
+/**
+ * Fits the distributions of the reference and control period that are
+ * used by QM and QDM (see `fit_distributions`)
+ *
+ * @param v_parameters output array (see above)
+ * @param v_reference 1D reference time series (control period)
+ * @param v_control 1D modeled time series (control period)
+ * @param settings adjustment settings
+ * @param workspace buffers for the distributions
+ */
+template <AdjustmentKind kind>
+static void fit_distribution_mapping(
+    double* v_parameters,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    const size_t n_parameters = CMethods::get_n_parameters(
+        AdjustmentMethod::QuantileMapping, settings, v_reference.size(), v_control.size()
+    );
+    std::fill(v_parameters, v_parameters + n_parameters, std::numeric_limits<double>::quiet_NaN());
+    v_parameters[0] = 0;
+    if (settings.cdf_method == CDFMethod::Exact) v_parameters[1] = 0;
+    workspace.status = fit_distributions<kind>(v_reference, v_control, settings, workspace);
+    if (workspace.status != CellStatus::Ok)
+        return;
+
+    if (settings.cdf_method == CDFMethod::Exact) {
+        const std::vector<double>
+            &ref_sorted = workspace.v_reference_sorted,
+            &contr_sorted = workspace.v_control_sorted;
+        v_parameters[0] = ref_sorted.size();
+        v_parameters[1] = contr_sorted.size();
+        std::copy(ref_sorted.begin(), ref_sorted.end(), v_parameters + 2);
+        std::copy(contr_sorted.begin(), contr_sorted.end(), v_parameters + 2 + ref_sorted.size());
+    } else
+        store_histograms(v_parameters, n_parameters, workspace);
+}
+
+/**
+ * Loads the distributions stored by `fit_distribution_mapping` into
+ * `workspace`
+ *
+ * @param v_parameters parameters of one grid cell (see above)
+ * @param settings adjustment settings (uses `cdf_method`)
+ * @param workspace buffers to store the distributions in
+ * @return false if the distributions could not be determined while fitting
+ */
+static bool load_distributions(const double* v_parameters, AdjustmentSettings& settings, CMethodsWorkspace& workspace) {
+    if (settings.cdf_method == CDFMethod::Exact) {
+        const size_t n_ref = (size_t)v_parameters[0], n_contr = (size_t)v_parameters[1];
+        if (n_ref < 2 || n_contr < 2) return false;
+        workspace.v_reference_sorted.assign(v_parameters + 2, v_parameters + 2 + n_ref);
+        workspace.v_control_sorted.assign(v_parameters + 2 + n_ref, v_parameters + 2 + n_ref + n_contr);
+    } else {
+        const size_t n_bins = (size_t)v_parameters[0];
+        if (n_bins < 2) return false;
+        workspace.v_xbins.assign(v_parameters + 1, v_parameters + 1 + n_bins);
+        workspace.v_reference_cdf.assign(v_parameters + 1 + n_bins, v_parameters + 1 + 2 * n_bins);
+        workspace.v_control_cdf.assign(v_parameters + 1 + 2 * n_bins, v_parameters + 1 + 3 * n_bins);
+    }
+    return true;
+}
+
+/**
+ * Applies Quantile Mapping based on the distributions fitted by
+ * `fit_distribution_mapping`
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_parameters parameters of the grid cell
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings
+ * @param workspace buffers for the distributions
+ */
+template <AdjustmentKind kind>
+static void apply_quantile_mapping(
+    std::vector<float>& v_output,
+    const double* v_parameters,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (!load_distributions(v_parameters, settings, workspace)) {
+        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
+            v_output[ts] = v_scenario[ts];
+        workspace.status = CellStatus::Fallback;
+        return;
+    }
+    workspace.status = CellStatus::Ok;
+    map_quantiles<kind>(v_output, v_scenario, settings, workspace);
+}
+
+/**
+ * Applies Quantile Delta Mapping based on the distributions fitted by
+ * `fit_distribution_mapping`
+ *
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_parameters parameters of the grid cell
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings
+ * @param workspace buffers for the distributions
+ */
+template <AdjustmentKind kind>
+static void apply_quantile_delta_mapping(
+    std::vector<float>& v_output,
+    const double* v_parameters,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (!load_distributions(v_parameters, settings, workspace)) {
+        for (unsigned ts = 0; ts < v_scenario.size(); ts++)
+            v_output[ts] = v_scenario[ts];
+        workspace.status = CellStatus::Fallback;
+        return;
+    }
+    workspace.status = CellStatus::Ok;
+    map_quantile_deltas<kind>(v_output, v_scenario, settings, workspace);
+}
+
+// indices: [method][kind][interval31_scaling], NULL: not available
+static const FitFunction fit_functions[5][2][2] = {
+    {{fit_linear_scaling<AdjustmentKind::Additive, false>, fit_linear_scaling<AdjustmentKind::Additive, true>},
+     {fit_linear_scaling<AdjustmentKind::Multiplicative, false>, fit_linear_scaling<AdjustmentKind::Multiplicative, true>}},
+    {{NULL, NULL}, {NULL, NULL}},
+    {{NULL, NULL}, {NULL, NULL}},
+    {{fit_distribution_mapping<AdjustmentKind::Additive>, fit_distribution_mapping<AdjustmentKind::Additive>},
+     {fit_distribution_mapping<AdjustmentKind::Multiplicative>, fit_distribution_mapping<AdjustmentKind::Multiplicative>}},
+    {{fit_distribution_mapping<AdjustmentKind::Additive>, fit_distribution_mapping<AdjustmentKind::Additive>},
+     {fit_distribution_mapping<AdjustmentKind::Multiplicative>, fit_distribution_mapping<AdjustmentKind::Multiplicative>}},
+};
+
+static const ApplyFunction apply_functions[5][2][2] = {
+    {{apply_linear_scaling<AdjustmentKind::Additive, false>, apply_linear_scaling<AdjustmentKind::Additive, true>},
+     {apply_linear_scaling<AdjustmentKind::Multiplicative, false>, apply_linear_scaling<AdjustmentKind::Multiplicative, true>}},
+    {{NULL, NULL}, {NULL, NULL}},
+    {{NULL, NULL}, {NULL, NULL}},
+    {{apply_quantile_mapping<AdjustmentKind::Additive>, apply_quantile_mapping<AdjustmentKind::Additive>},
+     {apply_quantile_mapping<AdjustmentKind::Multiplicative>, apply_quantile_mapping<AdjustmentKind::Multiplicative>}},
+    {{apply_quantile_delta_mapping<AdjustmentKind::Additive>, apply_quantile_delta_mapping<AdjustmentKind::Additive>},
+     {apply_quantile_delta_mapping<AdjustmentKind::Multiplicative>, apply_quantile_delta_mapping<AdjustmentKind::Multiplicative>}},
+};
+
+/**
+ * Checks if transfer functions can be fitted for `method` and `settings`
+ */
+static void check_transfer_function(AdjustmentMethod method, AdjustmentSettings& settings) {
+    if (fit_functions[(int)method][(int)settings.kind][settings.interval31_scaling ? 1 : 0] == NULL)
+        throw std::runtime_error(
+            "Transfer functions can only be fitted for Linear Scaling, "
+            "Quantile Mapping and Quantile Delta Mapping!"
+        );
+    if (method != AdjustmentMethod::LinearScaling && settings.interval31_mapping)
+        throw std::runtime_error("Transfer functions can't be fitted for the long-term 31-day intervals of QM and QDM!");
+}
+
+/**
+ * Returns the number of parameters that describe the transfer function of
+ * one grid cell
+ *
+ * @param method adjustment method
+ * @param settings adjustment settings
+ * @param n_reference length of the reference time series
+ * @param n_control length of the control time series
+ * @return the number of parameters per grid cell
+ */
+size_t CMethods::get_n_parameters(
+    AdjustmentMethod method,
+    AdjustmentSettings& settings,
+    size_t n_reference,
+    size_t n_control
+) {
+    check_transfer_function(method, settings);
+    if (method == AdjustmentMethod::LinearScaling)
+        return settings.interval31_scaling ? 365 : 1;
+    if (settings.cdf_method == CDFMethod::Exact)
+        return 2 + n_reference + n_control;
+    return 1 + 3 * ((size_t)settings.n_quantiles + 2);  // the bins can exceed the quantiles by rounding errors
+}
+
+/**
+ * Fits the transfer function of `method` for one grid cell based on the
+ * reference and control period
+ *
+ * @param method adjustment method
+ * @param v_parameters output array of `get_n_parameters` values
+ * @param v_reference 1D reference time series (control period)
+ * @param v_control 1D modeled time series (control period)
+ * @param settings adjustment settings
+ * @param workspace buffers of the calling thread
+ */
+void CMethods::Fit_Transfer_Function(
+    AdjustmentMethod method,
+    double* v_parameters,
+    std::vector<float>& v_reference,
+    std::vector<float>& v_control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    check_transfer_function(method, settings);
+    fit_functions[(int)method][(int)settings.kind][settings.interval31_scaling ? 1 : 0](
+        v_parameters, v_reference, v_control, settings, workspace
+    );
+}
+
+/**
+ * Fits the transfer function of QM or QDM for one grid cell based on
+ * quantile sketches of the reference and control period, e.g. sketches
+ * that were built chunk by chunk and merged. The parameters have the layout
+ * of `CDFMethod::Sketch` and are applied by `Apply_Transfer_Function` with
+ * the same settings.
+ *
+ * @param method adjustment method (QM or QDM)
+ * @param v_parameters output array of `get_n_parameters` values
+ * @param reference sketch of the reference time series (control period)
+ * @param control sketch of the modeled time series (control period)
+ * @param settings adjustment settings (`cdf_method` must not be `Exact`)
+ * @param workspace buffers of the calling thread
+ */
+void CMethods::Fit_Transfer_Function(
+    AdjustmentMethod method,
+    double* v_parameters,
+    const QuantileSketch& reference,
+    const QuantileSketch& control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (method != AdjustmentMethod::QuantileMapping && method != AdjustmentMethod::QuantileDeltaMapping)
+        throw std::runtime_error("Transfer functions can only be fitted from sketches for Quantile Mapping and Quantile Delta Mapping!");
+    if (settings.cdf_method == CDFMethod::Exact)
+        throw std::runtime_error("Transfer functions fitted from sketches can't be applied using the exact CDF!");
+
+    const size_t n_parameters = get_n_parameters(method, settings, reference.get_n(), control.get_n());
+    std::fill(v_parameters, v_parameters + n_parameters, std::numeric_limits<double>::quiet_NaN());
+    v_parameters[0] = 0;
+    workspace.status = (settings.kind == AdjustmentKind::Additive)
+                           ? fit_sketch_distributions<AdjustmentKind::Additive>(reference, control, settings, workspace)
+                           : fit_sketch_distributions<AdjustmentKind::Multiplicative>(reference, control, settings, workspace);
+    if (workspace.status == CellStatus::Ok) store_histograms(v_parameters, n_parameters, workspace);
+}
+
+/**
+ * Adjusts the scenario time series of one grid cell by the transfer
+ * function fitted by `Fit_Transfer_Function`. The result equals the one of
+ * the respective adjustment procedure.
+ *
+ * @param method adjustment method
+ * @param v_output 1D output vector that stores the adjusted time series
+ * @param v_parameters parameters of the transfer function
+ * @param v_scenario 1D time series to adjust (scenario period)
+ * @param settings adjustment settings that were used for fitting
+ * @param workspace buffers of the calling thread
+ */
+void CMethods::Apply_Transfer_Function(
+    AdjustmentMethod method,
+    std::vector<float>& v_output,
+    const double* v_parameters,
+    std::vector<float>& v_scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    check_transfer_function(method, settings);
+    apply_functions[(int)method][(int)settings.kind][settings.interval31_scaling ? 1 : 0](
+        v_output, v_parameters, v_scenario, settings, workspace
+    );
+}
+
+/**
+ * Fits the transfer functions of all grid cells of a slab and adds the
+ * number of cells per `CellStatus` to `workspace.status_counts`
+ *
+ * @param method adjustment method
+ * @param v_parameters output array: [cell][n_parameters]
+ * @param n_parameters number of parameters per cell (see `get_n_parameters`)
+ * @param reference reference time series (control period)
+ * @param control modeled time series (control period)
+ * @param settings adjustment settings
+ * @param workspace buffers of the calling thread
+ */
+template <typename T>
+void CMethods::Fit_Slab(
+    AdjustmentMethod method,
+    double* v_parameters,
+    size_t n_parameters,
+    const BasicSlab<T>& reference,
+    const BasicSlab<T>& control,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (reference.n_cells != control.n_cells)
+        throw std::runtime_error("All slabs must contain the same number of grid cells!");
+    if (n_parameters < get_n_parameters(method, settings, reference.n_time, control.n_time))
+        throw std::runtime_error("Too few parameters to store the transfer functions!");
+
+    FitFunction fit_function = fit_functions[(int)method][(int)settings.kind][settings.interval31_scaling ? 1 : 0];
+    std::vector<float>
+        &v_reference = workspace.v_reference,
+        &v_control = workspace.v_control;
+    v_reference.resize(reference.n_time);
+    v_control.resize(control.n_time);
+    for (size_t cell = 0; cell < reference.n_cells; cell++) {
+        for (size_t ts = 0; ts < reference.n_time; ts++) v_reference[ts] = reference.at(cell, ts);
+        for (size_t ts = 0; ts < control.n_time; ts++) v_control[ts] = control.at(cell, ts);
+        fit_function(v_parameters + cell * n_parameters, v_reference, v_control, settings, workspace);
+        workspace.status_counts[(int)workspace.status]++;
     }
 }
+
+/**
+ * Adjusts the time series of all grid cells of a slab by the transfer
+ * functions fitted by `Fit_Slab` and adds the number of cells per
+ * `CellStatus` to `workspace.status_counts`
+ *
+ * @param method adjustment method
+ * @param output slab to store the adjusted time series in
+ * @param v_parameters parameters of the transfer functions: [cell][n_parameters]
+ * @param n_parameters number of parameters per cell
+ * @param scenario time series to adjust (scenario period)
+ * @param settings adjustment settings that were used for fitting
+ * @param workspace buffers of the calling thread
+ */
+template <typename T>
+void CMethods::Apply_Slab(
+    AdjustmentMethod method,
+    const BasicSlab<T>& output,
+    const double* v_parameters,
+    size_t n_parameters,
+    const BasicSlab<T>& scenario,
+    AdjustmentSettings& settings,
+    CMethodsWorkspace& workspace
+) {
+    if (output.n_cells != scenario.n_cells || output.n_time != scenario.n_time)
+        throw std::runtime_error("The output slab does not match the shape of the scenario slab!");
+    check_transfer_function(method, settings);
+
+    ApplyFunction apply_function = apply_functions[(int)method][(int)settings.kind][settings.interval31_scaling ? 1 : 0];
+    std::vector<float>
+        &v_output = workspace.v_output,
+        &v_scenario = workspace.v_scenario;
+    v_output.resize(output.n_time);
+    v_scenario.resize(scenario.n_time);
+    for (size_t cell = 0; cell < scenario.n_cells; cell++) {
+        for (size_t ts = 0; ts < scenario.n_time; ts++) v_scenario[ts] = scenario.at(cell, ts);
+        apply_function(v_output, v_parameters + cell * n_parameters, v_scenario, settings, workspace);
+        for (size_t ts = 0; ts < output.n_time; ts++) output.at(cell, ts) = v_output[ts];
+        workspace.status_counts[(int)workspace.status]++;
+    }
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *              Storage Types
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+// slabs can be stored in half and single precision
+#define INSTANTIATE_SLAB_PROCEDURES(T)                                                    \
+    template void CMethods::Adjust_Slab<T>(                                               \
+        AdjustmentMethod, const BasicSlab<T>&, const BasicSlab<T>&,                       \
+        const BasicSlab<T>&, const BasicSlab<T>&, AdjustmentSettings&                     \
+    );                                                                                    \
+    template void CMethods::Adjust_Slab<T>(                                               \
+        AdjustmentMethod, const BasicSlab<T>&, const BasicSlab<T>&,                       \
+        const BasicSlab<T>&, const BasicSlab<T>&, AdjustmentSettings&, CMethodsWorkspace& \
+    );                                                                                    \
+    template void CMethods::Fit_Slab<T>(                                                  \
+        AdjustmentMethod, double*, size_t, const BasicSlab<T>&,                           \
+        const BasicSlab<T>&, AdjustmentSettings&, CMethodsWorkspace&                      \
+    );                                                                                    \
+    template void CMethods::Apply_Slab<T>(                                                \
+        AdjustmentMethod, const BasicSlab<T>&, const double*, size_t,                     \
+        const BasicSlab<T>&, AdjustmentSettings&, CMethodsWorkspace&                      \
+    );
+
+INSTANTIATE_SLAB_PROCEDURES(float)
+INSTANTIATE_SLAB_PROCEDURES(float16)
+INSTANTIATE_SLAB_PROCEDURES(bfloat16)
@@ -0,0 +1,392 @@
+// -*- lsst-c++ -*-
+
+/**
+ * @file Kernels.cxx
+ * @brief Implementation of the vectorized kernels used by the scaling-based methods
+ * @author Benjamin Thomas Schwertfeger
+ * @email: contact@b-schwertfeger.de
+ * @link https://github.com/btschwertfeger/BiasAdjustCXX
+ *
+ *  * Copyright (C) 2023 Benjamin Thomas Schwertfeger
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Includes
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+#include "Kernels.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// GCC and Clang vector extensions are used to write the kernels once for
+// all vector widths; the x86 variants are selected at runtime.
+#if defined(__GNUC__)
+#define BIASADJUST_VECTOR_KERNELS
+#if defined(__x86_64__) || defined(__i386__)
+#define BIASADJUST_X86_KERNELS
+#endif
+#endif
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Object Management
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+Kernels::Kernels() {}
+Kernels::~Kernels() {}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Scalar reference
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+static void add_dayofyear_scalar(float* v_output, const float* v_input, size_t n_time, const float* v_table) {
+    for (size_t ts = 0; ts < n_time; ts++)
+        v_output[ts] = v_input[ts] + v_table[ts % 365];
+}
+static void multiply_dayofyear_scalar(float* v_output, const float* v_input, size_t n_time, const float* v_table) {
+    for (size_t ts = 0; ts < n_time; ts++)
+        v_output[ts] = v_input[ts] * v_table[ts % 365];
+}
+static void affine_dayofyear_scalar(
+    float* v_output,
+    const float* v_input,
+    size_t n_time,
+    const double* v_offsets,
+    const double* v_factors,
+    const double* v_means
+) {
+    for (size_t ts = 0; ts < n_time; ts++)
+        v_output[ts] = (float)(((double)v_input[ts] + v_offsets[ts % 365]) * v_factors[ts % 365] + v_means[ts % 365]);
+}
+static void affine_scalar(float* v_output, const float* v_input, size_t n_time, double offset, double factor, double mean) {
+    for (size_t ts = 0; ts < n_time; ts++)
+        v_output[ts] = (float)(((double)v_input[ts] + offset) * factor + mean);
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Vectorized kernels
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+#ifdef BIASADJUST_VECTOR_KERNELS
+
+/**
+ * Vector types holding `W` floats resp. `W` doubles
+ */
+template <unsigned W>
+struct Batch {
+    typedef float Floats __attribute__((vector_size(W * sizeof(float))));
+    typedef double Doubles __attribute__((vector_size(W * sizeof(double))));
+};
+
+/**
+ * Computes `v_output = v_input + v_table` resp. `v_output = v_input * v_table`
+ * for every year, `W` days at once. Always inlined, so that the instructions
+ * are chosen by the target of the calling function.
+ */
+template <unsigned W, bool multiply>
+__attribute__((always_inline)) static inline void apply_float_table(
+    float* v_output, const float* v_input, size_t n_time, const float* v_table
+) {
+    typedef typename Batch<W>::Floats Floats;
+    for (size_t year_start = 0; year_start < n_time; year_start += 365) {
+        const unsigned n_days = (unsigned)std::min((size_t)365, n_time - year_start);
+        const float* input = v_input + year_start;
+        float* output = v_output + year_start;
+
+        unsigned day = 0;
+        for (; day + W <= n_days; day += W) {
+            Floats values, table;
+            std::memcpy(&values, input + day, sizeof(Floats));
+            std::memcpy(&table, v_table + day, sizeof(Floats));
+            const Floats result = multiply ? values * table : values + table;
+            std::memcpy(output + day, &result, sizeof(Floats));
+        }
+        for (; day < n_days; day++)
+            output[day] = multiply ? input[day] * v_table[day] : input[day] + v_table[day];
+    }
+}
+
+/**
+ * Computes `v_output = (v_input + offset) * factor + mean` in double
+ * precision `W` values at once, where `offset`, `factor` and `mean` are either
+ * tables of 365 values (`dayofyear`) or constants.
+ */
+template <unsigned W, bool dayofyear>
+__attribute__((always_inline)) static inline void apply_affine(
+    float* v_output, const float* v_input, size_t n_time, const double* v_offsets, const double* v_factors, const double* v_means
+) {
+    typedef typename Batch<W>::Floats Floats;
+    typedef typename Batch<W>::Doubles Doubles;
+
+    const size_t period = dayofyear ? 365 : n_time;
+    Doubles offsets, factors, means;
+    if constexpr (!dayofyear) {
+        for (unsigned i = 0; i < W; i++) {
+            offsets[i] = v_offsets[0];
+            factors[i] = v_factors[0];
+            means[i] = v_means[0];
+        }
+    }
+
+    for (size_t start = 0; start < n_time; start += period) {
+        const size_t n_days = std::min(period, n_time - start);
+        const float* input = v_input + start;
+        float* output = v_output + start;
+
+        size_t day = 0;
+        for (; day + W <= n_days; day += W) {
+            Floats values;
+            std::memcpy(&values, input + day, sizeof(Floats));
+            if constexpr (dayofyear) {
+                std::memcpy(&offsets, v_offsets + day, sizeof(Doubles));
+                std::memcpy(&factors, v_factors + day, sizeof(Doubles));
+                std::memcpy(&means, v_means + day, sizeof(Doubles));
+            }
+            const Floats result = __builtin_convertvector(
+                (__builtin_convertvector(values, Doubles) + offsets) * factors + means, Floats
+            );
+            std::memcpy(output + day, &result, sizeof(Floats));
+        }
+        for (; day < n_days; day++) {
+            const size_t i = dayofyear ? day : 0;
+            output[day] = (float)(((double)input[day] + v_offsets[i]) * v_factors[i] + v_means[i]);
+        }
+    }
+}
+
+// Defines the kernels for the instruction set `name` using `W` floats per
+// vector and the target attribute `target`
+#define BIASADJUST_DEFINE_KERNELS(name, W, target)                                                                     \
+    target static void add_dayofyear_##name(float* v_output, const float* v_input, size_t n_time, const float* v_table) { \
+        apply_float_table<W, false>(v_output, v_input, n_time, v_table);                                               \
+    }                                                                                                                  \
+    target static void multiply_dayofyear_##name(                                                                      \
+        float* v_output, const float* v_input, size_t n_time, const float* v_table                                     \
+    ) {                                                                                                                \
+        apply_float_table<W, true>(v_output, v_input, n_time, v_table);                                                \
+    }                                                                                                                  \
+    target static void affine_dayofyear_##name(                                                                        \
+        float* v_output, const float* v_input, size_t n_time,                                                          \
+        const double* v_offsets, const double* v_factors, const double* v_means                                        \
+    ) {                                                                                                                \
+        apply_affine<W, true>(v_output, v_input, n_time, v_offsets, v_factors, v_means);                               \
+    }                                                                                                                  \
+    target static void affine_##name(                                                                                  \
+        float* v_output, const float* v_input, size_t n_time, double offset, double factor, double mean                \
+    ) {                                                                                                                \
+        apply_affine<W, false>(v_output, v_input, n_time, &offset, &factor, &mean);                                    \
+    }
+
+BIASADJUST_DEFINE_KERNELS(baseline, 4, )
+#ifdef BIASADJUST_X86_KERNELS
+BIASADJUST_DEFINE_KERNELS(sse4, 4, __attribute__((target("sse4.2"))))
+BIASADJUST_DEFINE_KERNELS(avx2, 8, __attribute__((target("avx2"))))
+BIASADJUST_DEFINE_KERNELS(avx512, 16, __attribute__((target("avx512f"))))
+#endif
+#undef BIASADJUST_DEFINE_KERNELS
+
+#endif
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Dispatching
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+/**
+ * Set of kernels compiled for one instruction set
+ */
+struct KernelFunctions {
+    InstructionSet instruction_set;
+    void (*add_dayofyear)(float*, const float*, size_t, const float*);
+    void (*multiply_dayofyear)(float*, const float*, size_t, const float*);
+    void (*affine_dayofyear)(float*, const float*, size_t, const double*, const double*, const double*);
+    void (*affine)(float*, const float*, size_t, double, double, double);
+};
+
+#define BIASADJUST_KERNEL_FUNCTIONS(instruction_set, name) \
+    { instruction_set, add_dayofyear_##name, multiply_dayofyear_##name, affine_dayofyear_##name, affine_##name }
+
+/**
+ * Returns the kernels that can be used on this machine,
+ * ordered from the slowest to the fastest
+ */
+static std::vector<KernelFunctions> get_available_kernels() {
+    std::vector<KernelFunctions> v_kernels = {BIASADJUST_KERNEL_FUNCTIONS(InstructionSet::Scalar, scalar)};
+#ifdef BIASADJUST_VECTOR_KERNELS
+    v_kernels.push_back(BIASADJUST_KERNEL_FUNCTIONS(InstructionSet::Baseline, baseline));
+#ifdef BIASADJUST_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2"))
+        v_kernels.push_back(BIASADJUST_KERNEL_FUNCTIONS(InstructionSet::SSE4, sse4));
+    if (__builtin_cpu_supports("avx2"))
+        v_kernels.push_back(BIASADJUST_KERNEL_FUNCTIONS(InstructionSet::AVX2, avx2));
+    if (__builtin_cpu_supports("avx512f"))
+        v_kernels.push_back(BIASADJUST_KERNEL_FUNCTIONS(InstructionSet::AVX512, avx512));
+#endif
+#endif
+    return v_kernels;
+}
+#undef BIASADJUST_KERNEL_FUNCTIONS
+
+// the fastest kernels are selected at startup
+static const std::vector<KernelFunctions> available_kernels = get_available_kernels();
+static KernelFunctions kernels = available_kernels.back();
+
+/**
+ * Returns the instruction sets that are supported by this machine
+ *
+ * @return instruction sets, ordered from the slowest to the fastest
+ */
+std::vector<InstructionSet> Kernels::get_available_instruction_sets() {
+    std::vector<InstructionSet> v_instruction_sets;
+    for (unsigned i = 0; i < available_kernels.size(); i++)
+        v_instruction_sets.push_back(available_kernels[i].instruction_set);
+    return v_instruction_sets;
+}
+
+/**
+ * Returns the instruction set of the kernels in use
+ *
+ * @return the instruction set
+ */
+InstructionSet Kernels::get_instruction_set() {
+    return kernels.instruction_set;
+}
+
+/**
+ * Selects the kernels to use, e.g. `InstructionSet::Scalar` to verify the
+ * results of the vectorized kernels. Not thread-safe, must be called
+ * before the adjustment.
+ *
+ * @param instruction_set one of `get_available_instruction_sets()`
+ */
+void Kernels::set_instruction_set(InstructionSet instruction_set) {
+    for (unsigned i = 0; i < available_kernels.size(); i++) {
+        if (available_kernels[i].instruction_set == instruction_set) {
+            kernels = available_kernels[i];
+            return;
+        }
+    }
+    throw std::runtime_error(
+        "Instruction set " + get_instruction_set_name(instruction_set) + " is not supported by this machine!"
+    );
+}
+
+/**
+ * Returns the name of an instruction set
+ *
+ * @param instruction_set the instruction set
+ * @return the name, e.g. "avx2"
+ */
+std::string Kernels::get_instruction_set_name(InstructionSet instruction_set) {
+    switch (instruction_set) {
+        case InstructionSet::Scalar:
+            return "scalar";
+        case InstructionSet::Baseline:
+            return "baseline";
+        case InstructionSet::SSE4:
+            return "sse4.2";
+        case InstructionSet::AVX2:
+            return "avx2";
+        case InstructionSet::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Kernels
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+/**
+ * Adds the value of the respective day of year to every value:
+ * $v_{output}(t) = v_{input}(t) + v_{table}(t \bmod 365)$
+ *
+ * @param v_output output array with `n_time` entries (may be `v_input`)
+ * @param v_input input array with `n_time` entries
+ * @param n_time number of time steps
+ * @param v_table 365 values, one per day of year
+ */
+void Kernels::add_dayofyear(float* v_output, const float* v_input, size_t n_time, const float* v_table) {
+    kernels.add_dayofyear(v_output, v_input, n_time, v_table);
+}
+
+/**
+ * Multiplies every value with the value of the respective day of year:
+ * $v_{output}(t) = v_{input}(t) \cdot v_{table}(t \bmod 365)$
+ *
+ * @param v_output output array with `n_time` entries (may be `v_input`)
+ * @param v_input input array with `n_time` entries
+ * @param n_time number of time steps
+ * @param v_table 365 values, one per day of year
+ */
+void Kernels::multiply_dayofyear(float* v_output, const float* v_input, size_t n_time, const float* v_table) {
+    kernels.multiply_dayofyear(v_output, v_input, n_time, v_table);
+}
+
+/**
+ * Shifts and scales every value in double precision based on the
+ * respective day of year:
+ * $v_{output}(t) = (v_{input}(t) + offset(d)) \cdot factor(d) + mean(d)$
+ * with $d = t \bmod 365$
+ *
+ * @param v_output output array with `n_time` entries (may be `v_input`)
+ * @param v_input input array with `n_time` entries
+ * @param n_time number of time steps
+ * @param v_offsets 365 offsets
+ * @param v_factors 365 scaling factors
+ * @param v_means 365 values added after scaling
+ */
+void Kernels::affine_dayofyear(
+    float* v_output,
+    const float* v_input,
+    size_t n_time,
+    const double* v_offsets,
+    const double* v_factors,
+    const double* v_means
+) {
+    kernels.affine_dayofyear(v_output, v_input, n_time, v_offsets, v_factors, v_means);
+}
+
+/**
+ * Shifts and scales every value in double precision:
+ * $v_{output}(t) = (v_{input}(t) + offset) \cdot factor + mean$
+ *
+ * @param v_output output array with `n_time` entries (may be `v_input`)
+ * @param v_input input array with `n_time` entries
+ * @param n_time number of time steps
+ * @param offset offset
+ * @param factor scaling factor
+ * @param mean value added after scaling
+ */
+void Kernels::affine(float* v_output, const float* v_input, size_t n_time, double offset, double factor, double mean) {
+    kernels.affine(v_output, v_input, n_time, offset, factor, mean);
+}
@@ -33,14 +33,58 @@
 #include "Manager.hxx"
 
 #include <algorithm>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <type_traits>
 #include <vector>
 
 #include "CMethods.hxx"
+#include "Kernels.hxx"
 #include "Utils.hxx"
 #include "colors.h"
 
+/**
+ * Calls `f` with a value of the type that corresponds to `storage_type`, so
+ * that the slab-based functions can be instantiated for that type, e.g.
+ * `dispatch_storage_type(storage_type, [&](auto value) { adjust_3d<decltype(value)>(...); })`
+ *
+ * @param storage_type type that stores the slabs
+ * @param f generic callable
+ */
+template <typename F>
+static void dispatch_storage_type(StorageType storage_type, F f) {
+    switch (storage_type) {
+        case StorageType::Float16:
+            f(float16());
+            break;
+        case StorageType::BFloat16:
+            f(bfloat16());
+            break;
+        default:
+            f(float());
+    }
+}
+
+/**
+ * Reads a slab by `read` (e.g. `NcFileHandler::get_lat_slab_for_lon`) and
+ * stores it as `T`. Float slabs are read directly, the others are read into
+ * `v_buffer`, which can be shared by all files, and converted.
+ *
+ * @param read callable that reads the slab into a float vector
+ * @param v_buffer float buffer for the conversion
+ * @param v_slab output vector
+ */
+template <typename T, typename Reader>
+static void read_slab(Reader read, std::vector<float>& v_buffer, std::vector<T>& v_slab) {
+    if constexpr (std::is_same<T, float>::value)
+        read(v_slab);
+    else {
+        read(v_buffer);
+        v_slab.assign(v_buffer.begin(), v_buffer.end());
+    }
+}
+
 /**
  * Constructor which parses a string containing arguments
  * that are passed to the `main` function while executing the BiasAdjustCXX
@@ -55,6 +99,8 @@ Manager::Manager(int argc, char** argv) : argc(argc),
                                           variable_name(""),
                                           output_filepath(""),
                                           adjustment_method_name(""),
+                                          fit_filepath(""),
+                                          apply_filepath(""),
                                           adjustment_settings(AdjustmentSettings()),
                                           one_dim(false),
                                           n_jobs(1),
@@ -67,6 +113,7 @@ Manager::~Manager() {
     delete ds_reference;
     delete ds_control;
     delete ds_scenario;
+    delete ds_transfer;
 }
 
 /**
@@ -76,39 +123,98 @@ Manager::~Manager() {
  */
 void Manager::run_adjustment() {
     log.info("Data sets available");
+    if (!fit_filepath.empty())
+        log.info("Fitting the transfer functions only");
+    else if (!apply_filepath.empty())
+        log.info("Applying the transfer functions of " + apply_filepath);
     log.info("Method: " + adjustment_method_name + " (" + get_adjustment_kind() + ")");
     log.info("Threads: " + std::to_string(n_jobs));
-    if (get_adjustment_kind() == "mult") log.info("Maximum scaling factor: " + std::to_string(adjustment_settings.max_scaling_factor));
-    for (unsigned i = 0; i < CMethods::scaling_method_names.size(); i++) {
-        if (CMethods::scaling_method_names[i] == adjustment_method_name) {
-            if (adjustment_settings.interval31_scaling)
-                log.info("Scaling will be performed based on long-term 31-day intervals.");
-            else
-                log.info(
-                    "Scaling will be performed based on the whole data set. "
-                    "The input files should only contain the data for a specific month over the entire period. "
-                    "(i.e. this program must be applied to 12 data sets, that contain values only for a specific month over all years.)"
-                );
-            break;
-        }
+    log.info("Vectorized kernels: " + Kernels::get_instruction_set_name(Kernels::get_instruction_set()));
+    if (!one_dim) log.info("Storage type: " + CMethods::get_storage_type_name(storage_type));
+    if (adjustment_settings.kind == AdjustmentKind::Multiplicative) log.info("Maximum scaling factor: " + std::to_string(adjustment_settings.max_scaling_factor));
+    if (time_grouping == TimeGrouping::Month || time_grouping == TimeGrouping::Season)
+        log.info("Every long-term " + CMethods::get_time_grouping_name(time_grouping) + " will be adjusted separately.");
+    else if (utils::isInStrV(CMethods::scaling_method_names, adjustment_method_name)) {
+        if (adjustment_settings.interval31_scaling)
+            log.info("Scaling will be performed based on long-term 31-day intervals.");
+        else
+            log.info(
+                "Scaling will be performed based on the whole data set. "
+                "The input files should only contain the data for a specific month over the entire period. "
+                "(i.e. this program must be applied to 12 data sets, that contain values only for a specific month over all years.)"
+            );
+    }
+    if (adjustment_method == AdjustmentMethod::QuantileMapping || adjustment_method == AdjustmentMethod::QuantileDeltaMapping) {
+        if (adjustment_settings.interval31_mapping)
+            log.info("Every day of the year will be mapped based on the sorted samples of its long-term 31-day interval (exact).");
+        else if (adjustment_settings.cdf_method == CDFMethod::Exact)
+            log.info("CDFs will be based on the sorted samples (exact).");
+        else if (adjustment_settings.cdf_method == CDFMethod::Sketch) {
+            log.info(
+                "CDFs will be based on " + std::to_string(adjustment_settings.n_quantiles) +
+                " quantiles estimated by quantile sketches with a rank error of " +
+                std::to_string(adjustment_settings.sketch_error) + " (sketch)."
+            );
+            if (stream_sketches)
+                log.info("The reference and control period will be read into the sketches time chunk by time chunk.");
+        } else
+            log.info("CDFs will be based on " + std::to_string(adjustment_settings.n_quantiles) + " quantiles (histogram).");
+        if (adjustment_settings.lookup_table_resolution > 0)
+            log.info(
+                "Transfer functions will be interpolated from lookup tables with " +
+                std::to_string(adjustment_settings.lookup_table_resolution) + " points per quantile bin."
+            );
+    }
+
+    if (!fit_filepath.empty()) {
+        fit_transfer_functions();
+        log_status_counts();
+        log.info("Done!");
+        return;
     }
 
     if (one_dim) {  // adjustment of data set containing only one grid cell
         std::vector<float>
             v_data_out((int)ds_scenario->n_time),
-            v_reference((int)ds_reference->n_time),
-            v_control((int)ds_control->n_time),
             v_scenario((int)ds_scenario->n_time);
-
-        ds_reference->get_timeseries(v_reference);
-        ds_control->get_timeseries(v_control);
         ds_scenario->get_timeseries(v_scenario);
 
-        adjust_1d(v_data_out, v_reference, v_control, v_scenario);
+        if (apply_filepath.empty()) {
+            std::vector<float>
+                v_reference((int)ds_reference->n_time),
+                v_control((int)ds_control->n_time);
+            ds_reference->get_timeseries(v_reference);
+            ds_control->get_timeseries(v_control);
+            adjust_1d(v_data_out, v_reference, v_control, v_scenario);
+        } else {
+            std::vector<double> v_parameters;
+            ds_transfer->get_parameters(v_parameters);
+            CMethodsWorkspace workspace(std::max(v_scenario.size(), v_parameters.size()), adjustment_settings.n_quantiles);
+            CMethods::Apply_Transfer_Function(
+                adjustment_method, v_data_out, v_parameters.data(), v_scenario, adjustment_settings, workspace
+            );
+            status_counts[(int)workspace.status]++;
+        }
         log.info("Adjustment done!");
+        log_status_counts();
         log.info("Saving: " + output_filepath + " ...");
         ds_scenario->to_netcdf(output_filepath, variable_name, v_data_out);
 
+    } else if (!station_dimension.empty()) {  // adjustment of 2-dimensional data set (time x station)
+        std::vector<float> v_data_out((size_t)ds_scenario->n_time * ds_scenario->n_stations);
+
+        log.info("Starting the adjustment ...");
+        dispatch_storage_type(storage_type, [&](auto value) {
+            if (apply_filepath.empty() && !stream_sketches)
+                adjust_2d<decltype(value)>(v_data_out);
+            else
+                apply_2d<decltype(value)>(v_data_out);
+        });
+        log_status_counts();
+
+        log.info("Saving: " + output_filepath);
+        ds_scenario->to_netcdf(output_filepath, variable_name, v_data_out);
+
     } else {  // adjustment of 3-dimensional data set
         // ? prepare result vector lat x lon x time
         std::vector<std::vector<std::vector<float>>> v_data_out(
@@ -120,7 +226,13 @@ void Manager::run_adjustment() {
         );
 
         log.info("Starting the adjustment ...");
-        adjust_3d(v_data_out);
+        dispatch_storage_type(storage_type, [&](auto value) {
+            if (apply_filepath.empty() && !stream_sketches)
+                adjust_3d<decltype(value)>(v_data_out);
+            else
+                apply_3d<decltype(value)>(v_data_out);
+        });
+        log_status_counts();
 
         log.info("Preparing data for saving ...");
         std::vector<std::vector<std::vector<float>>>
@@ -144,6 +256,57 @@ void Manager::run_adjustment() {
     log.info("Done!");
 }
 
+/**
+ * Decodes the day of the year of every time step of a data set from the
+ * `units` and `calendar` attributes of its time variable (CF conventions),
+ * which is used for the long-term 31-day intervals. The calendar defaults to
+ * "standard". Without units, every year must consist of 365 time steps.
+ *
+ * @param ds data set (may be nullptr)
+ * @return day-of-year index, empty if there is no data set or no units
+ */
+static DayOfYearIndex get_dayofyear_index(NcFileHandler* ds) {
+    if (ds == nullptr) return DayOfYearIndex();
+
+    const std::string units = ds->get_time_attribute("units");
+    if (units.empty()) {
+        if (ds->n_time % 365 != 0)
+            throw std::runtime_error(
+                "The time variable of " + ds->filepath + " has no units, so every year must have 365 entries for "
+                "long-term 31-day interval scaling. Use the '--no-group' flag to adjust the data set without any moving window."
+            );
+        return DayOfYearIndex();
+    }
+    const std::string calendar = ds->get_time_attribute("calendar");
+    return DayOfYearIndex(utils::get_dayofyear(ds->time_values, ds->n_time, units, calendar.empty() ? "standard" : calendar));
+}
+
+/**
+ * Assigns the time steps of a data set to the long-term months or seasons,
+ * which are decoded from the `units` and `calendar` attributes of its time
+ * variable (CF conventions).
+ *
+ * @param ds data set (may be nullptr)
+ * @param grouping `TimeGrouping::Month` or `TimeGrouping::Season`
+ * @return groups of the time steps, empty if there is no data set
+ */
+static TimeGroups get_time_groups(NcFileHandler* ds, TimeGrouping grouping) {
+    if (ds == nullptr) return TimeGroups();
+
+    const std::string units = ds->get_time_attribute("units");
+    if (units.empty())
+        throw std::runtime_error(
+            "The time variable of " + ds->filepath + " has no units, which are required to group the time steps by " +
+            CMethods::get_time_grouping_name(grouping) + "!"
+        );
+    const std::string calendar = ds->get_time_attribute("calendar");
+    std::vector<unsigned> v_groups = utils::get_month(ds->time_values, ds->n_time, units, calendar.empty() ? "standard" : calendar);
+    if (grouping == TimeGrouping::Month) return TimeGroups(v_groups, 12);
+
+    for (unsigned& group : v_groups) group = ((group + 1) % 12) / 3;  // DJF, MAM, JJA, SON
+    return TimeGroups(v_groups, 4);
+}
+
 /**
  * Parses the arguments that were passed to the constructor.
  * This includes loading the input data sets, checking if
@@ -195,11 +358,9 @@ void Manager::parse_args() {
             else
                 throw std::runtime_error(arg + " requires one argument!");
         } else if (arg == "-k" || arg == "--kind") {
-            if (i + 1 < argc) {
-                adjustment_settings.kind = argv[++i];
-                adjustment_settings.kind = get_adjustment_kind();
-
-            } else
+            if (i + 1 < argc)
+                adjustment_settings.kind = CMethods::get_adjustment_kind(argv[++i]);
+            else
                 throw std::runtime_error(arg + " requires one argument!");
         } else if (arg == "--max-scaling-factor") {
             if (i + 1 < argc) {
@@ -209,16 +370,60 @@ void Manager::parse_args() {
                 adjustment_settings.max_scaling_factor = max_scaling_factor;
             } else
                 throw std::runtime_error(arg + " requires one argument!");
-        } else if (arg == "--no-group")
+        } else if (arg == "--cdf") {
+            if (i + 1 < argc)
+                adjustment_settings.cdf_method = CMethods::get_cdf_method(argv[++i]);
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "--sketch-error") {
+            if (i + 1 < argc)
+                adjustment_settings.sketch_error = std::stod(argv[++i]);
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "--lookup-table") {
+            if (i + 1 < argc)
+                adjustment_settings.lookup_table_resolution = (unsigned)std::stoi(argv[++i]);
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "--storage") {
+            if (i + 1 < argc)
+                storage_type = CMethods::get_storage_type(argv[++i]);
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "--fit") {
+            if (i + 1 < argc)
+                fit_filepath = argv[++i];
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "--apply") {
+            if (i + 1 < argc)
+                apply_filepath = argv[++i];
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "--group") {
+            if (i + 1 < argc) {
+                time_grouping = CMethods::get_time_grouping(argv[++i]);
+                adjustment_settings.interval31_scaling = (time_grouping == TimeGrouping::DayOfYear31);
+            } else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "--no-group") {
+            time_grouping = TimeGrouping::None;
             adjustment_settings.interval31_scaling = false;
-        else if (arg == "-o" || arg == "--output") {
+        } else if (arg == "--moving-window") {
+            adjustment_settings.interval31_mapping = true;
+        } else if (arg == "-o" || arg == "--output") {
             if (i + 1 < argc)
                 output_filepath = argv[++i];
             else
                 throw std::runtime_error(arg + " requires one argument!");
         } else if (arg == "--1dim")
             one_dim = true;
-        else if (arg == "-p" || arg == "--processes") {
+        else if (arg == "--stations") {
+            if (i + 1 < argc)
+                station_dimension = argv[++i];
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "-p" || arg == "--processes") {
             n_jobs = std::stoi(argv[++i]);
         } else if (arg == "-h" || arg == "--help") {
             utils::show_usage();
@@ -237,96 +442,145 @@ void Manager::parse_args() {
     }
 
     /* Requirements/Conditions for the whole adjustment procedure */
+    // fitting (`--fit`) only requires the reference and control period,
+    // applying (`--apply`) only the scenario and the fitted transfer functions
+    const bool
+        needs_control_period = apply_filepath.empty(),
+        needs_scenario = fit_filepath.empty();
+    if (!fit_filepath.empty() && !apply_filepath.empty()) throw std::runtime_error("--fit and --apply can't be combined!");
     if (variable_name.empty()) throw std::runtime_error("No variable name defined!");
-    if (reference_fpath.empty()) throw std::runtime_error("No reference file defined!");
-    if (control_fpath.empty()) throw std::runtime_error("No control file defined!");
-    if (scenario_fpath.empty()) throw std::runtime_error("No scenario file defined!");
-    if (output_filepath.empty()) throw std::runtime_error("No output file defined!");
+    if (reference_fpath.empty() && needs_control_period) throw std::runtime_error("No reference file defined!");
+    if (control_fpath.empty() && needs_control_period) throw std::runtime_error("No control file defined!");
+    if (scenario_fpath.empty() && needs_scenario) throw std::runtime_error("No scenario file defined!");
+    if (output_filepath.empty() && needs_scenario) throw std::runtime_error("No output file defined!");
+
+    // 1-, 2- (time x station) or 3-dimensional adjustment
+    if (one_dim && !station_dimension.empty()) throw std::runtime_error("--1dim and --stations can't be combined!");
+    if (!station_dimension.empty()) NcFileHandler::station_name = station_dimension;
+    const unsigned n_dimensions = one_dim ? 1 : station_dimension.empty() ? 3 : 2;
+    if (!apply_filepath.empty()) {
+        ds_transfer = new NcFileHandler();
+        ds_transfer->read_parameters(apply_filepath, variable_name, n_dimensions);
+        read_transfer_settings();
+    }
     if (adjustment_method_name.empty()) throw std::runtime_error("No method specified!");
-    if (adjustment_settings.kind.empty()) throw std::runtime_error("Adjustment kind is empty!");
 
-    // 1- or 3-dimensional adjustment
-    if (one_dim) {
-        ds_reference = new NcFileHandler(reference_fpath, variable_name, 1);
-        ds_control = new NcFileHandler(control_fpath, variable_name, 1);
-        ds_scenario = new NcFileHandler(scenario_fpath, variable_name, 1);
-    } else {
-        ds_reference = new NcFileHandler(reference_fpath, variable_name, 3);
-        ds_control = new NcFileHandler(control_fpath, variable_name, 3);
-        ds_scenario = new NcFileHandler(scenario_fpath, variable_name, 3);
+    // resolve the method once, so that no string comparisons are needed later on
+    adjustment_method = CMethods::get_adjustment_method(adjustment_method_name);
+    const bool is_scaling_method = (adjustment_method == AdjustmentMethod::LinearScaling ||
+                                    adjustment_method == AdjustmentMethod::VarianceScaling ||
+                                    adjustment_method == AdjustmentMethod::DeltaMethod);
 
+    if (needs_control_period) {
+        ds_reference = new NcFileHandler(reference_fpath, variable_name, n_dimensions);
+        ds_control = new NcFileHandler(control_fpath, variable_name, n_dimensions);
+    }
+    if (needs_scenario)
+        ds_scenario = new NcFileHandler(scenario_fpath, variable_name, n_dimensions);
+
+    std::vector<NcFileHandler*> datasets;
+    for (NcFileHandler* ds : {ds_reference, ds_control, ds_scenario, ds_transfer})
+        if (ds != nullptr) datasets.push_back(ds);
+
+    if (!station_dimension.empty()) {
+        // the stations must be the same in all input files
+        for (NcFileHandler* ds : datasets)
+            if (ds->n_stations != datasets[0]->n_stations)
+                throw std::runtime_error("Input files have unequal lengths of the `" + station_dimension + "` dimension.");
+    } else if (!one_dim) {
         // latitudes and longitudes must have the same lengths in all input files
-        if (ds_reference->n_lat != ds_control->n_lat || ds_reference->n_lat != ds_scenario->n_lat)
-            throw std::runtime_error("Input files have unequal lengths of the `lat` (latitude) dimension.");
-        else if (ds_reference->n_lon != ds_control->n_lon || ds_reference->n_lon != ds_scenario->n_lon)
-            throw std::runtime_error("Input files have unequal lengths of the `lon` (longitude) dimension.");
+        for (NcFileHandler* ds : datasets) {
+            if (ds->n_lat != datasets[0]->n_lat)
+                throw std::runtime_error("Input files have unequal lengths of the `lat` (latitude) dimension.");
+            else if (ds->n_lon != datasets[0]->n_lon)
+                throw std::runtime_error("Input files have unequal lengths of the `lon` (longitude) dimension.");
+        }
     }
 
-    // Time dimensions can have different lengths but it is not recommended
-    if (ds_reference->n_time != ds_control->n_time || ds_reference->n_time != ds_scenario->n_time)
-        log.warning("Input files have different sizes for the time dimension.");
+    if (adjustment_settings.lookup_table_resolution > 0 && adjustment_settings.cdf_method == CDFMethod::Exact)
+        throw std::runtime_error("--lookup-table can't be combined with --cdf exact!");
+    // the exact CDFs consist of all values of the reference and control period,
+    // which would be stored for every grid cell
+    if (!fit_filepath.empty() && adjustment_settings.cdf_method == CDFMethod::Exact)
+        throw std::runtime_error("--fit can't be combined with --cdf exact!");
+    if (!(adjustment_settings.sketch_error > 0 && adjustment_settings.sketch_error < 1))
+        throw std::runtime_error("--sketch-error must be between 0 and 1!");
+    if (adjustment_settings.interval31_mapping) {
+        if (adjustment_method != AdjustmentMethod::QuantileMapping && adjustment_method != AdjustmentMethod::QuantileDeltaMapping)
+            throw std::runtime_error("--moving-window is only available for quantile_mapping and quantile_delta_mapping!");
+        if (time_grouping == TimeGrouping::Month || time_grouping == TimeGrouping::Season)
+            throw std::runtime_error("--moving-window can't be combined with --group month or --group season!");
+        if (adjustment_settings.lookup_table_resolution > 0 || adjustment_settings.cdf_method == CDFMethod::Sketch)
+            throw std::runtime_error("--moving-window is based on the exact CDFs of the windows and can't be combined with --lookup-table or --cdf sketch!");
+    }
 
-    // Delta Method needs same length of time dimension for reference and
-    // scenario
-    if (ds_reference->n_time != ds_scenario->n_time && adjustment_method_name == std::string("delta_method"))
-        throw std::runtime_error(
-            "Time dimension of reference and scenario input files "
-            "does not have the same length! This is required for the delta method."
-        );
+    if (!fit_filepath.empty())  // throws if the method has no transfer functions
+        CMethods::get_n_parameters(adjustment_method, adjustment_settings, ds_reference->n_time, ds_control->n_time);
 
-    // When using long-term 31-day interval scaling, leap years should not be
-    // included and every year must be complete (only for scaling methods).
-    if (adjustment_settings.interval31_scaling &&
-        (adjustment_method_name == "linear_scaling" ||
-         adjustment_method_name == "variance_scaling" ||
-         adjustment_method_name == "delta_method") &&
-        !(ds_reference->n_time % 365 == 0 &&
-          ds_control->n_time % 365 == 0 &&
-          ds_scenario->n_time % 365 == 0))
-        throw std::runtime_error(
-            "Data sets should not contain the 29. February and every year must have 365 entries for long-term "
-            "31-day interval scaling. Use the '--no-group' flag to adjust the data set without any moving window."
-        );
+    if (needs_control_period && needs_scenario) {
+        // Time dimensions can have different lengths but it is not recommended
+        if (ds_reference->n_time != ds_control->n_time || ds_reference->n_time != ds_scenario->n_time)
+            log.warning("Input files have different sizes for the time dimension.");
+
+        // Delta Method needs same length of time dimension for reference and
+        // scenario
+        if (ds_reference->n_time != ds_scenario->n_time && adjustment_method == AdjustmentMethod::DeltaMethod)
+            throw std::runtime_error(
+                "Time dimension of reference and scenario input files "
+                "does not have the same length! This is required for the delta method."
+            );
+    }
+
+    // The long-term 31-day intervals (scaling methods and the moving windows
+    // of QM and QDM) are based on the calendars of the data sets, so leap
+    // years and 360-day years can be adjusted without removing or inserting
+    // days beforehand.
+    if ((adjustment_settings.interval31_scaling && is_scaling_method) || adjustment_settings.interval31_mapping) {
+        adjustment_settings.reference_dayofyear = get_dayofyear_index(ds_reference);
+        adjustment_settings.control_dayofyear = get_dayofyear_index(ds_control);
+        adjustment_settings.scenario_dayofyear = get_dayofyear_index(ds_scenario);
+    }
+
+    // Every long-term month or season is adjusted on its own, this replaces
+    // splitting the data sets by month and applying the '--no-group' variants
+    if (time_grouping == TimeGrouping::Month || time_grouping == TimeGrouping::Season) {
+        if (!needs_control_period || !needs_scenario)
+            throw std::runtime_error("--group month and --group season can't be combined with --fit or --apply!");
+        adjustment_settings.reference_groups = get_time_groups(ds_reference, time_grouping);
+        adjustment_settings.control_groups = get_time_groups(ds_control, time_grouping);
+        adjustment_settings.scenario_groups = get_time_groups(ds_scenario, time_grouping);
+    }
+
+    if (one_dim && storage_type != StorageType::Float)
+        log.warning("--storage only applies to 2- and 3-dimensional data sets and is ignored!");
+
+    // The quantile sketches of QM and QDM are filled time chunk by time chunk
+    // (`fit_sketches`), so that the whole reference and control period of
+    // 2- and 3-dimensional data sets never has to be kept in memory
+    stream_sketches = (!one_dim && apply_filepath.empty() &&
+                       adjustment_settings.cdf_method == CDFMethod::Sketch &&
+                       (adjustment_method == AdjustmentMethod::QuantileMapping || adjustment_method == AdjustmentMethod::QuantileDeltaMapping) &&
+                       adjustment_settings.scenario_groups.empty());
 
     // misc
-    if (n_jobs != 1 && one_dim) log.warning("Using only one thread because of the adjustment of a 1-dimensional data set.");
-
-    // setting the method
-    if (adjustment_settings.kind == "add" || adjustment_settings.kind == "mult") {
-        if (adjustment_method_name == "linear_scaling")
-            adjustment_function = CMethods::Linear_Scaling;
-        else if (adjustment_method_name == "variance_scaling") {
-            if (adjustment_settings.kind != "mult")
-                adjustment_function = CMethods::Variance_Scaling;
-            else
-                throw std::runtime_error("Multiplicative Variance Scaling not available!");
-        } else if (adjustment_method_name == "delta_method")
-            adjustment_function = CMethods::Delta_Method;
-        else if (adjustment_method_name == "quantile_mapping")
-            adjustment_function = CMethods::Quantile_Mapping;
-        else if (adjustment_method_name == "quantile_delta_mapping")
-            adjustment_function = CMethods::Quantile_Delta_Mapping;
-        else
-            throw std::runtime_error("Method " + adjustment_method_name + "(" + adjustment_settings.kind + ") not found!");
-    } else
-        throw std::runtime_error("Unknown adjustment kind " + adjustment_settings.kind + "!");
+    if (one_dim) set_threads_per_cell(1);
+
+    // setting the method: selects the kernel that is specialized for the
+    // method, kind and grouping
+    adjustment_function = CMethods::get_adjustment_function(
+        adjustment_method,
+        adjustment_settings.kind,
+        adjustment_settings.interval31_scaling
+    );
 }
 
 /**
  * Returns the selected adjustment kind
  *
- * @return adjustment kind, additive ("add" || "+") or multiplicative ("mult" || "*")
+ * @return adjustment kind, additive ("add") or multiplicative ("mult")
  */
 std::string Manager::get_adjustment_kind() {
-    return (adjustment_settings.kind == "additive" ||
-            adjustment_settings.kind == "add" ||
-            adjustment_settings.kind == "+")
-               ? "add"
-           : (adjustment_settings.kind == "multiplicative" ||
-              adjustment_settings.kind == "mult" ||
-              adjustment_settings.kind == "*")
-               ? "mult"
-               : "";
+    return CMethods::get_adjustment_kind_name(adjustment_settings.kind);
 }
 
 /**
@@ -344,60 +598,771 @@ void Manager::adjust_1d(
     std::vector<float>& v_control,
     std::vector<float>& v_scenario
 ) {
-    if (adjustment_function != NULL)
-        adjustment_function(v_data_out, v_reference, v_control, v_scenario, adjustment_settings);
-    else
-        throw std::runtime_error("Unknown adjustment method " + adjustment_method_name + " (" + adjustment_settings.kind + ")!");
+    if (adjustment_function != NULL) {
+        CMethodsWorkspace workspace(v_scenario.size(), adjustment_settings.n_quantiles);
+        if (adjustment_settings.scenario_groups.empty())
+            adjustment_function(v_data_out, v_reference, v_control, v_scenario, adjustment_settings, workspace);
+        else
+            CMethods::Adjust_Groups(adjustment_method, v_data_out, v_reference, v_control, v_scenario, adjustment_settings, workspace);
+        status_counts[(int)workspace.status]++;
+    } else
+        throw std::runtime_error("Unknown adjustment method " + adjustment_method_name + " (" + get_adjustment_kind() + ")!");
+}
+
+/**
+ * Invokes the batched adjustment of the selected method for all grid cells
+ * of the given slabs
+ *
+ * @param output slab to store the adjusted time series in
+ * @param reference reference data (control period)
+ * @param control modeled data (control period)
+ * @param scenario data to adjust (scenario period)
+ * @param workspace buffers of the calling thread
+ */
+template <typename T>
+void Manager::adjust_slab(BasicSlab<T> output, BasicSlab<T> reference, BasicSlab<T> control, BasicSlab<T> scenario, CMethodsWorkspace& workspace) {
+    CMethods::Adjust_Slab(adjustment_method, output, reference, control, scenario, adjustment_settings, workspace);
 }
 
 /**
  * Handles the adjustment of a 3-dimensional data set by loading the input data
- * per latitude
- * -> All longitudes per latitude are adjusted in one iteration, this is because
+ * per longitude
+ * -> All latitudes per longitude are adjusted in one iteration, this is because
  *    loading all time series at once would crash the most systems and loading
  *    every time series alone takes too much time.
+ * -> The data of one longitude is kept in the layout of the files ([time][lat])
+ *    and split into `n_jobs` slabs of neighbouring latitudes that are adjusted
+ *    in parallel.
+ * -> Every job owns a workspace that is sized once and reused for all
+ *    longitudes, so no memory is allocated while adjusting the grid cells.
+ * -> The slabs are stored as `T` (see `--storage`), the values are converted
+ *    while reading.
  *
  * @param v_data_out 3D vector that is used to store the bias adjusted results
  */
+template <typename T>
 void Manager::adjust_3d(std::vector<std::vector<std::vector<float>>>& v_data_out) {
+    const size_t
+        n_lat = ds_scenario->n_lat,
+        n_output_time = v_data_out[0][0].size(),
+        n_lat_per_job = (n_lat + n_jobs - 1) / n_jobs;
+
+    std::vector<float> v_buffer;
+    std::vector<T>
+        v_reference_slab,
+        v_control_slab,
+        v_scenario_slab,
+        v_output_slab(n_output_time * n_lat);
+
+    const size_t
+        n_time = std::max(ds_reference->n_time, std::max(ds_control->n_time, ds_scenario->n_time)),
+        n_tasks = (n_lat + n_lat_per_job - 1) / n_lat_per_job;
+    set_threads_per_cell(n_tasks);
+    std::vector<CMethodsWorkspace> v_workspaces;
+    v_workspaces.reserve(n_tasks);
+    for (size_t job = 0; job < n_tasks; job++)
+        v_workspaces.emplace_back(n_time, adjustment_settings.n_quantiles);
+
     std::vector<std::future<void>> tasks;
     for (unsigned lon = 0; lon < ds_scenario->n_lon; lon++) {
-        std::vector<std::vector<float>> v_reference_lat_data(
-            (int)ds_reference->n_lat,
-            std::vector<float>((int)ds_reference->n_time)
-        );
+        read_slab([&](std::vector<float>& v) { ds_reference->get_lat_slab_for_lon(v, lon); }, v_buffer, v_reference_slab);
+        read_slab([&](std::vector<float>& v) { ds_control->get_lat_slab_for_lon(v, lon); }, v_buffer, v_control_slab);
+        read_slab([&](std::vector<float>& v) { ds_scenario->get_lat_slab_for_lon(v, lon); }, v_buffer, v_scenario_slab);
 
-        std::vector<std::vector<float>> v_control_lat_data(
-            (int)ds_control->n_lat,
-            std::vector<float>((int)ds_control->n_time)
-        );
+        const BasicSlab<T>
+            output(v_output_slab.data(), n_lat, n_output_time, SlabLayout::TimeCell),
+            reference(v_reference_slab.data(), n_lat, ds_reference->n_time, SlabLayout::TimeCell),
+            control(v_control_slab.data(), n_lat, ds_control->n_time, SlabLayout::TimeCell),
+            scenario(v_scenario_slab.data(), n_lat, ds_scenario->n_time, SlabLayout::TimeCell);
 
-        std::vector<std::vector<float>> v_scenario_lat_data(
-            (int)ds_scenario->n_lat,
-            std::vector<float>((int)ds_scenario->n_time)
-        );
+        for (size_t first = 0, job = 0; first < n_lat; first += n_lat_per_job, job++) {
+            const size_t count = std::min(n_lat_per_job, n_lat - first);
+            tasks.push_back(std::async(
+                &Manager::adjust_slab<T>,
+                this,
+                output.get_cells(first, count),
+                reference.get_cells(first, count),
+                control.get_cells(first, count),
+                scenario.get_cells(first, count),
+                std::ref(v_workspaces[job])
+            ));
+        }
+        for (auto& e : tasks) e.get();
+        tasks.clear();
+
+        for (size_t lat = 0; lat < n_lat; lat++)
+            for (size_t ts = 0; ts < n_output_time; ts++)
+                v_data_out[lat][lon][ts] = output.at(lat, ts);
+
+        utils::progress_bar((float)lon, (float)(v_data_out[0].size()));
+    }
+    utils::progress_bar((float)(v_data_out[0].size()), (float)(v_data_out[0].size()));
+    std::cout << std::endl;
+    for (const CMethodsWorkspace& workspace : v_workspaces) add_status_counts(workspace);
+}
 
-        ds_reference->get_lat_timeseries_for_lon(v_reference_lat_data, lon);
-        ds_control->get_lat_timeseries_for_lon(v_control_lat_data, lon);
-        ds_scenario->get_lat_timeseries_for_lon(v_scenario_lat_data, lon);
+// number of values of the slabs of 2-dimensional data sets that are read at once
+static constexpr size_t max_block_values = (size_t)1 << 26;
 
-        for (unsigned lat = 0; lat < ds_scenario->n_lat; lat++) {
+/**
+ * Returns the number of neighbouring stations that are read at once, so
+ * that a slab of `n_time` time steps holds about `max_block_values` values
+ *
+ * @param n_stations number of stations of the data sets
+ * @param n_time (maximum) length of the time series
+ * @return stations per block, at least 1
+ */
+static size_t get_stations_per_block(size_t n_stations, size_t n_time) {
+    return std::max((size_t)1, std::min(n_stations, max_block_values / std::max(n_time, (size_t)1)));
+}
+
+/**
+ * Returns the slab of the adjusted time series of the stations
+ * [block, block + n_block), which is a view of `v_data_out` ([time][station])
+ * for float slabs and `v_buffer` otherwise (see `store_station_output_slab`)
+ *
+ * @param v_data_out results of all stations: [time][station]
+ * @param v_buffer buffer of the slab, if it is not stored as float
+ * @param block first station of the block
+ * @param n_block number of stations of the block
+ * @param n_time length of the time series
+ * @param n_stations number of stations
+ * @return the output slab
+ */
+template <typename T>
+static BasicSlab<T> get_station_output_slab(
+    std::vector<float>& v_data_out,
+    std::vector<T>& v_buffer,
+    size_t block,
+    size_t n_block,
+    size_t n_time,
+    size_t n_stations
+) {
+    if constexpr (std::is_same<T, float>::value) {
+        return BasicSlab<T>(v_data_out.data() + block, n_block, n_time, 1, n_stations);
+    } else {
+        v_buffer.resize(n_block * n_time);
+        return BasicSlab<T>(v_buffer.data(), n_block, n_time, SlabLayout::TimeCell);
+    }
+}
+
+/**
+ * Copies the adjusted time series of the stations [block, block + n_block)
+ * into `v_data_out` if they are not stored there already (see
+ * `get_station_output_slab`)
+ *
+ * @param v_data_out results of all stations: [time][station]
+ * @param output the output slab of the block
+ * @param block first station of the block
+ * @param n_stations number of stations
+ */
+template <typename T>
+static void store_station_output_slab(std::vector<float>& v_data_out, const BasicSlab<T>& output, size_t block, size_t n_stations) {
+    if constexpr (!std::is_same<T, float>::value) {
+        for (size_t ts = 0; ts < output.n_time; ts++)
+            for (size_t station = 0; station < output.n_cells; station++)
+                v_data_out[ts * n_stations + block + station] = output.at(station, ts);
+    }
+}
+
+/**
+ * Handles the adjustment of a 2-dimensional data set (time x station, e.g.
+ * a station network or an unstructured grid) by loading the input data in
+ * blocks of neighbouring stations
+ * -> Every block is read as one hyperslab [time][block] and split into
+ *    `n_jobs` slabs of neighbouring stations that are adjusted in parallel
+ *    like the latitudes of a longitude (see `adjust_3d`).
+ * -> The results are written directly into `v_data_out`.
+ *
+ * @param v_data_out vector that is used to store the bias adjusted results: [time][station]
+ */
+template <typename T>
+void Manager::adjust_2d(std::vector<float>& v_data_out) {
+    const size_t
+        n_stations = ds_scenario->n_stations,
+        n_output_time = ds_scenario->n_time,
+        n_time = std::max(ds_reference->n_time, std::max(ds_control->n_time, ds_scenario->n_time)),
+        n_per_block = get_stations_per_block(n_stations, n_time),
+        n_per_job = (n_per_block + n_jobs - 1) / n_jobs,
+        n_tasks = (n_per_block + n_per_job - 1) / n_per_job;
+
+    std::vector<float> v_buffer;
+    std::vector<T>
+        v_reference_slab,
+        v_control_slab,
+        v_scenario_slab,
+        v_output_slab;
+
+    set_threads_per_cell(n_tasks);
+    std::vector<CMethodsWorkspace> v_workspaces;
+    v_workspaces.reserve(n_tasks);
+    for (size_t job = 0; job < n_tasks; job++)
+        v_workspaces.emplace_back(n_time, adjustment_settings.n_quantiles);
+
+    std::vector<std::future<void>> tasks;
+    for (size_t block = 0; block < n_stations; block += n_per_block) {
+        const size_t n_block = std::min(n_per_block, n_stations - block);
+        read_slab([&](std::vector<float>& v) { ds_reference->get_station_slab(v, block, n_block); }, v_buffer, v_reference_slab);
+        read_slab([&](std::vector<float>& v) { ds_control->get_station_slab(v, block, n_block); }, v_buffer, v_control_slab);
+        read_slab([&](std::vector<float>& v) { ds_scenario->get_station_slab(v, block, n_block); }, v_buffer, v_scenario_slab);
+
+        const BasicSlab<T>
+            output = get_station_output_slab(v_data_out, v_output_slab, block, n_block, n_output_time, n_stations),
+            reference(v_reference_slab.data(), n_block, ds_reference->n_time, SlabLayout::TimeCell),
+            control(v_control_slab.data(), n_block, ds_control->n_time, SlabLayout::TimeCell),
+            scenario(v_scenario_slab.data(), n_block, ds_scenario->n_time, SlabLayout::TimeCell);
+
+        for (size_t first = 0, job = 0; first < n_block; first += n_per_job, job++) {
+            const size_t count = std::min(n_per_job, n_block - first);
             tasks.push_back(std::async(
-                &Manager::adjust_1d,
+                &Manager::adjust_slab<T>,
                 this,
-                std::ref(v_data_out[lat][lon]),
-                std::ref(v_reference_lat_data[lat]),
-                std::ref(v_control_lat_data[lat]),
-                std::ref(v_scenario_lat_data[lat])
+                output.get_cells(first, count),
+                reference.get_cells(first, count),
+                control.get_cells(first, count),
+                scenario.get_cells(first, count),
+                std::ref(v_workspaces[job])
             ));
+        }
+        for (auto& e : tasks) e.get();
+        tasks.clear();
+        store_station_output_slab(v_data_out, output, block, n_stations);
+
+        utils::progress_bar((float)block, (float)n_stations);
+    }
+    utils::progress_bar((float)n_stations, (float)n_stations);
+    std::cout << std::endl;
+    for (const CMethodsWorkspace& workspace : v_workspaces) add_status_counts(workspace);
+}
+
+/**
+ * Splits the `n_jobs` threads between the `n_tasks` slabs that are adjusted
+ * in parallel and the time chunks resp. days of the year within every grid
+ * cell, so that the CPUs are not oversubscribed
+ *
+ * @param n_tasks number of slabs that are processed in parallel
+ */
+void Manager::set_threads_per_cell(size_t n_tasks) {
+    adjustment_settings.n_threads = (unsigned)std::max((size_t)1, n_jobs / std::max(n_tasks, (size_t)1));
+    if (adjustment_settings.n_threads > 1)
+        log.info("Threads per grid cell: " + std::to_string(adjustment_settings.n_threads));
+}
+
+/**
+ * Adds the number of cells per status that were adjusted resp. fitted with
+ * the buffers of `workspace` to the summary of the run
+ *
+ * @param workspace buffers of a job
+ */
+void Manager::add_status_counts(const CMethodsWorkspace& workspace) {
+    for (unsigned status = 0; status < 4; status++) status_counts[status] += workspace.status_counts[status];
+}
+
+/**
+ * Logs how many grid cells were adjusted resp. fitted and how many were
+ * left unadjusted (completely or partially) because of missing or constant data
+ */
+void Manager::log_status_counts() {
+    std::string summary;
+    for (CellStatus status : {CellStatus::Ok, CellStatus::AllMissing, CellStatus::Constant, CellStatus::Fallback})
+        summary += (summary.empty() ? "" : ", ") + CMethods::get_cell_status_name(status) + ": " + std::to_string(status_counts[(int)status]);
+    log.info("Grid cells (" + summary + ")");
+    if (status_counts[(int)CellStatus::Fallback] > 0)
+        log.warning("Some days of the year or groups could not be adjusted because of missing or constant data and were left unchanged.");
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Transfer functions
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+/**
+ * Loads the adjustment settings that were used to fit the transfer functions
+ * of `ds_transfer` (see `fit_transfer_functions`)
+ */
+void Manager::read_transfer_settings() {
+    const std::string method_name = ds_transfer->get_attribute("method");
+    if (!adjustment_method_name.empty() && adjustment_method_name != method_name)
+        throw std::runtime_error("The transfer functions were fitted for " + method_name + ", not for " + adjustment_method_name + "!");
+
+    adjustment_method_name = method_name;
+    adjustment_settings.kind = CMethods::get_adjustment_kind(ds_transfer->get_attribute("kind"));
+    adjustment_settings.cdf_method = CMethods::get_cdf_method(ds_transfer->get_attribute("cdf"));
+    adjustment_settings.n_quantiles = (unsigned)std::stoi(ds_transfer->get_attribute("n_quantiles"));
+    adjustment_settings.interval31_scaling = ds_transfer->get_attribute("interval31_scaling") == "true";
+    adjustment_settings.max_scaling_factor = std::stod(ds_transfer->get_attribute("max_scaling_factor"));
+}
+
+/**
+ * Fits the transfer functions of all grid cells based on the reference and
+ * control period and saves them together with the adjustment settings, so
+ * that they can be applied to any number of scenarios (`--apply`) without
+ * loading the reference and control period again.
+ */
+void Manager::fit_transfer_functions() {
+    const size_t n_parameters = CMethods::get_n_parameters(
+        adjustment_method, adjustment_settings, ds_reference->n_time, ds_control->n_time
+    );
+
+    std::vector<double> v_parameters;
+    if (one_dim) {
+        std::vector<float>
+            v_reference((int)ds_reference->n_time),
+            v_control((int)ds_control->n_time);
+        ds_reference->get_timeseries(v_reference);
+        ds_control->get_timeseries(v_control);
+
+        v_parameters.resize(n_parameters);
+        CMethodsWorkspace workspace(std::max(v_reference.size(), v_control.size()), adjustment_settings.n_quantiles);
+        CMethods::Fit_Transfer_Function(
+            adjustment_method, v_parameters.data(), v_reference, v_control, adjustment_settings, workspace
+        );
+        status_counts[(int)workspace.status]++;
+    } else {
+        log.info("Starting the fitting ...");
+        dispatch_storage_type(storage_type, [&](auto value) {
+            if (station_dimension.empty())
+                fit_3d<decltype(value)>(v_parameters, n_parameters);
+            else
+                fit_2d<decltype(value)>(v_parameters, n_parameters);
+        });
+    }
+
+    std::vector<std::pair<std::string, std::string>> attributes = {
+        {"method", adjustment_method_name},
+        {"kind", get_adjustment_kind()},
+        {"cdf", CMethods::get_cdf_method_name(adjustment_settings.cdf_method)},
+        {"n_quantiles", std::to_string(adjustment_settings.n_quantiles)},
+        {"interval31_scaling", adjustment_settings.interval31_scaling ? "true" : "false"},
+        {"max_scaling_factor", std::to_string(adjustment_settings.max_scaling_factor)},
+    };
+    log.info("Saving: " + fit_filepath);
+    ds_reference->to_netcdf(fit_filepath, variable_name, v_parameters, (unsigned)n_parameters, attributes);
+}
+
+/**
+ * Invokes the fitting of the transfer functions for all grid cells of the
+ * given slabs
+ *
+ * @param v_parameters output array: [cell][n_parameters]
+ * @param n_parameters number of parameters per cell
+ * @param reference reference data (control period)
+ * @param control modeled data (control period)
+ * @param workspace buffers of the calling thread
+ */
+template <typename T>
+void Manager::fit_slab(double* v_parameters, size_t n_parameters, BasicSlab<T> reference, BasicSlab<T> control, CMethodsWorkspace& workspace) {
+    CMethods::Fit_Slab(adjustment_method, v_parameters, n_parameters, reference, control, adjustment_settings, workspace);
+}
+
+/**
+ * Fits the transfer functions of a 3-dimensional data set by loading the
+ * reference and control data per longitude (see `adjust_3d`)
+ *
+ * @param v_parameters output vector: [lat][lon][n_parameters]
+ * @param n_parameters number of parameters per grid cell
+ */
+template <typename T>
+void Manager::fit_3d(std::vector<double>& v_parameters, size_t n_parameters) {
+    const size_t
+        n_lat = ds_reference->n_lat,
+        n_lon = ds_reference->n_lon,
+        n_lat_per_job = (n_lat + n_jobs - 1) / n_jobs,
+        n_tasks = (n_lat + n_lat_per_job - 1) / n_lat_per_job;
+
+    std::vector<float> v_buffer;
+    std::vector<T> v_reference_slab, v_control_slab;
+    std::vector<double> v_lon_parameters(n_lat * n_parameters);
+    v_parameters.resize(n_lat * n_lon * n_parameters);
+
+    set_threads_per_cell(n_tasks);
+    std::vector<CMethodsWorkspace> v_workspaces;
+    v_workspaces.reserve(n_tasks);
+    for (size_t job = 0; job < n_tasks; job++)
+        v_workspaces.emplace_back(stream_sketches ? n_parameters : std::max(ds_reference->n_time, ds_control->n_time), adjustment_settings.n_quantiles);
+
+    std::vector<std::future<void>> tasks;
+    for (unsigned lon = 0; lon < n_lon; lon++) {
+        if (stream_sketches)
+            get_lon_parameters(v_lon_parameters, n_parameters, lon, v_workspaces);
+        else {
+            read_slab([&](std::vector<float>& v) { ds_reference->get_lat_slab_for_lon(v, lon); }, v_buffer, v_reference_slab);
+            read_slab([&](std::vector<float>& v) { ds_control->get_lat_slab_for_lon(v, lon); }, v_buffer, v_control_slab);
+
+            const BasicSlab<T>
+                reference(v_reference_slab.data(), n_lat, ds_reference->n_time, SlabLayout::TimeCell),
+                control(v_control_slab.data(), n_lat, ds_control->n_time, SlabLayout::TimeCell);
+
+            for (size_t first = 0, job = 0; first < n_lat; first += n_lat_per_job, job++) {
+                const size_t count = std::min(n_lat_per_job, n_lat - first);
+                tasks.push_back(std::async(
+                    &Manager::fit_slab<T>,
+                    this,
+                    &v_lon_parameters[first * n_parameters],
+                    n_parameters,
+                    reference.get_cells(first, count),
+                    control.get_cells(first, count),
+                    std::ref(v_workspaces[job])
+                ));
+            }
+            for (auto& e : tasks) e.get();
+            tasks.clear();
+        }
+
+        for (size_t lat = 0; lat < n_lat; lat++)
+            std::copy(
+                v_lon_parameters.begin() + lat * n_parameters,
+                v_lon_parameters.begin() + (lat + 1) * n_parameters,
+                v_parameters.begin() + (lat * n_lon + lon) * n_parameters
+            );
+
+        utils::progress_bar((float)lon, (float)n_lon);
+    }
+    utils::progress_bar((float)n_lon, (float)n_lon);
+    std::cout << std::endl;
+    for (const CMethodsWorkspace& workspace : v_workspaces) add_status_counts(workspace);
+}
+
+/**
+ * Fits the transfer functions of a 2-dimensional data set (time x station)
+ * by loading the reference and control data in blocks of neighbouring
+ * stations (see `adjust_2d`)
+ *
+ * @param v_parameters output vector: [station][n_parameters]
+ * @param n_parameters number of parameters per station
+ */
+template <typename T>
+void Manager::fit_2d(std::vector<double>& v_parameters, size_t n_parameters) {
+    const size_t
+        n_stations = ds_reference->n_stations,
+        n_time = std::max(ds_reference->n_time, ds_control->n_time),
+        n_per_block = get_stations_per_block(n_stations, n_time),
+        n_per_job = (n_per_block + n_jobs - 1) / n_jobs,
+        n_tasks = (n_per_block + n_per_job - 1) / n_per_job;
+
+    std::vector<float> v_buffer;
+    std::vector<T> v_reference_slab, v_control_slab;
+    std::vector<double> v_block_parameters;
+    v_parameters.resize(n_stations * n_parameters);
+
+    set_threads_per_cell(n_tasks);
+    std::vector<CMethodsWorkspace> v_workspaces;
+    v_workspaces.reserve(n_tasks);
+    for (size_t job = 0; job < n_tasks; job++)
+        v_workspaces.emplace_back(stream_sketches ? n_parameters : n_time, adjustment_settings.n_quantiles);
+
+    std::vector<std::future<void>> tasks;
+    for (size_t block = 0; block < n_stations; block += n_per_block) {
+        const size_t n_block = std::min(n_per_block, n_stations - block);
+        if (stream_sketches) {
+            get_station_parameters(v_block_parameters, n_parameters, block, n_block, v_workspaces);
+            std::copy(v_block_parameters.begin(), v_block_parameters.end(), v_parameters.begin() + block * n_parameters);
+        } else {
+            read_slab([&](std::vector<float>& v) { ds_reference->get_station_slab(v, block, n_block); }, v_buffer, v_reference_slab);
+            read_slab([&](std::vector<float>& v) { ds_control->get_station_slab(v, block, n_block); }, v_buffer, v_control_slab);
+
+            const BasicSlab<T>
+                reference(v_reference_slab.data(), n_block, ds_reference->n_time, SlabLayout::TimeCell),
+                control(v_control_slab.data(), n_block, ds_control->n_time, SlabLayout::TimeCell);
 
-            if (lat % n_jobs == 0 || ds_scenario->n_lat - 1 == lat) {
-                for (auto& e : tasks) e.get();
-                tasks.clear();
+            for (size_t first = 0, job = 0; first < n_block; first += n_per_job, job++) {
+                const size_t count = std::min(n_per_job, n_block - first);
+                tasks.push_back(std::async(
+                    &Manager::fit_slab<T>,
+                    this,
+                    &v_parameters[(block + first) * n_parameters],
+                    n_parameters,
+                    reference.get_cells(first, count),
+                    control.get_cells(first, count),
+                    std::ref(v_workspaces[job])
+                ));
             }
+            for (auto& e : tasks) e.get();
+            tasks.clear();
+        }
+
+        utils::progress_bar((float)block, (float)n_stations);
+    }
+    utils::progress_bar((float)n_stations, (float)n_stations);
+    std::cout << std::endl;
+    for (const CMethodsWorkspace& workspace : v_workspaces) add_status_counts(workspace);
+}
+
+// number of values of the reference and control period that are read at once to fill the quantile sketches
+static constexpr size_t max_sketch_chunk_values = (size_t)1 << 22;
+
+/**
+ * Fits the transfer functions of QM resp. QDM of `n_cells` neighbouring grid
+ * cells based on quantile sketches of the reference and control period
+ * (`--cdf sketch`). The sketches are filled time chunk by time chunk, so
+ * only a chunk of the time series of the reference and control period has
+ * to be kept in memory instead of the whole time series. The sketches of a
+ * stream equal those of the whole time series, so the results do not depend
+ * on the size of the chunks. The number of cells per `CellStatus` is added
+ * to the summary of the run.
+ *
+ * @param v_parameters output array: [cell][n_parameters]
+ * @param n_parameters number of parameters per cell
+ * @param n_cells number of grid cells
+ * @param read_reference function that reads the time steps [first_time, first_time + count_time)
+ *                       of the reference period of all cells: (v_out [time][cell], first_time, count_time)
+ * @param read_control like `read_reference`, for the control period
+ * @param v_workspaces buffers of the jobs, the cells are split between them
+ */
+template <typename ReadReference, typename ReadControl>
+void Manager::fit_sketches(
+    double* v_parameters,
+    size_t n_parameters,
+    size_t n_cells,
+    ReadReference read_reference,
+    ReadControl read_control,
+    std::vector<CMethodsWorkspace>& v_workspaces
+) {
+    const unsigned k = QuantileSketch::get_k(adjustment_settings.sketch_error);
+    const size_t
+        n_tasks = v_workspaces.size(),
+        n_per_job = (n_cells + n_tasks - 1) / n_tasks;
+    std::vector<QuantileSketch> v_reference_sketches(n_cells), v_control_sketches(n_cells);
+    for (size_t cell = 0; cell < n_cells; cell++) {
+        v_reference_sketches[cell].reset(k);
+        v_control_sketches[cell].reset(k);
+    }
+
+    // calls `f(first, last, job)` for the cells of every job in parallel
+    auto for_each_job = [&](auto f) {
+        std::vector<std::future<void>> tasks;
+        for (size_t first = 0, job = 0; first < n_cells; first += n_per_job, job++)
+            tasks.push_back(std::async(std::launch::async, f, first, std::min(first + n_per_job, n_cells), job));
+        for (auto& e : tasks) e.get();
+    };
+
+    // ? fill the sketches in chronological order, one time chunk after another
+    std::vector<float> v_chunk;
+    auto fill_sketches = [&](auto read, std::vector<QuantileSketch>& v_sketches, size_t n_time) {
+        const size_t n_chunk = std::max((size_t)1, max_sketch_chunk_values / std::max(n_cells, (size_t)1));
+        for (size_t first_time = 0; first_time < n_time; first_time += n_chunk) {
+            const size_t count_time = std::min(n_chunk, n_time - first_time);
+            read(v_chunk, first_time, count_time);
+            for_each_job([&](size_t first, size_t last, size_t) {
+                for (size_t ts = 0; ts < count_time; ts++)
+                    for (size_t cell = first; cell < last; cell++) v_sketches[cell].update(v_chunk[ts * n_cells + cell]);
+            });
+        }
+    };
+    fill_sketches(read_reference, v_reference_sketches, ds_reference->n_time);
+    fill_sketches(read_control, v_control_sketches, ds_control->n_time);
+
+    std::vector<CellStatus> v_status(n_cells);
+    for_each_job([&](size_t first, size_t last, size_t job) {
+        for (size_t cell = first; cell < last; cell++) {
+            CMethods::Fit_Transfer_Function(
+                adjustment_method, v_parameters + cell * n_parameters,
+                v_reference_sketches[cell], v_control_sketches[cell], adjustment_settings, v_workspaces[job]
+            );
+            v_status[cell] = v_workspaces[job].status;
+        }
+    });
+    for (CellStatus status : v_status) status_counts[(int)status]++;
+}
+
+/**
+ * Loads the parameters of the transfer functions of all latitudes of the
+ * longitude `lon` from `ds_transfer` (`--apply`) or fits them based on the
+ * quantile sketches of the reference and control period (see `fit_sketches`)
+ *
+ * @param v_lon_parameters output vector: [lat][n_parameters]
+ * @param n_parameters number of parameters per grid cell
+ * @param lon index of the longitude
+ * @param v_workspaces buffers of the jobs
+ */
+void Manager::get_lon_parameters(std::vector<double>& v_lon_parameters, size_t n_parameters, unsigned lon, std::vector<CMethodsWorkspace>& v_workspaces) {
+    if (ds_transfer != nullptr) {
+        ds_transfer->get_parameter_slab_for_lon(v_lon_parameters, lon);
+        return;
+    }
+    v_lon_parameters.resize((size_t)ds_reference->n_lat * n_parameters);
+    fit_sketches(
+        v_lon_parameters.data(), n_parameters, ds_reference->n_lat,
+        [&](std::vector<float>& v, size_t first_time, size_t count_time) { ds_reference->get_lat_slab_for_lon(v, lon, first_time, count_time); },
+        [&](std::vector<float>& v, size_t first_time, size_t count_time) { ds_control->get_lat_slab_for_lon(v, lon, first_time, count_time); },
+        v_workspaces
+    );
+}
+
+/**
+ * Loads the parameters of the transfer functions of the stations
+ * [block, block + n_block) from `ds_transfer` (`--apply`) or fits them based
+ * on the quantile sketches of the reference and control period (see
+ * `fit_sketches`)
+ *
+ * @param v_block_parameters output vector: [station][n_parameters]
+ * @param n_parameters number of parameters per station
+ * @param block first station of the block
+ * @param n_block number of stations of the block
+ * @param v_workspaces buffers of the jobs
+ */
+void Manager::get_station_parameters(std::vector<double>& v_block_parameters, size_t n_parameters, size_t block, size_t n_block, std::vector<CMethodsWorkspace>& v_workspaces) {
+    if (ds_transfer != nullptr) {
+        ds_transfer->get_parameter_slab_for_stations(v_block_parameters, block, n_block);
+        return;
+    }
+    v_block_parameters.resize(n_block * n_parameters);
+    fit_sketches(
+        v_block_parameters.data(), n_parameters, n_block,
+        [&](std::vector<float>& v, size_t first_time, size_t count_time) { ds_reference->get_station_slab(v, block, n_block, first_time, count_time); },
+        [&](std::vector<float>& v, size_t first_time, size_t count_time) { ds_control->get_station_slab(v, block, n_block, first_time, count_time); },
+        v_workspaces
+    );
+}
+
+/**
+ * Invokes the application of the transfer functions for all grid cells of
+ * the given slab
+ *
+ * @param output slab to store the adjusted time series in
+ * @param v_parameters parameters of the transfer functions: [cell][n_parameters]
+ * @param n_parameters number of parameters per cell
+ * @param scenario data to adjust (scenario period)
+ * @param workspace buffers of the calling thread
+ */
+template <typename T>
+void Manager::apply_slab(BasicSlab<T> output, const double* v_parameters, size_t n_parameters, BasicSlab<T> scenario, CMethodsWorkspace& workspace) {
+    CMethods::Apply_Slab(adjustment_method, output, v_parameters, n_parameters, scenario, adjustment_settings, workspace);
+}
+
+/**
+ * Adjusts a 3-dimensional data set by the transfer functions of
+ * `ds_transfer`, which are loaded per longitude together with the scenario
+ * data (see `adjust_3d`). Without `ds_transfer` (`stream_sketches`), the
+ * transfer functions of every longitude are fitted from quantile sketches
+ * of the reference and control period first (see `get_lon_parameters`).
+ *
+ * @param v_data_out 3D vector that is used to store the bias adjusted results
+ */
+template <typename T>
+void Manager::apply_3d(std::vector<std::vector<std::vector<float>>>& v_data_out) {
+    const size_t
+        n_lat = ds_scenario->n_lat,
+        n_time = ds_scenario->n_time,
+        n_parameters = (ds_transfer != nullptr)
+                           ? ds_transfer->n_parameters
+                           : CMethods::get_n_parameters(adjustment_method, adjustment_settings, ds_reference->n_time, ds_control->n_time),
+        n_lat_per_job = (n_lat + n_jobs - 1) / n_jobs,
+        n_tasks = (n_lat + n_lat_per_job - 1) / n_lat_per_job;
+
+    std::vector<float> v_buffer;
+    std::vector<T>
+        v_scenario_slab,
+        v_output_slab(n_time * n_lat);
+    std::vector<double> v_lon_parameters;
+
+    set_threads_per_cell(n_tasks);
+    std::vector<CMethodsWorkspace> v_workspaces;
+    v_workspaces.reserve(n_tasks);
+    for (size_t job = 0; job < n_tasks; job++)
+        v_workspaces.emplace_back(std::max(n_time, n_parameters), adjustment_settings.n_quantiles);
+
+    std::vector<std::future<void>> tasks;
+    for (unsigned lon = 0; lon < ds_scenario->n_lon; lon++) {
+        read_slab([&](std::vector<float>& v) { ds_scenario->get_lat_slab_for_lon(v, lon); }, v_buffer, v_scenario_slab);
+        get_lon_parameters(v_lon_parameters, n_parameters, lon, v_workspaces);
+
+        const BasicSlab<T>
+            output(v_output_slab.data(), n_lat, n_time, SlabLayout::TimeCell),
+            scenario(v_scenario_slab.data(), n_lat, n_time, SlabLayout::TimeCell);
+
+        for (size_t first = 0, job = 0; first < n_lat; first += n_lat_per_job, job++) {
+            const size_t count = std::min(n_lat_per_job, n_lat - first);
+            tasks.push_back(std::async(
+                &Manager::apply_slab<T>,
+                this,
+                output.get_cells(first, count),
+                &v_lon_parameters[first * n_parameters],
+                n_parameters,
+                scenario.get_cells(first, count),
+                std::ref(v_workspaces[job])
+            ));
         }
+        for (auto& e : tasks) e.get();
+        tasks.clear();
+
+        for (size_t lat = 0; lat < n_lat; lat++)
+            for (size_t ts = 0; ts < n_time; ts++)
+                v_data_out[lat][lon][ts] = output.at(lat, ts);
+
         utils::progress_bar((float)lon, (float)(v_data_out[0].size()));
     }
     utils::progress_bar((float)(v_data_out[0].size()), (float)(v_data_out[0].size()));
     std::cout << std::endl;
+    // the statuses of the sketches were counted by `fit_sketches`, the application only falls back for them
+    if (ds_transfer != nullptr)
+        for (const CMethodsWorkspace& workspace : v_workspaces) add_status_counts(workspace);
+}
+
+/**
+ * Adjusts a 2-dimensional data set (time x station) by the transfer
+ * functions of `ds_transfer`, which are loaded in blocks of neighbouring
+ * stations together with the scenario data (see `adjust_2d`). Without
+ * `ds_transfer` (`stream_sketches`), the transfer functions of every block
+ * are fitted from quantile sketches of the reference and control period
+ * first (see `get_station_parameters`).
+ *
+ * @param v_data_out vector that is used to store the bias adjusted results: [time][station]
+ */
+template <typename T>
+void Manager::apply_2d(std::vector<float>& v_data_out) {
+    const size_t
+        n_stations = ds_scenario->n_stations,
+        n_time = ds_scenario->n_time,
+        n_parameters = (ds_transfer != nullptr)
+                           ? ds_transfer->n_parameters
+                           : CMethods::get_n_parameters(adjustment_method, adjustment_settings, ds_reference->n_time, ds_control->n_time),
+        n_per_block = get_stations_per_block(n_stations, n_time),
+        n_per_job = (n_per_block + n_jobs - 1) / n_jobs,
+        n_tasks = (n_per_block + n_per_job - 1) / n_per_job;
+
+    std::vector<float> v_buffer;
+    std::vector<T> v_scenario_slab, v_output_slab;
+    std::vector<double> v_block_parameters;
+
+    set_threads_per_cell(n_tasks);
+    std::vector<CMethodsWorkspace> v_workspaces;
+    v_workspaces.reserve(n_tasks);
+    for (size_t job = 0; job < n_tasks; job++)
+        v_workspaces.emplace_back(std::max(n_time, n_parameters), adjustment_settings.n_quantiles);
+
+    std::vector<std::future<void>> tasks;
+    for (size_t block = 0; block < n_stations; block += n_per_block) {
+        const size_t n_block = std::min(n_per_block, n_stations - block);
+        read_slab([&](std::vector<float>& v) { ds_scenario->get_station_slab(v, block, n_block); }, v_buffer, v_scenario_slab);
+        get_station_parameters(v_block_parameters, n_parameters, block, n_block, v_workspaces);
+
+        const BasicSlab<T>
+            output = get_station_output_slab(v_data_out, v_output_slab, block, n_block, n_time, n_stations),
+            scenario(v_scenario_slab.data(), n_block, n_time, SlabLayout::TimeCell);
+
+        for (size_t first = 0, job = 0; first < n_block; first += n_per_job, job++) {
+            const size_t count = std::min(n_per_job, n_block - first);
+            tasks.push_back(std::async(
+                &Manager::apply_slab<T>,
+                this,
+                output.get_cells(first, count),
+                &v_block_parameters[first * n_parameters],
+                n_parameters,
+                scenario.get_cells(first, count),
+                std::ref(v_workspaces[job])
+            ));
+        }
+        for (auto& e : tasks) e.get();
+        tasks.clear();
+        store_station_output_slab(v_data_out, output, block, n_stations);
+
+        utils::progress_bar((float)block, (float)n_stations);
+    }
+    utils::progress_bar((float)n_stations, (float)n_stations);
+    std::cout << std::endl;
+    // the statuses of the sketches were counted by `fit_sketches`, the application only falls back for them
+    if (ds_transfer != nullptr)
+        for (const CMethodsWorkspace& workspace : v_workspaces) add_status_counts(workspace);
 }
@@ -35,6 +35,9 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 /**
@@ -103,7 +106,8 @@ Func_two MathUtils::get_method_for_2_ds(std::string name) {
  * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
  */
 
-/** Returns the correlation coefficient for given `x` and `y` vectors
+/** Returns the correlation coefficient for given `x` and `y` vectors,
+ * pairs that contain nan are ignored
  *
  * References:
  *  - https://www.geeksforgeeks.org/program-find-correlation-coefficient/
@@ -116,6 +120,8 @@ Func_two MathUtils::get_method_for_2_ds(std::string name) {
  *              \left[n\sum{x^{2}} - \sum(x)^{2}\right] \left[n\sum{y^{2}} - (\sum{y})^{2}\right]
  *          }
  *      }$
+ *  computed from the co-moment and the sums of squared deviations
+ *  (see `PairedMoments`), which does not suffer from cancellation.
  *
  * @param x 1D reference time series/vector
  * @param y 1D prediction time series/vector
@@ -123,25 +129,12 @@ Func_two MathUtils::get_method_for_2_ds(std::string name) {
  */
 double MathUtils::correlation_coefficient(std::vector<float>& x, std::vector<float>& y) {
     if (x.size() != y.size()) throw std::runtime_error("Cannot calculate correlation coefficient of vectors with different size.");
-    double
-        sum_X = 0,
-        sum_Y = 0,
-        sum_XY = 0,
-        squareSum_X = 0,
-        squareSum_Y = 0;
-
-    for (unsigned ts = 0; ts < x.size(); ts++) {
-        sum_X = sum_X + x[ts];            // sum of elements of array x.
-        sum_Y = sum_Y + y[ts];            // sum of elements of array y.
-        sum_XY = sum_XY + x[ts] * y[ts];  // sum of x[i] * y[i].
-        // sum of square of array elements.
-        squareSum_X = squareSum_X + x[ts] * x[ts];
-        squareSum_Y = squareSum_Y + y[ts] * y[ts];
-    }
-    return (x.size() * sum_XY - sum_X * sum_Y) / sqrt((x.size() * squareSum_X - sum_X * sum_X) * (x.size() * squareSum_Y - sum_Y * sum_Y));
+    PairedMoments moments;
+    moments.update(x.data(), y.data(), x.size());
+    return moments.get_correlation();
 }
 
-/** Returns the Root Mean Square Error
+/** Returns the Root Mean Square Error, pairs that contain nan are ignored
  *   RMSE = \sqrt{
  *             \frac{
  *                \sum_{i=1}^{n}(T_{y,i} - T_{x,i})^{2}
@@ -156,13 +149,12 @@ double MathUtils::correlation_coefficient(std::vector<float>& x, std::vector<flo
  */
 double MathUtils::rmse(std::vector<float>& x, std::vector<float>& y) {
     if (x.size() != y.size()) throw std::runtime_error("Cannot calculate rmse of vectors with different size.");
-
-    double result = 0;
-    for (unsigned ts = 0; ts < x.size(); ts++) result += pow(y[ts] - x[ts], 2) / (int)x.size();
-    return sqrt(result);
+    PairedMoments moments;
+    moments.update(x.data(), y.data(), x.size());
+    return moments.get_rmse();
 }
 
-/** Returns the Mean Bias Error
+/** Returns the Mean Bias Error, pairs that contain nan are ignored
  *  $MBE = \frac{1}{n} \sum_{i=1}^{n}(T_{y,i} - T_{x,i})$
  *
  * @param x 1D reference time series/vector
@@ -171,13 +163,55 @@ double MathUtils::rmse(std::vector<float>& x, std::vector<float>& y) {
  */
 double MathUtils::mbe(std::vector<float>& x, std::vector<float>& y) {
     if (x.size() != y.size()) throw std::runtime_error("Cannot calculate mbe of vectors with different size.");
+    PairedMoments moments;
+    moments.update(x.data(), y.data(), x.size());
+    return moments.get_mbe();
+}
+
+/**
+ * Returns the term of one pair in the denominator of the index of agreement
+ * (see `MathUtils::ioa`), 0 if the pair contains nan
+ *
+ * @param mean_x mean of the reference values
+ * @param xi reference value
+ * @param yi predicted value
+ * @return squared sum of the absolute deviations from `mean_x`
+ */
+static inline double get_ioa_term(double mean_x, double xi, double yi) {
+    const double deviation = std::abs(yi - mean_x) + std::abs(xi - mean_x);
+    return (xi == xi && yi == yi) ? deviation * deviation : 0.0;  // comparisons with nan are false
+}
+
+/**
+ * Returns the index of agreement of pairs
+ *
+ * @param moments statistics of the pairs
+ * @param denominator sum of `get_ioa_term` over the pairs
+ * @return index of agreement
+ */
+static inline double get_ioa(const PairedMoments& moments, double denominator) {
+    return 1 - moments.get_sum_of_squared_errors() / denominator;
+}
 
-    double result = 0;
-    for (unsigned ts = 0; ts < x.size(); ts++) result += y[ts] - x[ts];
-    return result * (double(1.0) / (int)x.size());
+/**
+ * Returns the index of agreement based on the statistics of the first pass
+ * over the pairs (see `MathUtils::ioa`). The denominator needs the mean of
+ * `x`, so it is summed in a second pass.
+ *
+ * @param x reference values
+ * @param y predicted values
+ * @param n_values number of pairs
+ * @param moments statistics of the same pairs
+ * @return index of agreement
+ */
+static double get_ioa(const float* x, const float* y, size_t n_values, const PairedMoments& moments) {
+    const double mean_x = moments.get_mean_x();
+    double denominator = 0;
+    for (size_t i = 0; i < n_values; i++) denominator += get_ioa_term(mean_x, x[i], y[i]);
+    return get_ioa(moments, denominator);
 }
 
-/** Returns the index of agreement
+/** Returns the index of agreement, pairs that contain nan are ignored
  *  $d = 1 - \frac{
  *       \sum^{n}_{i=1}(T_{obs,p,i} - T_{sim,p}(i))^{2}
  *      }{
@@ -191,68 +225,309 @@ double MathUtils::mbe(std::vector<float>& x, std::vector<float>& y) {
  */
 double MathUtils::ioa(std::vector<float>& x, std::vector<float>& y) {
     if (x.size() != y.size()) throw std::runtime_error("Cannot calculate ioa of vectors with different size.");
+    PairedMoments moments;
+    moments.update(x.data(), y.data(), x.size());
+    return get_ioa(x.data(), y.data(), x.size(), moments);
+}
 
-    double upper = 0, lower = 0;
-    const double m = mean(x);
-    for (unsigned i = 0; i < x.size(); i++) {
-        upper += pow(x[i] - y[i], 2);
-        lower += pow(abs(y[i] - m) + abs(x[i] - m), 2);
+/**
+ * Checks that all `v_names` are available indicators and determines which
+ * statistics they need
+ *
+ * @param v_names names of the indicators
+ * @param one_ds output: true if an indicator of `requires_1_ds` is requested
+ * @param two_ds output: true if an indicator of `requires_2_ds` is requested
+ */
+static void check_indicators(const std::vector<std::string>& v_names, bool& one_ds, bool& two_ds) {
+    one_ds = two_ds = false;
+    for (const std::string& name : v_names) {
+        if (std::find(MathUtils::requires_1_ds.begin(), MathUtils::requires_1_ds.end(), name) != MathUtils::requires_1_ds.end())
+            one_ds = true;
+        else if (std::find(MathUtils::requires_2_ds.begin(), MathUtils::requires_2_ds.end(), name) != MathUtils::requires_2_ds.end())
+            two_ds = true;
+        else
+            throw std::runtime_error("Unknown indicator " + name + "!");
     }
-    return (1 - (upper / lower));
 }
 
-/** Returns the variance
- *  $\sigma^{2}(x) = \frac{\sum_{i=1}^{n}(x_{i} - \mu(x)^{2}}{n-1}$
+/**
+ * Returns the indicator `name` based on the accumulated statistics, except
+ * "ioa" which needs a second pass over the values
+ *
+ * @param name name of the indicator
+ * @param moments statistics of the (first) time series
+ * @param paired_moments statistics of the pairs of both time series
+ * @return value of the indicator
+ */
+static double get_indicator(const std::string& name, const Moments& moments, const PairedMoments& paired_moments) {
+    if (name == "sd")
+        return moments.get_sd();
+    else if (name == "var")
+        return moments.get_variance();
+    else if (name == "mean")
+        return moments.get_mean();
+    else if (name == "rmse")
+        return paired_moments.get_rmse();
+    else if (name == "mbe")
+        return paired_moments.get_mbe();
+    else if (name == "corr")
+        return paired_moments.get_correlation();
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * Computes several indicators of the same time series (or pair of time
+ * series) at once. All statistics are accumulated in a single pass over
+ * the values, only "ioa" needs a second pass. The results are the same as
+ * the ones of the functions returned by `get_method_for_1_ds` and
+ * `get_method_for_2_ds`.
+ *
+ * @param v_names names of the indicators (see `available_methods`)
+ * @param x values of the (first) time series
+ * @param y values of the second time series, only required by the methods of `requires_2_ds`
+ * @param n_values number of time steps
+ * @param v_results output array, one result per name
+ */
+void MathUtils::compute_indicators(const std::vector<std::string>& v_names, const float* x, const float* y, size_t n_values, double* v_results) {
+    bool one_ds, two_ds;
+    check_indicators(v_names, one_ds, two_ds);
+    if (two_ds && y == nullptr) throw std::runtime_error("The indicators require two time series!");
+
+    Moments moments;
+    PairedMoments paired_moments;
+    if (one_ds) moments.update(x, n_values);
+    if (two_ds) paired_moments.update(x, y, n_values);
+
+    for (size_t i = 0; i < v_names.size(); i++)
+        v_results[i] = (v_names[i] == "ioa") ? get_ioa(x, y, n_values, paired_moments)
+                                             : get_indicator(v_names[i], moments, paired_moments);
+}
+
+/** Returns the (population) variance, nan values are ignored
+ *  $\sigma^{2}(x) = \frac{\sum_{i=1}^{n}(x_{i} - \mu(x))^{2}}{n}$
  *
  * @param x 1D vector of interest
- * @return variance of `x`
+ * @return variance of `x`, nan if `x` has no valid values
  */
 double MathUtils::variance(std::vector<float>& x) {
-    std::vector<double> v(x.size());
-    const double m = mean(x);
-    for (unsigned i = 0; i < x.size(); i++) v[i] = pow(x[i] - m, 2);
-    return mean(v);
+    Moments moments;
+    moments.update(x);
+    return moments.get_variance();
 }
 
-/** Returns the standard deviation
- *  $\sigma(x) = \sqrt{\frac{\sum_{i=1}^{n}(x_{i}-\mu(x)^{2}}{n-1}}$
+/** Returns the (population) standard deviation, nan values are ignored
+ *  $\sigma(x) = \sqrt{\frac{\sum_{i=1}^{n}(x_{i}-\mu(x))^{2}}{n}}$
  *
  * @param x 1D vector of interest
- * @return standard deviation of `x`
+ * @return standard deviation of `x`, nan if `x` has no valid values
  */
 double MathUtils::sd(std::vector<float>& x) {
-    return sqrt(variance(x));
+    Moments moments;
+    moments.update(x);
+    return moments.get_sd();
 }
 
-/** Returns the mean
+/** Returns the mean, nan values are ignored
  *
  * @param a 1D vector of floats/doubles to get the mean from
- * @return mean of `a`
+ * @return mean of `a`, nan if `a` has no valid values
  */
 double MathUtils::mean(std::vector<float>& a) {
-    double sum = 0;
-    for (unsigned i = 0; i < a.size(); i++) sum += a[i];
-    return sum / a.size();
+    Moments moments;
+    moments.update(a);
+    return moments.get_mean();
 }
 double MathUtils::mean(std::vector<double>& a) {
-    double sum = 0;
-    for (unsigned i = 0; i < a.size(); i++) sum += a[i];
-    return sum / a.size();
+    Moments moments;
+    moments.update(a.data(), a.size());
+    return moments.get_mean();
+}
+
+/**
+ * Copies the valid values of `values` into `v_scratch`, nan values are
+ * skipped. The capacity of `v_scratch` is kept, so that it can be reused.
+ *
+ * @param values values to copy
+ * @param n_values number of values
+ * @param v_scratch output buffer, resized to the number of valid values
+ */
+template <typename T>
+static void copy_valid(const T* values, size_t n_values, std::vector<T>& v_scratch) {
+    v_scratch.resize(n_values);
+    size_t n_valid = 0;
+    for (size_t i = 0; i < n_values; i++) {
+        v_scratch[n_valid] = values[i];
+        n_valid += !std::isnan(values[i]);
+    }
+    v_scratch.resize(n_valid);
+}
+
+/**
+ * Returns the index of the `p`-quantile within `n_values` sorted values,
+ * i.e. the smallest value whose rank exceeds `p * n_values`, like
+ * `QuantileSketch::get_quantile`. The median is the value at index
+ * `n_values / 2`.
+ *
+ * @param n_values number of (valid) values, must be greater than 0
+ * @param p probability between 0 and 1
+ * @return index within the sorted values
+ */
+static size_t get_quantile_index(size_t n_values, double p) {
+    if (!(p >= 0 && p <= 1)) throw std::runtime_error("Probabilities of quantiles must be between 0 and 1!");
+    return std::min((size_t)(p * n_values), n_values - 1);
+}
+
+/**
+ * Moves the values at the sorted indices `[first, last)` to their sorted
+ * positions within `values[lo, hi)` and stores them in `v_quantiles`. The
+ * middle index is selected first, the indices on either side are selected
+ * within the corresponding partition only, so that each level of the
+ * recursion touches every value at most once.
+ *
+ * @param values values to partition
+ * @param lo first position of the current partition
+ * @param hi end of the current partition
+ * @param first first pair of (sorted index, position in `v_quantiles`)
+ * @param last end of the pairs
+ * @param v_quantiles output values
+ */
+template <typename T>
+static void select_indices(T* values, size_t lo, size_t hi, const std::pair<size_t, size_t>* first, const std::pair<size_t, size_t>* last, double* v_quantiles) {
+    if (first == last) return;
+    const std::pair<size_t, size_t>* middle = first + (last - first) / 2;
+    const size_t index = middle->first;
+    std::nth_element(values + lo, values + index, values + hi);
+
+    // ? the same index may be requested more than once
+    const std::pair<size_t, size_t>
+        *equal_first = middle,
+        *equal_last = middle + 1;
+    while (equal_first > first && (equal_first - 1)->first == index) equal_first--;
+    while (equal_last < last && equal_last->first == index) equal_last++;
+    for (const std::pair<size_t, size_t>* it = equal_first; it < equal_last; it++) v_quantiles[it->second] = values[index];
+
+    select_indices(values, lo, index, first, equal_first, v_quantiles);
+    select_indices(values, index + 1, hi, equal_last, last, v_quantiles);
 }
 
-/** Returns the median
+/**
+ * Selects the `p`-quantile of the valid values of `values` in `v_scratch`
+ * (see `MathUtils::quantile`)
+ */
+template <typename T>
+static double select_quantile(const T* values, size_t n_values, double p, std::vector<T>& v_scratch) {
+    copy_valid(values, n_values, v_scratch);
+    const size_t index = get_quantile_index(std::max(v_scratch.size(), (size_t)1), p);
+    if (v_scratch.empty()) return std::numeric_limits<double>::quiet_NaN();
+    std::nth_element(v_scratch.begin(), v_scratch.begin() + index, v_scratch.end());
+    return v_scratch[index];
+}
+
+/**
+ * Returns the median of `a` without modifying `a`, nan values are ignored.
+ * For an even number of values the upper one of the two middle values
+ * is returned.
  *
  * @param a 1D vector of floats/doubles to get the median from
- * @return median of `a`
+ * @return median of `a`, nan if `a` has no valid values
  */
+float MathUtils::median(const std::vector<float>& a) {
+    std::vector<float> v_scratch;
+    return (float)select_quantile(a.data(), a.size(), 0.5, v_scratch);
+}
+double MathUtils::median(const std::vector<double>& a) {
+    std::vector<double> v_scratch;
+    return select_quantile(a.data(), a.size(), 0.5, v_scratch);
+}
 
-float MathUtils::median(std::vector<float>& a) {
-    std::sort(a.begin(), a.end());
-    return a[(int)(a.size() / 2)];
+/**
+ * Returns the `p`-quantile of `values` using selection instead of sorting
+ * (O(n) on average), nan values are ignored and `values` is not modified.
+ *
+ * @param values values to get the quantile from
+ * @param n_values number of values
+ * @param p probability between 0 and 1
+ * @param v_scratch buffer that is reused between calls
+ * @return the quantile, nan if there are no valid values
+ */
+double MathUtils::quantile(const float* values, size_t n_values, double p, std::vector<float>& v_scratch) {
+    return select_quantile(values, n_values, p, v_scratch);
 }
-double MathUtils::median(std::vector<double>& a) {
-    std::sort(a.begin(), a.end());
-    return a[(int)(a.size() / 2)];
+
+/**
+ * Computes several quantiles of `values` at once, nan values are ignored
+ * and `values` is not modified. The selections partition the values
+ * recursively (see `select_indices`), so that k quantiles cost about
+ * O(n log k) instead of O(n k) for separate selections.
+ *
+ * @param values values to get the quantiles from
+ * @param n_values number of values
+ * @param v_probabilities probabilities between 0 and 1 in any order
+ * @param v_quantiles output, one quantile per probability (nan if there are no valid values)
+ * @param v_scratch buffer that is reused between calls
+ */
+void MathUtils::quantiles(const float* values, size_t n_values, const std::vector<double>& v_probabilities, std::vector<double>& v_quantiles, std::vector<float>& v_scratch) {
+    copy_valid(values, n_values, v_scratch);
+    v_quantiles.assign(v_probabilities.size(), std::numeric_limits<double>::quiet_NaN());
+
+    std::vector<std::pair<size_t, size_t>> v_indices(v_probabilities.size());
+    for (size_t i = 0; i < v_probabilities.size(); i++)
+        v_indices[i] = std::make_pair(get_quantile_index(std::max(v_scratch.size(), (size_t)1), v_probabilities[i]), i);
+    if (v_scratch.empty()) return;
+
+    std::sort(v_indices.begin(), v_indices.end());
+    select_indices(v_scratch.data(), 0, v_scratch.size(), v_indices.data(), v_indices.data() + v_indices.size(), v_quantiles.data());
+}
+
+/**
+ * Counts the values of `arr` per bin. Values smaller than the first bin
+ * are assigned to the first bin, values that are greater or equal than
+ * the second last boundary to the last bin; nan values are not counted.
+ *
+ * The bin of each value is estimated based on the average bin width and
+ * corrected using the neighbouring boundaries, so the result does not
+ * depend on evenly spaced bins but is found in constant time if they are.
+ * The estimation is done block-wise in a branch-free loop that can be
+ * vectorized by the compiler.
+ *
+ * @param arr values to assign to the bins
+ * @param n_values number of values
+ * @param bins probability boundaries
+ * @param counts output array with at least `bins.size() - 1` zero-initialized entries
+ */
+template <typename T>
+static void count_per_bin(const float* arr, size_t n_values, const std::vector<double>& bins, T* counts) {
+    const int n_bins = (int)bins.size() - 1;
+    if (n_bins < 2) return;  // no value can be assigned
+
+    const double
+        first = bins[0],
+        width = bins[n_bins] - first,
+        inverse_step = (width > 0) ? n_bins / width : 0,
+        max_position = n_bins - 1;
+
+    constexpr unsigned block_size = 256;
+    double positions[block_size];
+    for (size_t start = 0; start < n_values; start += block_size) {
+        const unsigned length = (unsigned)std::min((size_t)block_size, n_values - start);
+        const float* values = arr + start;
+
+        // ? estimate the bin index - nan values are kept as nan
+        for (unsigned j = 0; j < length; j++) {
+            const double position = (values[j] - first) * inverse_step;
+            positions[j] = std::min(std::max(position, 0.0), max_position);
+        }
+
+        // ? correct the estimation and count
+        for (unsigned j = 0; j < length; j++) {
+            const double value = values[j];
+            if (std::isnan(value)) continue;
+            int i = (int)positions[j];
+            while (i < n_bins - 1 && value >= bins[i + 1]) i++;
+            while (i > 0 && value < bins[i]) i--;
+            ++counts[i];
+        }
+    }
 }
 
 /**
@@ -267,20 +542,7 @@ double MathUtils::median(std::vector<double>& a) {
  */
 std::vector<int> MathUtils::get_pdf(std::vector<float>& arr, std::vector<double>& bins) {
     std::vector<int> v_pdf(bins.size() - 1);
-    for (unsigned ts = 0; ts < arr.size(); ts++) {
-        for (unsigned i = 0; i < v_pdf.size() - 1; i++) {
-            if (i == 0 && arr[ts] <= bins[i]) {
-                ++v_pdf[i];
-                break;
-            } else if (arr[ts] >= bins[i] && arr[ts] < bins[i + 1]) {
-                ++v_pdf[i];
-                break;
-            } else if (i == v_pdf.size() - 2 && arr[ts] >= bins[i + 1]) {
-                ++v_pdf[i + 1];
-                break;
-            }
-        }
-    }
+    count_per_bin(arr.data(), arr.size(), bins, v_pdf.data());
     return v_pdf;
 }
 
@@ -293,13 +555,45 @@ std::vector<int> MathUtils::get_pdf(std::vector<float>& arr, std::vector<double>
  * @return cumulative distribution function of `arr` based on `bins` as int vector
  */
 std::vector<int> MathUtils::get_cdf(std::vector<float>& arr, std::vector<double>& bins) {
-    std::vector<int> v_pdf = MathUtils::get_pdf(arr, bins);
-    std::vector<int> v_cdf(v_pdf.size() + 1);
-    v_cdf[0] = 0;
-    for (unsigned i = 0; i < v_pdf.size(); i++)
-        v_cdf[i + 1] = v_cdf[i] + v_pdf[i];
+    std::vector<int> v_cdf(bins.size());
+    count_per_bin(arr.data(), arr.size(), bins, v_cdf.data() + 1);
+    for (unsigned i = 1; i < v_cdf.size(); i++)
+        v_cdf[i] += v_cdf[i - 1];
     return v_cdf;
 }
+
+/**
+ * Computes the Cumulative Distribution Function (CDF) like
+ * `MathUtils::get_cdf` above, but into a caller-provided buffer of
+ * doubles, so that it can be used directly for the interpolation and
+ * reused across grid cells.
+ *
+ * @param arr 1D vector to compute the CDF from
+ * @param bins probability boundaries to assign the probabilities
+ * @param v_cdf output vector, will be resized to `bins.size()`
+ */
+void MathUtils::get_cdf(std::vector<float>& arr, std::vector<double>& bins, std::vector<double>& v_cdf) {
+    v_cdf.resize(bins.size());
+    get_cdf(arr.data(), arr.size(), bins, v_cdf.data());
+}
+
+/**
+ * Computes the Cumulative Distribution Function (CDF) of a part of a time
+ * series, e.g. of a chunk of time steps. The counts are whole numbers, so
+ * the CDFs of the chunks of a time series add up to its CDF exactly.
+ *
+ * @param arr values to compute the CDF from
+ * @param n_values number of values
+ * @param bins probability boundaries to assign the probabilities
+ * @param v_cdf output array (length: `bins.size()`)
+ */
+void MathUtils::get_cdf(const float* arr, size_t n_values, const std::vector<double>& bins, double* v_cdf) {
+    std::fill(v_cdf, v_cdf + bins.size(), 0.0);
+    count_per_bin(arr, n_values, bins, v_cdf + 1);
+    for (unsigned i = 1; i < bins.size(); i++)
+        v_cdf[i] += v_cdf[i - 1];
+}
+
 /**
  * Linear interpolation between two values
  * $y = a + x \cdot (b - a)$
@@ -313,26 +607,18 @@ double MathUtils::lerp(double a, double b, double x) {
 }
 
 /**
- * Returns interpolated value at `x` from parallel vectors ( `xData`, `yData` )
- *  "Assumes that `xData` has at least two elements, is sorted and is strictly monotonic increasing
- *  boolean argument extrapolate determines behaviour beyond ends of array (if needed)"
- *  Reference: https://www.cplusplus.com/forum/general/216928/
+ * Returns the interpolated value at `x` based on the interval that starts
+ * at index `i`. This is shared by `MathUtils::interpolate` and the
+ * interpolator classes, so that all of them compute identical results.
  *
- * @param xData increasing vector of double values
+ * @param xData increasing x values
  * @param yData y values corresponding to xData
+ * @param i left end of the interval used for interpolation
  * @param x value to interpolate
  * @param extrapolate behaviour outside xData range
  * @return the interpolated value
  */
-double MathUtils::interpolate(std::vector<double>& xData, std::vector<double>& yData, double x, bool extrapolate) {
-    int size = xData.size();
-
-    int i = 0;  // find left end of interval for interpolation
-    if (x >= xData[size - 2])
-        i = size - 2;  // special case: beyond right end
-    else
-        while (x > xData[i + 1]) i++;
-
+static inline double interpolate_interval(const double* xData, const double* yData, int i, double x, bool extrapolate) {
     float
         xL = xData[i],
         yL = yData[i],
@@ -352,6 +638,67 @@ double MathUtils::interpolate(std::vector<double>& xData, std::vector<double>& y
     return yL + dydx * (x - xL);       // linear interpolation
 }
 
+/**
+ * Returns interpolated value at `x` from parallel vectors ( `xData`, `yData` )
+ *  "Assumes that `xData` has at least two elements, is sorted and is strictly monotonic increasing
+ *  boolean argument extrapolate determines behaviour beyond ends of array (if needed)"
+ *  Reference: https://www.cplusplus.com/forum/general/216928/
+ *
+ * @param xData increasing vector of double values
+ * @param yData y values corresponding to xData
+ * @param x value to interpolate
+ * @param extrapolate behaviour outside xData range
+ * @return the interpolated value
+ */
+double MathUtils::interpolate(std::vector<double>& xData, std::vector<double>& yData, double x, bool extrapolate) {
+    int size = xData.size();
+
+    int i = 0;  // find left end of interval for interpolation
+    if (x >= xData[size - 2])
+        i = size - 2;  // special case: beyond right end
+    else
+        while (x > xData[i + 1]) i++;
+
+    return interpolate_interval(xData.data(), yData.data(), i, x, extrapolate);
+}
+
+/**
+ * Interpolates all values of `x` from parallel vectors ( `xData`, `yData` ),
+ * the results are identical to calling `MathUtils::interpolate` for every
+ * value. If `x` is sorted (and has no nan values), the intervals are found
+ * by a cursor that only moves forward, so that the cost is O(n + m) instead
+ * of O(n * m) for n bins and m values. Otherwise every interval is found
+ * using binary search like in `SortedInterpolator`.
+ *
+ * @param xData sorted vector with at least two elements
+ * @param yData y values corresponding to xData
+ * @param x values to interpolate
+ * @param n_values number of values
+ * @param y output array with `n_values` elements, may be the same as `x`
+ * @param extrapolate behaviour outside xData range
+ */
+void MathUtils::interpolate(const std::vector<double>& xData, const std::vector<double>& yData, const double* x, size_t n_values, double* y, bool extrapolate) {
+    bool sorted = !(n_values > 0 && std::isnan(x[0]));
+    for (size_t k = 1; sorted && k < n_values; k++) sorted = x[k] >= x[k - 1];  // also false for nan
+
+    if (!sorted) {
+        const SortedInterpolator interpolator(xData, yData, extrapolate);
+        for (size_t k = 0; k < n_values; k++) y[k] = interpolator(x[k]);
+        return;
+    }
+
+    const int size = xData.size();
+    int i = 0;
+    for (size_t k = 0; k < n_values; k++) {
+        const double value = x[k];
+        if (value >= xData[size - 2])
+            i = size - 2;  // special case: beyond right end
+        else
+            while (value > xData[i + 1]) i++;
+        y[k] = interpolate_interval(xData.data(), yData.data(), i, value, extrapolate);
+    }
+}
+
 /**
  * Ensures that the devision does not return nans or to
  * high scaling factors.
@@ -374,3 +721,529 @@ float MathUtils::ensure_devidable(float numerator, float denuminator, double max
         return numerator * max_scaling_factor;
     return numerator / denuminator;
 }
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Interpolators
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+/**
+ * Prepares the interpolation on evenly spaced x values
+ *
+ * @param xData evenly spaced and increasing vector with at least two elements
+ * @param yData y values corresponding to xData
+ * @param extrapolate behaviour outside xData range
+ */
+UniformInterpolator::UniformInterpolator(const std::vector<double>& xData, const std::vector<double>& yData, bool extrapolate)
+    : xData(xData.data()),
+      yData(yData.data()),
+      size(xData.size()),
+      extrapolate(extrapolate) {
+    const double width = xData[size - 1] - xData[0];
+    inverse_step = (width > 0) ? (size - 1) / width : 0;
+}
+
+/**
+ * Returns the interpolated value at `x`. The estimated interval is
+ * corrected by the neighbouring values, since the bins may differ from
+ * an exact grid by rounding errors.
+ *
+ * @param x value to interpolate
+ * @return the interpolated value
+ */
+double UniformInterpolator::operator()(double x) const {
+    int i = 0;
+    if (x >= xData[size - 2])
+        i = size - 2;  // special case: beyond right end
+    else {
+        const double position = (x - xData[0]) * inverse_step;
+        if (position > 0) i = std::min((int)position, size - 2);  // also false for nan
+        while (i < size - 2 && x > xData[i + 1]) i++;
+        while (i > 0 && x <= xData[i]) i--;
+    }
+    return interpolate_interval(xData, yData, i, x, extrapolate);
+}
+
+/**
+ * Prepares the interpolation on sorted x values
+ *
+ * @param xData sorted vector with at least two elements
+ * @param yData y values corresponding to xData
+ * @param extrapolate behaviour outside xData range
+ */
+SortedInterpolator::SortedInterpolator(const std::vector<double>& xData, const std::vector<double>& yData, bool extrapolate)
+    : xData(xData.data()),
+      yData(yData.data()),
+      size(xData.size()),
+      extrapolate(extrapolate) {}
+
+/**
+ * Returns the interpolated value at `x`. In case of repeated x values,
+ * the first interval whose right end is not smaller than `x` is used,
+ * just like in `MathUtils::interpolate`.
+ *
+ * @param x value to interpolate
+ * @return the interpolated value
+ */
+double SortedInterpolator::operator()(double x) const {
+    int i = 0;
+    if (x >= xData[size - 2])
+        i = size - 2;  // special case: beyond right end
+    else if (x > xData[1])
+        i = (int)(std::lower_bound(xData + 1, xData + size - 2, x) - xData) - 1;
+    return interpolate_interval(xData, yData, i, x, extrapolate);
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Moments
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+// number of values that are reduced at once before the partial results are merged
+static constexpr unsigned moments_block_size = 256;
+
+// number of independent accumulators within a block
+static constexpr unsigned moments_lanes = 8;
+
+Moments::Moments() {
+    reset();
+}
+
+/**
+ * Removes all values from the accumulator
+ */
+void Moments::reset() {
+    n = 0;
+    mean = m2 = 0;
+    min = std::numeric_limits<double>::infinity();
+    max = -std::numeric_limits<double>::infinity();
+}
+
+/**
+ * Adds a value, nan values are ignored
+ *
+ * @param value value to add
+ */
+void Moments::update(double value) {
+    if (std::isnan(value)) return;
+    n++;
+    const double delta = value - mean;
+    mean += delta / n;
+    m2 += delta * (value - mean);
+    if (value < min) min = value;
+    if (value > max) max = value;
+}
+
+/**
+ * Returns the moments of at most `moments_block_size` values. The valid
+ * values are summed in `moments_lanes` independent accumulators, the
+ * squared deviations from the mean of the block are summed in a second
+ * loop while the block is still in the cache.
+ *
+ * @param values values to reduce
+ * @param n_values number of values
+ * @return moments of the block
+ */
+template <typename T>
+Moments Moments::get_block_moments(const T* values, unsigned n_values) {
+    double sums[moments_lanes] = {0}, lows[moments_lanes], highs[moments_lanes];
+    unsigned counts[moments_lanes] = {0};
+    for (unsigned l = 0; l < moments_lanes; l++) {
+        lows[l] = std::numeric_limits<double>::infinity();
+        highs[l] = -std::numeric_limits<double>::infinity();
+    }
+
+    const unsigned n_full = n_values - n_values % moments_lanes;
+
+    // ? sum, count, minimum and maximum - comparisons with nan are false
+    auto accumulate = [&](unsigned l, double value) {
+        const bool valid = value == value;
+        sums[l] += valid ? value : 0.0;
+        counts[l] += valid;
+        lows[l] = value < lows[l] ? value : lows[l];
+        highs[l] = value > highs[l] ? value : highs[l];
+    };
+    for (unsigned j = 0; j < n_full; j += moments_lanes)
+        for (unsigned l = 0; l < moments_lanes; l++) accumulate(l, values[j + l]);
+    for (unsigned j = n_full; j < n_values; j++) accumulate(j - n_full, values[j]);
+
+    Moments block;
+    double sum = 0;
+    for (unsigned l = 0; l < moments_lanes; l++) {
+        sum += sums[l];
+        block.n += counts[l];
+        block.min = std::min(block.min, lows[l]);
+        block.max = std::max(block.max, highs[l]);
+    }
+    if (block.n == 0) return block;
+    block.mean = sum / block.n;
+
+    // ? sum of squared deviations from the mean of the block
+    double squares[moments_lanes] = {0};
+    auto accumulate_squares = [&](unsigned l, double value) {
+        const double deviation = value == value ? value - block.mean : 0.0;
+        squares[l] += deviation * deviation;
+    };
+    for (unsigned j = 0; j < n_full; j += moments_lanes)
+        for (unsigned l = 0; l < moments_lanes; l++) accumulate_squares(l, values[j + l]);
+    for (unsigned j = n_full; j < n_values; j++) accumulate_squares(j - n_full, values[j]);
+    for (unsigned l = 0; l < moments_lanes; l++) block.m2 += squares[l];
+    return block;
+}
+
+/**
+ * Returns the moments of `values` by splitting the array into halves
+ * (at a multiple of the block size) until the blocks are reached and
+ * merging the results of the halves.
+ *
+ * @param values values to reduce
+ * @param n_values number of values
+ * @return moments of the values
+ */
+template <typename T>
+Moments Moments::get_pairwise_moments(const T* values, size_t n_values) {
+    if (n_values <= moments_block_size) return get_block_moments(values, (unsigned)n_values);
+    const size_t half = std::max((size_t)1, n_values / moments_block_size / 2) * moments_block_size;
+    Moments moments = get_pairwise_moments(values, half);
+    moments.merge(get_pairwise_moments(values + half, n_values - half));
+    return moments;
+}
+
+/**
+ * Adds all values of an array, nan values are ignored
+ *
+ * @param values values to add
+ * @param n_values number of values
+ */
+void Moments::update(const float* values, size_t n_values) {
+    merge(get_pairwise_moments(values, n_values));
+}
+void Moments::update(const double* values, size_t n_values) {
+    merge(get_pairwise_moments(values, n_values));
+}
+void Moments::update(const std::vector<float>& v_values) {
+    update(v_values.data(), v_values.size());
+}
+
+/**
+ * Adds the values summarized by `other`
+ *
+ * @param other moments of another chunk of the series
+ */
+void Moments::merge(const Moments& other) {
+    if (other.n == 0) return;
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    const uint64_t n_merged = n + other.n;
+    const double delta = other.mean - mean;
+    mean += delta * ((double)other.n / n_merged);
+    m2 += other.m2 + delta * delta * ((double)n * other.n / n_merged);
+    n = n_merged;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+/**
+ * @return the mean, nan if no values were added
+ */
+double Moments::get_mean() const {
+    return n ? mean : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * @return the population variance (M2 / n), nan if no values were added
+ */
+double Moments::get_variance() const {
+    return n ? m2 / n : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * @return the population standard deviation, nan if no values were added
+ */
+double Moments::get_sd() const {
+    return std::sqrt(get_variance());
+}
+
+/**
+ * @return the smallest value, nan if no values were added
+ */
+double Moments::get_min() const {
+    return n ? min : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * @return the largest value, nan if no values were added
+ */
+double Moments::get_max() const {
+    return n ? max : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Paired moments
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+PairedMoments::PairedMoments() {
+    reset();
+}
+
+/**
+ * Removes all pairs from the accumulator
+ */
+void PairedMoments::reset() {
+    n = 0;
+    mean_x = mean_y = m2_x = m2_y = m2_d = c_xy = 0;
+}
+
+/**
+ * Adds a pair of values, pairs that contain nan are ignored
+ *
+ * @param x reference value
+ * @param y predicted value
+ */
+void PairedMoments::update(double x, double y) {
+    if (std::isnan(x) || std::isnan(y)) return;
+    n++;
+    const double
+        delta_x = x - mean_x,
+        delta_y = y - mean_y,
+        delta_d = (y - x) - (mean_y - mean_x);
+    mean_x += delta_x / n;
+    mean_y += delta_y / n;
+    m2_x += delta_x * (x - mean_x);
+    m2_y += delta_y * (y - mean_y);
+    m2_d += delta_d * ((y - x) - (mean_y - mean_x));
+    c_xy += delta_x * (y - mean_y);
+}
+
+/**
+ * Returns the statistics of at most `moments_block_size` pairs, computed
+ * like in `Moments::get_block_moments`
+ *
+ * @param x reference values
+ * @param y predicted values
+ * @param n_values number of pairs
+ * @return statistics of the block
+ */
+PairedMoments PairedMoments::get_block_moments(const float* x, const float* y, unsigned n_values) {
+    double sums_x[moments_lanes] = {0}, sums_y[moments_lanes] = {0};
+    unsigned counts[moments_lanes] = {0};
+    const unsigned n_full = n_values - n_values % moments_lanes;
+
+    // ? sums of the valid pairs - comparisons with nan are false
+    auto accumulate = [&](unsigned l, double xi, double yi) {
+        const bool valid = xi == xi && yi == yi;
+        sums_x[l] += valid ? xi : 0.0;
+        sums_y[l] += valid ? yi : 0.0;
+        counts[l] += valid;
+    };
+    for (unsigned j = 0; j < n_full; j += moments_lanes)
+        for (unsigned l = 0; l < moments_lanes; l++) accumulate(l, x[j + l], y[j + l]);
+    for (unsigned j = n_full; j < n_values; j++) accumulate(j - n_full, x[j], y[j]);
+
+    PairedMoments block;
+    double sum_x = 0, sum_y = 0;
+    for (unsigned l = 0; l < moments_lanes; l++) {
+        sum_x += sums_x[l];
+        sum_y += sums_y[l];
+        block.n += counts[l];
+    }
+    if (block.n == 0) return block;
+    block.mean_x = sum_x / block.n;
+    block.mean_y = sum_y / block.n;
+
+    // ? squared deviations and co-moment
+    const double mean_d = block.mean_y - block.mean_x;
+    double
+        squares_x[moments_lanes] = {0},
+        squares_y[moments_lanes] = {0},
+        squares_d[moments_lanes] = {0},
+        products[moments_lanes] = {0};
+    auto accumulate_squares = [&](unsigned l, double xi, double yi) {
+        const bool valid = xi == xi && yi == yi;
+        const double
+            deviation_x = valid ? xi - block.mean_x : 0.0,
+            deviation_y = valid ? yi - block.mean_y : 0.0,
+            deviation_d = valid ? (yi - xi) - mean_d : 0.0;
+        squares_x[l] += deviation_x * deviation_x;
+        squares_y[l] += deviation_y * deviation_y;
+        squares_d[l] += deviation_d * deviation_d;
+        products[l] += deviation_x * deviation_y;
+    };
+    for (unsigned j = 0; j < n_full; j += moments_lanes)
+        for (unsigned l = 0; l < moments_lanes; l++) accumulate_squares(l, x[j + l], y[j + l]);
+    for (unsigned j = n_full; j < n_values; j++) accumulate_squares(j - n_full, x[j], y[j]);
+
+    for (unsigned l = 0; l < moments_lanes; l++) {
+        block.m2_x += squares_x[l];
+        block.m2_y += squares_y[l];
+        block.m2_d += squares_d[l];
+        block.c_xy += products[l];
+    }
+    return block;
+}
+
+/**
+ * Returns the statistics of all pairs by merging the halves pairwise
+ * (see `Moments::get_pairwise_moments`)
+ */
+PairedMoments PairedMoments::get_pairwise_moments(const float* x, const float* y, size_t n_values) {
+    if (n_values <= moments_block_size) return get_block_moments(x, y, (unsigned)n_values);
+    const size_t half = std::max((size_t)1, n_values / moments_block_size / 2) * moments_block_size;
+    PairedMoments moments = get_pairwise_moments(x, y, half);
+    moments.merge(get_pairwise_moments(x + half, y + half, n_values - half));
+    return moments;
+}
+
+/**
+ * Adds all pairs of two arrays, pairs that contain nan are ignored
+ *
+ * @param x reference values
+ * @param y predicted values
+ * @param n_values number of pairs
+ */
+void PairedMoments::update(const float* x, const float* y, size_t n_values) {
+    merge(get_pairwise_moments(x, y, n_values));
+}
+
+/**
+ * Adds the pairs summarized by `other`
+ *
+ * @param other statistics of another chunk of the time series
+ */
+void PairedMoments::merge(const PairedMoments& other) {
+    if (other.n == 0) return;
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    const uint64_t n_merged = n + other.n;
+    const double
+        delta_x = other.mean_x - mean_x,
+        delta_y = other.mean_y - mean_y,
+        delta_d = delta_y - delta_x,
+        weight = (double)n * other.n / n_merged;
+    mean_x += delta_x * ((double)other.n / n_merged);
+    mean_y += delta_y * ((double)other.n / n_merged);
+    m2_x += other.m2_x + delta_x * delta_x * weight;
+    m2_y += other.m2_y + delta_y * delta_y * weight;
+    m2_d += other.m2_d + delta_d * delta_d * weight;
+    c_xy += other.c_xy + delta_x * delta_y * weight;
+    n = n_merged;
+}
+
+/**
+ * @return the mean of the reference values, nan if no pairs were added
+ */
+double PairedMoments::get_mean_x() const {
+    return n ? mean_x : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * @return the mean of the predicted values, nan if no pairs were added
+ */
+double PairedMoments::get_mean_y() const {
+    return n ? mean_y : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * @return the mean bias error $\mu(y - x)$, nan if no pairs were added
+ */
+double PairedMoments::get_mbe() const {
+    return n ? mean_y - mean_x : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * @return the sum of the squared errors $\sum (y - x)^{2}$, nan if no pairs were added
+ */
+double PairedMoments::get_sum_of_squared_errors() const {
+    const double mbe = get_mbe();
+    return m2_d + n * mbe * mbe;
+}
+
+/**
+ * @return the root mean square error, nan if no pairs were added
+ */
+double PairedMoments::get_rmse() const {
+    return std::sqrt(get_sum_of_squared_errors() / n);
+}
+
+/**
+ * @return the correlation coefficient, nan if no pairs were added or one of the series is constant
+ */
+double PairedMoments::get_correlation() const {
+    return n ? c_xy / std::sqrt(m2_x * m2_y) : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Grouped indicators
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+/**
+ * Prepares the computation of the indicators `v_names` per group of time steps
+ *
+ * @param v_names names of the indicators (see `MathUtils::available_methods`)
+ * @param v_groups group (0 ... `n_groups` - 1) of every time step, negative to skip the time step
+ * @param n_groups number of groups
+ */
+GroupedIndicators::GroupedIndicators(const std::vector<std::string>& v_names, const std::vector<int>& v_groups, unsigned n_groups)
+    : v_names(v_names),
+      v_groups(v_groups),
+      n_groups(n_groups),
+      v_moments(n_groups),
+      v_paired_moments(n_groups),
+      v_ioa_denominators(n_groups) {
+    check_indicators(v_names, one_ds, two_ds);
+    needs_ioa = std::find(v_names.begin(), v_names.end(), "ioa") != v_names.end();
+    for (int group : v_groups)
+        if (group >= (int)n_groups) throw std::runtime_error("Invalid group " + std::to_string(group) + "!");
+}
+
+/**
+ * Computes the indicators of one (pair of) time series for every group.
+ * The statistics of all groups are updated while passing over the time
+ * steps once ("ioa" needs a second pass), so the costs do not depend on the
+ * number of groups. Groups without valid values result in nan.
+ *
+ * @param x values of the (first) time series, one per entry of `v_groups`
+ * @param y values of the second time series, only required by the methods of `requires_2_ds`
+ * @param v_results output array [group][indicator]
+ */
+void GroupedIndicators::compute(const float* x, const float* y, double* v_results) {
+    if (two_ds && y == nullptr) throw std::runtime_error("The indicators require two time series!");
+    for (unsigned group = 0; group < n_groups; group++) {
+        v_moments[group].reset();
+        v_paired_moments[group].reset();
+        v_ioa_denominators[group] = 0;
+    }
+
+    const size_t n_time = v_groups.size();
+    for (size_t ts = 0; ts < n_time; ts++) {
+        const int group = v_groups[ts];
+        if (group < 0) continue;
+        if (one_ds) v_moments[group].update(x[ts]);
+        if (two_ds) v_paired_moments[group].update(x[ts], y[ts]);
+    }
+
+    // ? denominator of the index of agreement (see `get_ioa`)
+    if (needs_ioa) {
+        for (size_t ts = 0; ts < n_time; ts++) {
+            const int group = v_groups[ts];
+            if (group >= 0) v_ioa_denominators[group] += get_ioa_term(v_paired_moments[group].get_mean_x(), x[ts], y[ts]);
+        }
+    }
+
+    const size_t n_names = v_names.size();
+    for (unsigned group = 0; group < n_groups; group++)
+        for (size_t i = 0; i < n_names; i++)
+            v_results[group * n_names + i] =
+                (v_names[i] == "ioa") ? get_ioa(v_paired_moments[group], v_ioa_denominators[group])
+                                      : get_indicator(v_names[i], v_moments[group], v_paired_moments[group]);
+}
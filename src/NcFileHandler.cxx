@@ -32,6 +32,8 @@
 
 #include "NcFileHandler.hxx"
 
+#include <netcdf.h>
+
 #include <fstream>
 
 /**
@@ -43,6 +45,8 @@
 std::string NcFileHandler::time_name = "time";
 std::string NcFileHandler::lat_name = "lat";
 std::string NcFileHandler::lon_name = "lon";
+std::string NcFileHandler::station_name = "station";
+std::string NcFileHandler::parameter_name = "parameter";
 
 std::string NcFileHandler::units = "units";
 std::string NcFileHandler::lat_unit = "degrees_north";
@@ -67,7 +71,8 @@ NcFileHandler::NcFileHandler() : handles_file(false) {}
  *
  * @param filepath path to file that should be loaded
  * @param variable_name variable to load into this class (only one variable per NcFileHandler instance)
- * @param n_dimensions number of dimensions of this variable within the data set. Only 1 or 3 is valid.
+ * @param n_dimensions number of dimensions of this variable within the data set. Only 1 (time),
+ *                     2 (time x station) or 3 (time x lat x lon) is valid.
  */
 NcFileHandler::NcFileHandler(std::string filepath, std::string variable_name, unsigned n_dimensions) : var_name(variable_name),
                                                                                                        handles_file(true),
@@ -135,13 +140,91 @@ void NcFileHandler::read_dataset(std::string filepath, std::string variable, uns
         if (lon_var.isNull()) throw std::runtime_error("Longitude dimension <" + lon_name + "> not found!");
         lon_var.getVar(lon_values);
 
+    } else if (n_dimensions == 2) {
+        station_dim = dataFile->getDim(NcFileHandler::station_name);
+        if (station_dim.isNull()) throw std::runtime_error("Station dimension <" + NcFileHandler::station_name + "> not found in " + filepath + "!");
+        n_stations = station_dim.getSize();
+
     } else if (n_dimensions != 1)
-        throw std::runtime_error("Only 1 and 3-dimensional data sets are supported!");
+        throw std::runtime_error("Only 1, 2 and 3-dimensional data sets are supported!");
 
     // std::cout << n_time << " " << n_lat << " " << n_lon << std::endl;
     // Get the data of the variable; this is later used to select a specific region. This is kinda open file to reference
     data = dataFile->getVar(var_name);
     if (data.isNull()) throw std::runtime_error("Variable <" + var_name + "> not found in " + filepath + "!");
+
+    if (n_dimensions == 2) {
+        // the stations are read in blocks of neighbouring stations for all time steps
+        const std::vector<netCDF::NcDim> dimensions = data.getDims();
+        if (dimensions.size() != 2 || dimensions[0].getName() != time_name || dimensions[1].getName() != station_name)
+            throw std::runtime_error("Variable <" + var_name + "> in " + filepath + " must have the dimensions (" + time_name + ", " + station_name + ")!");
+        find_station_variables();
+    }
+}
+
+/**
+ * Loads the transfer functions saved by the `to_netcdf` method for
+ * parameters into this NcFileHandler instance
+ * -> The data set has no time dimension, but a `parameter` dimension
+ *    instead
+ *
+ * @param filepath path to file that should be loaded
+ * @param variable variable containing the parameters
+ * @param n_dimensions 1 (parameter), 2 (station x parameter) or 3 (lat x lon x parameter)
+ */
+void NcFileHandler::read_parameters(std::string filepath, std::string variable, unsigned n_dimensions) {
+    std::ifstream ifile;
+    ifile.open(filepath);
+    if (!ifile)
+        throw std::runtime_error("Could not open file: " + filepath);
+    else
+        ifile.close();
+
+    this->filepath = filepath;
+    this->n_dimensions = n_dimensions;
+    this->handles_file = true;
+    this->var_name = variable;
+
+    dataFile = new netCDF::NcFile(filepath, netCDF::NcFile::read);
+
+    netCDF::NcDim parameter_dim = dataFile->getDim(NcFileHandler::parameter_name);
+    if (parameter_dim.isNull()) throw std::runtime_error("Parameter dimension <" + NcFileHandler::parameter_name + "> not found in " + filepath + "!");
+    n_parameters = parameter_dim.getSize();
+
+    if (n_dimensions == 3) {
+        lat_dim = dataFile->getDim(NcFileHandler::lat_name);
+        lon_dim = dataFile->getDim(NcFileHandler::lon_name);
+        if (lat_dim.isNull() || lon_dim.isNull()) throw std::runtime_error("Latitude or longitude dimension not found in " + filepath + "!");
+        n_lat = lat_dim.getSize();
+        n_lon = lon_dim.getSize();
+    } else if (n_dimensions == 2) {
+        station_dim = dataFile->getDim(NcFileHandler::station_name);
+        if (station_dim.isNull()) throw std::runtime_error("Station dimension <" + NcFileHandler::station_name + "> not found in " + filepath + "!");
+        n_stations = station_dim.getSize();
+    } else if (n_dimensions != 1)
+        throw std::runtime_error("Only 1, 2 and 3-dimensional data sets are supported!");
+
+    data = dataFile->getVar(var_name);
+    if (data.isNull()) throw std::runtime_error("Variable <" + var_name + "> not found in " + filepath + "!");
+    if (n_dimensions == 2) find_station_variables();
+}
+
+/**
+ * Collects the variables that only depend on the station dimension (and
+ * maybe a string length), i.e. the coordinates and IDs of the stations,
+ * so that they can be carried through to the output files
+ */
+void NcFileHandler::find_station_variables() {
+    station_variables.clear();
+    for (const std::pair<const std::string, netCDF::NcVar>& variable : dataFile->getVars()) {
+        if (variable.first == var_name) continue;
+        const std::vector<netCDF::NcDim> dimensions = variable.second.getDims();
+        bool depends_on_time = false;
+        for (const netCDF::NcDim& dimension : dimensions)
+            if (dimension.getName() == time_name) depends_on_time = true;
+        if (!dimensions.empty() && dimensions[0].getName() == station_name && !depends_on_time)
+            station_variables.push_back(variable.first);
+    }
 }
 
 void NcFileHandler::close_file() {
@@ -187,6 +270,78 @@ void NcFileHandler::get_lat_timeseries_for_lon(std::vector<std::vector<float>>&
             v_out_arr[lat][ts] = tmp[ts][lat];
 }
 
+/** Fills `v_out_arr` with the time series of all latitudes for given longitude (`lon`)
+ *  in the layout of the file, i.e. [time][lat], which can be used as a `Slab`
+ *  with the layout `SlabLayout::TimeCell`.
+ *  -> NcFileHandler must hold 3-dimensional data
+ *
+ * @param v_out_arr output vector, will be resized to `n_time * n_lat`
+ * @param lon longitude of desired locations
+ */
+void NcFileHandler::get_lat_slab_for_lon(std::vector<float>& v_out_arr, unsigned lon) {
+    get_lat_slab_for_lon(v_out_arr, lon, 0, n_time);
+}
+
+/** Fills `v_out_arr` with the time steps [`first_time`, `first_time` + `count_time`)
+ *  of all latitudes for given longitude (`lon`) in the layout of the file,
+ *  i.e. [time][lat], so that long time series can be read chunk by chunk.
+ *  -> NcFileHandler must hold 3-dimensional data
+ *
+ * @param v_out_arr output vector, will be resized to `count_time * n_lat`
+ * @param lon longitude of desired locations
+ * @param first_time index of the first time step
+ * @param count_time number of time steps
+ */
+void NcFileHandler::get_lat_slab_for_lon(std::vector<float>& v_out_arr, unsigned lon, size_t first_time, size_t count_time) {
+    std::vector<size_t> startp, countp;
+    startp.push_back(first_time);
+    startp.push_back(0);
+    startp.push_back(lon);
+
+    countp.push_back(count_time);
+    countp.push_back(n_lat);
+    countp.push_back(1);
+
+    v_out_arr.resize(count_time * n_lat);
+    data.getVar(startp, countp, v_out_arr.data());
+}
+
+/** Fills `v_out_arr` with the time series of the stations [`first`, `first` + `count`)
+ *  in the layout of the file, i.e. [time][station], which can be used as a `Slab`
+ *  with the layout `SlabLayout::TimeCell`.
+ *  -> NcFileHandler must hold 2-dimensional data
+ *
+ * @param v_out_arr output vector, will be resized to `n_time * count`
+ * @param first index of the first station
+ * @param count number of stations
+ */
+void NcFileHandler::get_station_slab(std::vector<float>& v_out_arr, size_t first, size_t count) {
+    get_station_slab(v_out_arr, first, count, 0, n_time);
+}
+
+/** Fills `v_out_arr` with the time steps [`first_time`, `first_time` + `count_time`)
+ *  of the stations [`first`, `first` + `count`) in the layout of the file,
+ *  i.e. [time][station], so that long time series can be read chunk by chunk.
+ *  -> NcFileHandler must hold 2-dimensional data
+ *
+ * @param v_out_arr output vector, will be resized to `count_time * count`
+ * @param first index of the first station
+ * @param count number of stations
+ * @param first_time index of the first time step
+ * @param count_time number of time steps
+ */
+void NcFileHandler::get_station_slab(std::vector<float>& v_out_arr, size_t first, size_t count, size_t first_time, size_t count_time) {
+    std::vector<size_t> startp, countp;
+    startp.push_back(first_time);
+    startp.push_back(first);
+
+    countp.push_back(count_time);
+    countp.push_back(count);
+
+    v_out_arr.resize(count_time * count);
+    data.getVar(startp, countp, v_out_arr.data());
+}
+
 /** Fills the 2D vector `v_out_arr` with all timesteps of one location of 3-dimensional data set based on longitude (`lon`)
  *  -> NcFileHandler must hold 3-dimensional data
  *
@@ -231,12 +386,150 @@ void NcFileHandler::get_timeseries(std::vector<float>& v_out_arr) {
     for (unsigned day = 0; day < n_time; day++) v_out_arr[day] = tmp[day];
 }
 
+/** Fills `v_out_arr` with the parameters of all latitudes for given longitude (`lon`),
+ *  i.e. [lat][parameter]
+ *  -> NcFileHandler must hold 3-dimensional parameters (see `read_parameters`)
+ *
+ * @param v_out_arr output vector, will be resized to `n_lat * n_parameters`
+ * @param lon longitude of desired locations
+ */
+void NcFileHandler::get_parameter_slab_for_lon(std::vector<double>& v_out_arr, unsigned lon) {
+    std::vector<size_t> startp, countp;
+    startp.push_back(0);
+    startp.push_back(lon);
+    startp.push_back(0);
+
+    countp.push_back(n_lat);
+    countp.push_back(1);
+    countp.push_back(n_parameters);
+
+    v_out_arr.resize((size_t)n_lat * n_parameters);
+    data.getVar(startp, countp, v_out_arr.data());
+}
+
+/** Fills `v_out_arr` with the parameters of the stations [`first`, `first` + `count`),
+ *  i.e. [station][parameter]
+ *  -> NcFileHandler must hold 2-dimensional parameters (see `read_parameters`)
+ *
+ * @param v_out_arr output vector, will be resized to `count * n_parameters`
+ * @param first index of the first station
+ * @param count number of stations
+ */
+void NcFileHandler::get_parameter_slab_for_stations(std::vector<double>& v_out_arr, size_t first, size_t count) {
+    std::vector<size_t> startp, countp;
+    startp.push_back(first);
+    startp.push_back(0);
+
+    countp.push_back(count);
+    countp.push_back(n_parameters);
+
+    v_out_arr.resize(count * n_parameters);
+    data.getVar(startp, countp, v_out_arr.data());
+}
+
+/** Fills `v_out_arr` with the parameters of a 1-dimensional data set
+ *  -> NcFileHandler must hold 1-dimensional parameters (see `read_parameters`)
+ *
+ * @param v_out_arr output vector, will be resized to `n_parameters`
+ */
+void NcFileHandler::get_parameters(std::vector<double>& v_out_arr) {
+    v_out_arr.resize(n_parameters);
+    data.getVar(v_out_arr.data());
+}
+
+/** Returns the value of a global (text) attribute of the handled file
+ *
+ * @param name name of the attribute
+ * @return value of the attribute
+ */
+std::string NcFileHandler::get_attribute(std::string name) {
+    netCDF::NcGroupAtt attribute = dataFile->getAtt(name);
+    if (attribute.isNull()) throw std::runtime_error("Attribute <" + name + "> not found in " + filepath + "!");
+    std::string value;
+    attribute.getValues(value);
+    return value;
+}
+
+/**
+ * Returns the value of a text attribute of the time variable, e.g. its
+ * `units` or `calendar`
+ *
+ * @param name name of the attribute
+ * @return value of the attribute or an empty string if it does not exist
+ */
+std::string NcFileHandler::get_time_attribute(std::string name) {
+    std::map<std::string, netCDF::NcVarAtt> attributes = time_var.getAtts();
+    std::map<std::string, netCDF::NcVarAtt>::iterator attribute = attributes.find(name);
+    if (attribute == attributes.end()) return "";
+    std::string value;
+    attribute->second.getValues(value);
+    return value;
+}
+
 /**
  * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
  * *                        Data saving management
  * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
  */
 
+/**
+ * Copies all attributes of the variable `from` to the variable `to`
+ *
+ * @param from variable of the handled file
+ * @param to variable of an output file
+ */
+static void copy_attributes(const netCDF::NcVar& from, netCDF::NcVar& to) {
+    for (std::pair<std::string, netCDF::NcVarAtt> att : from.getAtts()) {
+        const netCDF::NcType type = att.second.getType();
+        if (type.getTypeClass() == netCDF::NcType::nc_CHAR) {
+            std::string value;
+            att.second.getValues(value);
+            to.putAtt(att.first, value);
+        } else if (type.getTypeClass() != netCDF::NcType::nc_STRING) {
+            std::vector<char> value(att.second.getAttLength() * type.getSize());
+            att.second.getValues((void*)value.data());
+            to.putAtt(att.first, type, att.second.getAttLength(), (const void*)value.data());
+        }
+    }
+}
+
+/**
+ * Adds the coordinates and IDs of the stations (see `find_station_variables`)
+ * with their attributes to `output_file`
+ *
+ * @param output_file file to write
+ * @param out_station_dim station dimension of `output_file`
+ */
+void NcFileHandler::put_station_variables(netCDF::NcFile& output_file, netCDF::NcDim& out_station_dim) {
+    for (const std::string& name : station_variables) {
+        const netCDF::NcVar variable = dataFile->getVar(name);
+        std::vector<netCDF::NcDim> dimensions;
+        size_t n_values = 1;
+        for (const netCDF::NcDim& dimension : variable.getDims()) {
+            netCDF::NcDim out_dim = out_station_dim;
+            if (dimension.getName() != station_name) {  // e.g. the length of fixed-size IDs
+                out_dim = output_file.getDim(dimension.getName());
+                if (out_dim.isNull()) out_dim = output_file.addDim(dimension.getName(), dimension.getSize());
+            }
+            dimensions.push_back(out_dim);
+            n_values *= dimension.getSize();
+        }
+
+        netCDF::NcVar out_var = output_file.addVar(name, variable.getType(), dimensions);
+        copy_attributes(variable, out_var);
+        if (variable.getType().getTypeClass() == netCDF::NcType::nc_STRING) {
+            std::vector<char*> values(n_values);
+            variable.getVar(values.data());
+            out_var.putVar((const char**)values.data());
+            nc_free_string(n_values, values.data());
+        } else {
+            std::vector<char> values(n_values * variable.getType().getSize());
+            variable.getVar((void*)values.data());
+            out_var.putVar((const void*)values.data());
+        }
+    }
+}
+
 /** Saves a data set with one variable for one time dimension (1D vector)
  *  -> time dimension gets same attributes as handled file
  *
@@ -278,15 +571,34 @@ void NcFileHandler::to_netcdf(std::string out_fpath, std::string variable_name,
 }
 
 /** Saves a data set with one variable for one time dimension (1D vector)
+ *  resp. for the time and station dimension if the handled file is
+ *  2-dimensional (time x station, the coordinates and IDs of the stations
+ *  are carried through)
  *
  * @param out_fpath output file path
  * @param variable_name name of the output variable
- * @param v_out_data 1D array of data to save
+ * @param v_out_data 1D array of data to save: [time] resp. [time][station]
  */
 void NcFileHandler::to_netcdf(std::string out_fpath, std::string variable_name, std::vector<float>& v_out_data) {
     netCDF::NcFile output_file(out_fpath, netCDF::NcFile::replace);
 
-    if (handles_file) {
+    if (handles_file && n_dimensions == 2) {
+        netCDF::NcDim
+            out_time_dim = output_file.addDim(time_name, n_time),
+            out_station_dim = output_file.addDim(station_name, n_stations);
+        netCDF::NcVar out_time_var = output_file.addVar(time_name, time_var.getType(), out_time_dim);
+        copy_attributes(time_var, out_time_var);
+        put_station_variables(output_file, out_station_dim);
+
+        std::vector<netCDF::NcDim> dim_vector;
+        dim_vector.push_back(out_time_dim);
+        dim_vector.push_back(out_station_dim);
+
+        netCDF::NcVar output_var = output_file.addVar(variable_name, netCDF::ncFloat, dim_vector);
+        out_time_var.putVar(time_values);
+        output_var.putVar(v_out_data.data());
+
+    } else if (handles_file) {
         netCDF::NcDim out_time_dim = output_file.addDim(time_name, n_time);
         netCDF::NcVar out_time_var = output_file.addVar(time_name, netCDF::ncDouble, out_time_dim);
         // Set attributes
@@ -617,17 +929,8 @@ void NcFileHandler::to_netcdf(
     out_lat_var.putVar(lat_values);
     out_lon_var.putVar(lon_values);
 
-    for (std::pair<std::string, netCDF::NcVarAtt> att : lon_var.getAtts()) {
-        char value[att.second.getAttLength()];
-        att.second.getValues(value);
-        out_lon_var.putAtt(att.first, att.second.getType(), att.second.getAttLength(), value);
-    }
-
-    for (std::pair<std::string, netCDF::NcVarAtt> att : lat_var.getAtts()) {
-        char* value = new char[att.second.getAttLength()];
-        att.second.getValues(value);
-        out_lat_var.putAtt(att.first, att.second.getType(), att.second.getAttLength(), value);
-    }
+    copy_attributes(lon_var, out_lon_var);
+    copy_attributes(lat_var, out_lat_var);
 
     std::vector<netCDF::NcDim> dim_vector;
     dim_vector.push_back(out_lat_dim);
@@ -653,3 +956,104 @@ void NcFileHandler::to_netcdf(
         output_var.putVar(startp, countp, data_to_save);
     }
 }
+
+/** Saves a 3-dimensional data set containing multiple variables per group of
+ *  time steps to file (3 dimensions: group x lat x lon), e.g. indicators per year
+ *
+ * @param out_fpath output file path
+ * @param variable_names names of the output variables
+ * @param v_out_data data of the variables, each in the layout [group][lat][lon]
+ * @param group_name name of the group dimension and its coordinate variable
+ * @param v_group_values coordinate values of the groups
+ * @param group_description long_name attribute of the groups (optional)
+ */
+void NcFileHandler::to_netcdf(
+    std::string out_fpath,
+    std::vector<std::string> variable_names,
+    std::vector<std::vector<float>>& v_out_data,
+    std::string group_name,
+    std::vector<int>& v_group_values,
+    std::string group_description
+) {
+    netCDF::NcFile output_file(out_fpath, netCDF::NcFile::replace);
+
+    netCDF::NcDim
+        out_group_dim = output_file.addDim(group_name, v_group_values.size()),
+        out_lat_dim = output_file.addDim(lat_name, n_lat),
+        out_lon_dim = output_file.addDim(lon_name, n_lon);
+
+    netCDF::NcVar
+        out_group_var = output_file.addVar(group_name, netCDF::ncInt, out_group_dim),
+        out_lat_var = output_file.addVar(lat_name, netCDF::ncFloat, out_lat_dim),
+        out_lon_var = output_file.addVar(lon_name, netCDF::ncFloat, out_lon_dim);
+
+    if (!group_description.empty()) out_group_var.putAtt("long_name", group_description);
+    copy_attributes(lon_var, out_lon_var);
+    copy_attributes(lat_var, out_lat_var);
+
+    out_group_var.putVar(v_group_values.data());
+    out_lat_var.putVar(lat_values);
+    out_lon_var.putVar(lon_values);
+
+    std::vector<netCDF::NcDim> dim_vector;
+    dim_vector.push_back(out_group_dim);
+    dim_vector.push_back(out_lat_dim);
+    dim_vector.push_back(out_lon_dim);
+
+    for (unsigned i = 0; i < variable_names.size(); i++) {
+        netCDF::NcVar output_var = output_file.addVar(variable_names[i], netCDF::ncFloat, dim_vector);
+        output_var.putVar(v_out_data[i].data());
+    }
+}
+
+/** Saves the parameters of transfer functions (1 dimension: parameter,
+ *  2 dimensions: station x parameter or 3 dimensions: lat x lon x parameter,
+ *  depending on the handled file)
+ *  -> The settings of the transfer functions are stored as global attributes
+ *
+ * @param out_fpath output file path
+ * @param variable_name name of the output variable
+ * @param v_parameters parameters to save: [lat][lon][parameter], [station][parameter] resp. [parameter]
+ * @param n_parameters number of parameters per location
+ * @param attributes names and values of the global attributes
+ */
+void NcFileHandler::to_netcdf(
+    std::string out_fpath,
+    std::string variable_name,
+    std::vector<double>& v_parameters,
+    unsigned n_parameters,
+    std::vector<std::pair<std::string, std::string>> attributes
+) {
+    netCDF::NcFile output_file(out_fpath, netCDF::NcFile::replace);
+
+    for (std::pair<std::string, std::string> attribute : attributes)
+        output_file.putAtt(attribute.first, attribute.second);
+
+    netCDF::NcDim out_parameter_dim = output_file.addDim(parameter_name, n_parameters);
+    std::vector<netCDF::NcDim> dim_vector;
+    if (n_dimensions == 3) {
+        netCDF::NcDim
+            out_lat_dim = output_file.addDim(lat_name, n_lat),
+            out_lon_dim = output_file.addDim(lon_name, n_lon);
+
+        netCDF::NcVar
+            out_lat_var = output_file.addVar(lat_name, netCDF::ncFloat, out_lat_dim),
+            out_lon_var = output_file.addVar(lon_name, netCDF::ncFloat, out_lon_dim);
+
+        out_lat_var.putAtt(units, lat_unit);
+        out_lon_var.putAtt(units, lon_unit);
+        out_lat_var.putVar(lat_values);
+        out_lon_var.putVar(lon_values);
+
+        dim_vector.push_back(out_lat_dim);
+        dim_vector.push_back(out_lon_dim);
+    } else if (n_dimensions == 2) {
+        netCDF::NcDim out_station_dim = output_file.addDim(station_name, n_stations);
+        put_station_variables(output_file, out_station_dim);
+        dim_vector.push_back(out_station_dim);
+    }
+    dim_vector.push_back(out_parameter_dim);
+
+    netCDF::NcVar output_var = output_file.addVar(variable_name, netCDF::ncDouble, dim_vector);
+    output_var.putVar(v_parameters.data());
+}
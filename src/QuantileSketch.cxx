@@ -0,0 +1,265 @@
+// -*- lsst-c++ -*-
+
+/**
+ * @file QuantileSketch.cxx
+ * @brief Implementation of the mergeable quantile sketch used for approximate CDFs
+ * @author Benjamin Thomas Schwertfeger
+ * @email: contact@b-schwertfeger.de
+ * @link https://github.com/btschwertfeger/BiasAdjustCXX
+ *
+ *  * Copyright (C) 2023 Benjamin Thomas Schwertfeger
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Includes
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+#include "QuantileSketch.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Object Management
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+// the capacities of the levels decrease geometrically by this factor from the top
+static constexpr double capacity_decay = 2.0 / 3.0;
+
+// seed of the coin flips of the compactions
+static constexpr uint32_t random_seed = 0x9e3779b9u;
+
+/**
+ * Creates an empty sketch
+ *
+ * @param k size parameter, the sketch retains about 3k values
+ */
+QuantileSketch::QuantileSketch(unsigned k) {
+    reset(k);
+}
+QuantileSketch::~QuantileSketch() {}
+
+/**
+ * Returns the size parameter that is needed for a normalized rank error
+ * of `error`
+ *
+ * @param error maximum normalized rank error, e.g. 0.01
+ * @return size parameter `k`
+ */
+unsigned QuantileSketch::get_k(double error) {
+    if (!(error > 0 && error < 1))
+        throw std::runtime_error("The error of the quantile sketch must be between 0 and 1!");
+    const double k = std::ceil(std::pow(2.296 / error, 1 / 0.9723));
+    return (unsigned)std::min(std::max(k, 8.0), 65535.0);
+}
+
+/**
+ * Returns the normalized rank error of a sketch with the size parameter
+ * `k`, based on the empirical bound of the KLL sketch of Apache DataSketches
+ *
+ * @param k size parameter
+ * @return normalized rank error
+ */
+double QuantileSketch::get_error(unsigned k) {
+    return 2.296 / std::pow((double)k, 0.9723);
+}
+
+/**
+ * Removes all values from the sketch
+ *
+ * @param k new size parameter
+ */
+void QuantileSketch::reset(unsigned k) {
+    this->k = std::max(k, 8u);
+    n = 0;
+    min = max = std::numeric_limits<float>::quiet_NaN();
+    v_levels.resize(1);
+    v_levels[0].clear();
+    n_retained = 0;
+    max_retained = get_capacity(0);
+    random_state = random_seed;
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Updating and Merging
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+/**
+ * Returns the number of values that level `level` can hold before it is
+ * compacted
+ */
+unsigned QuantileSketch::get_capacity(unsigned level) const {
+    const unsigned depth = (unsigned)v_levels.size() - 1 - level;
+    return std::max(2u, (unsigned)std::ceil(k * std::pow(capacity_decay, depth)));
+}
+
+/**
+ * Adds a level on top of the sketch
+ */
+void QuantileSketch::grow() {
+    v_levels.emplace_back();
+    max_retained = 0;
+    for (unsigned level = 0; level < v_levels.size(); level++) max_retained += get_capacity(level);
+}
+
+/**
+ * Compacts the lowest levels that exceed their capacity until the sketch
+ * retains fewer values than the sum of the capacities
+ */
+void QuantileSketch::compress() {
+    for (unsigned level = 0; level < v_levels.size(); level++) {
+        if (v_levels[level].size() >= get_capacity(level)) {
+            if (level + 1 == v_levels.size()) grow();
+            compact(level);
+            if (n_retained < max_retained) break;
+        }
+    }
+}
+
+/**
+ * Sorts the values of `level` and moves every second value (starting at
+ * the first or second one by a coin flip) to the next level, where it has
+ * twice the weight. The smallest value stays if the number of values is odd.
+ */
+void QuantileSketch::compact(unsigned level) {
+    std::vector<float>
+        &v_values = v_levels[level],
+        &v_next = v_levels[level + 1];
+    std::sort(v_values.begin(), v_values.end());
+
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    const size_t
+        n_values = v_values.size(),
+        n_kept = n_values % 2,
+        offset = random_state & 1;
+    for (size_t i = n_kept + offset; i < n_values; i += 2) v_next.push_back(v_values[i]);
+
+    n_retained -= (n_values - n_kept) / 2;
+    v_values.resize(n_kept);
+}
+
+/**
+ * Adds a value to the sketch, nan values are ignored
+ *
+ * @param value value to add
+ */
+void QuantileSketch::update(float value) {
+    if (std::isnan(value)) return;
+    if (n == 0 || value < min) min = value;
+    if (n == 0 || value > max) max = value;
+    n++;
+
+    v_levels[0].push_back(value);
+    if (++n_retained >= max_retained) compress();
+}
+
+/**
+ * Adds all values of a (chunk of a) time series to the sketch
+ *
+ * @param v_values values to add
+ */
+void QuantileSketch::update(const std::vector<float>& v_values) {
+    for (float value : v_values) update(value);
+}
+
+/**
+ * Adds the values summarized by `other` to this sketch
+ *
+ * @param other sketch of another chunk of the time series
+ */
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.empty()) return;
+    while (v_levels.size() < other.v_levels.size()) grow();
+    for (unsigned level = 0; level < other.v_levels.size(); level++)
+        v_levels[level].insert(v_levels[level].end(), other.v_levels[level].begin(), other.v_levels[level].end());
+
+    if (n == 0 || other.min < min) min = other.min;
+    if (n == 0 || other.max > max) max = other.max;
+    n += other.n;
+    n_retained += other.n_retained;
+    while (n_retained >= max_retained) compress();
+}
+
+/**
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ * *                        Queries
+ * * ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- ----- -----
+ */
+
+double QuantileSketch::get_min() const { return min; }
+double QuantileSketch::get_max() const { return max; }
+
+/**
+ * Returns the (estimated) number of values that are smaller than `value`
+ *
+ * @param value value to rank
+ * @return the rank of `value`, between 0 and `get_n()`
+ */
+double QuantileSketch::get_rank(double value) const {
+    if (n == 0 || value <= min) return 0;
+    if (value > max) return (double)n;
+
+    uint64_t rank = 0, weight = 1;
+    for (const std::vector<float>& v_values : v_levels) {
+        for (float x : v_values)
+            if (x < value) rank += weight;
+        weight *= 2;
+    }
+    return (double)rank;
+}
+
+/**
+ * Returns the (estimated) `p`-quantile, i.e. the smallest retained value
+ * whose cumulative weight exceeds `p * get_n()`
+ *
+ * @param p probability between 0 and 1
+ * @return the quantile, nan if the sketch is empty
+ */
+double QuantileSketch::get_quantile(double p) const {
+    if (n == 0) return std::numeric_limits<double>::quiet_NaN();
+    if (p <= 0) return min;
+    if (p >= 1) return max;
+
+    std::vector<std::pair<float, uint64_t>> v_weighted;
+    v_weighted.reserve(n_retained);
+    uint64_t weight = 1;
+    for (const std::vector<float>& v_values : v_levels) {
+        for (float x : v_values) v_weighted.push_back(std::make_pair(x, weight));
+        weight *= 2;
+    }
+    std::sort(v_weighted.begin(), v_weighted.end());
+
+    const double target = p * n;
+    double cumulative = 0;
+    for (const std::pair<float, uint64_t>& item : v_weighted) {
+        cumulative += item.second;
+        if (cumulative > target) return item.first;
+    }
+    return max;
+}
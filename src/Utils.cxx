@@ -27,7 +27,10 @@
 
 #include <CMethods.hxx>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 #include "colors.h"
@@ -121,12 +124,30 @@ void show_usage() {
               << "    optional:\n"
               << GREEN << "\t-k, --kind\t\t\t" << RESET << "kind of adjustment e.g.: '+' or '*' for additive or multiplicative method (default: '+')\n"
               << GREEN << "\t-q, --quantiles\t\t\t" << RESET << "number of quantiles to respect when using a distribution-based techniques\n"
+              << GREEN << "\t    --cdf\t\t\t" << RESET << "how to estimate the CDFs for distribution-based techniques: 'histogram' (based on the quantiles), 'exact' "
+                                                          "(based on the sorted samples) or 'sketch' (like 'histogram', based on quantile sketches that are filled time chunk by time chunk "
+                                                          "for 2- and 3-dimensional data sets; default: 'histogram')\n"
+              << GREEN << "\t    --sketch-error\t\t" << RESET << "maximum normalized rank error of the quantile sketches of '--cdf sketch' (default: 0.01)\n"
+              << GREEN << "\t    --lookup-table\t\t" << RESET << "interpolate the transfer functions of QM and QDM from a table with the given number "
+                                                                 "of points per quantile bin instead of evaluating the CDFs for every value (not with '--cdf exact')\n"
+              << GREEN << "\t    --storage\t\t\t" << RESET << "type that stores the data of 2- and 3-dimensional data sets while adjusting: 'float16', 'bfloat16' "
+                                                              "or 'float' (default: 'float')\n"
+              << GREEN << "\t    --fit\t\t\t" << RESET << "only fit the transfer functions based on the reference and control period and save them "
+                                                          "to the given file (only linear_scaling, quantile_mapping and quantile_delta_mapping; not with '--cdf exact')\n"
+              << GREEN << "\t    --apply\t\t\t" << RESET << "adjust the scenario by the transfer functions of the given file (created using --fit); "
+                                                            "the reference and control period and the method settings are not needed\n"
               << GREEN << "\t    --1dim\t\t\t" << RESET << "select this, when all input data sets only contain the time dimension (i.e. no spatial dimensions)\n"
+              << GREEN << "\t    --stations\t\t\t" << RESET << "name of the spatial dimension of 2-dimensional data sets [time][station], e.g. station or ncells; "
+                                                               "the coordinates and IDs of the stations are carried through to the output\n"
+              << GREEN << "\t    --group\t\t\t" << RESET << "grouping of the time steps: 'month' or 'season' (every long-term month resp. season is adjusted separately), "
+                                                            "'dayofyear31' (long-term 31-day intervals, default) or 'none'\n"
               << GREEN << "\t    --no-group\t\t\t" << RESET << "disables the adjustment based on long-term 31-day intervals for the sclaing-based methods; "
                                                                "mean calculation will be performed on the whole data set\n"
+              << GREEN << "\t    --moving-window\t\t" << RESET << "QM and QDM: map every day of the year based on the exact CDFs of its long-term 31-day interval "
+                                                                  "instead of the whole period\n"
               << GREEN << "\t    --max-scaling-factor\t" << RESET << "define the maximum scaling factor to avoid unrealistic results when adjusting ratio based variables "
                                                                      "(default: 10)\n"
-              << GREEN << "\t-p, --processes\t\t\t" << RESET << "number of threads to start (only for 3-dimensional adjustments; default: 1)\n"
+              << GREEN << "\t-p, --processes\t\t\t" << RESET << "number of threads to start, split between the grid cells and the time chunks of a grid cell (default: 1)\n"
               << GREEN << "\t-v, --version\t\t\t" << RESET << "show the executed version of this tool\n"
               << GREEN << "\t-h, --help\t\t\t" << RESET << "show this help message\n"
               << std::endl;
@@ -145,8 +166,8 @@ void show_usage() {
     std::cout << BOLDBLUE << "====== Requirements ======\n"
               << RESET
               << "- data sets must be file type NetCDF\n"
-              << "- for scaling-based techniques: all input files must have 365 days per year (no February 29th.) otherwise the " << GREEN << "--no-group" << RESET << " flag is needed (see notes section below)\n"
-              << "- all data must be in format: [time][lat][lon] (if " << GREEN << "--1dim" << RESET << " is not slected) and values of type float\n"
+              << "- for scaling-based techniques: the time variables must have CF 'units' and 'calendar' attributes, otherwise all input files must have 365 days per year (no February 29th.) or the " << GREEN << "--no-group" << RESET << " flag is needed (see notes section below)\n"
+              << "- all data must be in format: [time][lat][lon] (if " << GREEN << "--1dim" << RESET << " or " << GREEN << "--stations" << RESET << " is not slected) and values of type float\n"
               << "- latitudes, longitudes and times must be named 'lat', 'lon' and 'time'\n"
               << std::endl;
 
@@ -160,7 +181,10 @@ void show_usage() {
                  "and can be readily predicted. They are often referred to as climate elements and include"
                  "variables such as water temperature and air pressure.\n"
 
-              << "- All data sets must exclude the 29th February and every year must have 365 entries. "
+              << "- The long-term 31-day intervals group the time steps by the day of the year, which is decoded from the "
+                 "'units' and 'calendar' attributes of the time variables (standard, gregorian, proleptic_gregorian, julian, "
+                 "noleap, 365_day, all_leap, 366_day and 360_day). The 29th February is part of the interval of the 28th February. "
+                 "Data sets without units must exclude the 29th February and every year must have 365 entries. "
                  "This is not required when using the "
               << GREEN << "`--no-group`" << RESET
               << "flag which can be used to apply the scaling techniques in such a way that the scaling "
@@ -187,6 +211,186 @@ void show_usage() {
     std::cout.flush();
 }
 
+// -----------------------------------------------------------------------------
+// CALENDARS
+
+// days before the months of a year with 365 days
+static const unsigned days_before_month[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+/**
+ * Returns the number of days of `year` in the CF calendar `calendar`. The
+ * "standard" and "gregorian" calendars are treated like the proleptic
+ * Gregorian calendar, so dates before 1582-10-15 are not decoded correctly.
+ *
+ * @param calendar name of the calendar (lower case)
+ * @param year year to get the number of days for
+ * @return 360, 365 or 366
+ */
+static unsigned get_days_in_year(const std::string& calendar, long year) {
+    if (calendar == "360_day")
+        return 360;
+    else if (calendar == "noleap" || calendar == "365_day")
+        return 365;
+    else if (calendar == "all_leap" || calendar == "366_day")
+        return 366;
+    else if (calendar == "julian")
+        return (year % 4 == 0) ? 366 : 365;
+    return ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0) ? 366 : 365;
+}
+
+/**
+ * Returns the number of days that one unit of a CF time axis lasts
+ *
+ * @param unit unit of the time axis, e.g. "days" or "hours"
+ * @return length of the unit in days
+ */
+static double get_days_per_unit(const std::string& unit) {
+    if (unit == "days" || unit == "day" || unit == "d")
+        return 1;
+    else if (unit == "hours" || unit == "hour" || unit == "hrs" || unit == "hr" || unit == "h")
+        return 1. / 24;
+    else if (unit == "minutes" || unit == "minute" || unit == "mins" || unit == "min")
+        return 1. / 1440;
+    else if (unit == "seconds" || unit == "second" || unit == "secs" || unit == "sec" || unit == "s")
+        return 1. / 86400;
+    throw std::runtime_error("Unsupported unit of the time axis: '" + unit + "'!");
+}
+
+/**
+ * Maps the day of a year with `n_days` days onto the days 0...364: February
+ * 29th shares its day with February 28th and the days of the 360-day
+ * calendar are spread evenly, so that 5 days of the year are skipped.
+ *
+ * @param day day of the year (starting at 0)
+ * @param n_days number of days of the year
+ * @return day of the year (0...364)
+ */
+static unsigned get_dayofyear_365(unsigned day, unsigned n_days) {
+    if (n_days == 360)
+        return day * 365 / 360;
+    else if (n_days == 366 && day >= 59)
+        return day - 1;
+    return day;
+}
+
+/**
+ * Decodes a CF time axis and calls `f(ts, year, day, n_days)` with the year,
+ * the day of the year (starting at 0) of every time step and the number of
+ * days of its year. Supported are the calendars "standard", "gregorian",
+ * "proleptic_gregorian", "julian", "noleap", "365_day", "all_leap",
+ * "366_day" and "360_day".
+ *
+ * @param v_time values of the time axis
+ * @param n_time number of time steps
+ * @param units units attribute of the time axis, e.g. "days since 1970-01-01"
+ * @param calendar calendar attribute of the time axis
+ * @param f function to call for every time step
+ */
+template <typename F>
+static void decode_time_axis(const double* v_time, size_t n_time, std::string units, std::string calendar, F f) {
+    std::transform(calendar.begin(), calendar.end(), calendar.begin(), ::tolower);
+    if (!isInStrV(
+            {"standard", "gregorian", "proleptic_gregorian", "julian", "noleap", "365_day", "all_leap", "366_day", "360_day"},
+            calendar
+        ))
+        throw std::runtime_error("Unsupported calendar: '" + calendar + "'!");
+
+    const size_t since = units.find(" since ");
+    if (since == std::string::npos)
+        throw std::runtime_error("Units of the time axis must have the form '<unit> since <date>', got '" + units + "'!");
+    std::string unit = units.substr(0, since);
+    std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+    const double days_per_unit = get_days_per_unit(unit);
+
+    long ref_year = 0;
+    unsigned ref_month = 1, ref_day = 1, hours = 0, minutes = 0;
+    double seconds = 0;
+    const char* ref_date = units.c_str() + since + 7;
+    int n_chars = 0;
+    if (std::sscanf(ref_date, " %ld-%u-%u%n", &ref_year, &ref_month, &ref_day, &n_chars) < 3 ||
+        ref_month < 1 || ref_month > 12 || ref_day < 1 || ref_day > 31)
+        throw std::runtime_error("Invalid reference date of the time axis: '" + units + "'!");
+    std::sscanf(ref_date + n_chars, "%*[ T]%u:%u:%lf", &hours, &minutes, &seconds);
+
+    // days since January 1st of the reference year
+    const bool is_360_day = (calendar == "360_day");
+    const double origin =
+        (is_360_day ? (ref_month - 1) * 30
+                    : days_before_month[ref_month - 1] + ((ref_month > 2 && get_days_in_year(calendar, ref_year) == 366) ? 1 : 0)) +
+        (ref_day - 1) + (hours * 3600 + minutes * 60 + seconds) / 86400;
+
+    long year = ref_year, year_start = 0;  // first day of `year` since January 1st of the reference year
+    for (size_t ts = 0; ts < n_time; ts++) {
+        if (std::isnan(v_time[ts])) throw std::runtime_error("The time axis contains NaN values!");
+        const long day = (long)std::floor(origin + v_time[ts] * days_per_unit + 1e-6);
+        while (day < year_start) year_start -= get_days_in_year(calendar, --year);
+        while (day >= year_start + get_days_in_year(calendar, year)) year_start += get_days_in_year(calendar, year++);
+        f(ts, year, (unsigned)(day - year_start), get_days_in_year(calendar, year));
+    }
+}
+
+/**
+ * Decodes a CF time axis (see `decode_time_axis`) into the day of the year
+ * of every time step, which is the grouping of the long-term 31-day
+ * intervals. The days of all calendars are mapped onto 0...364 (see
+ * `get_dayofyear_365`), so data sets with leap years or 360-day years do not
+ * have to be modified beforehand.
+ *
+ * @param v_time values of the time axis
+ * @param n_time number of time steps
+ * @param units units attribute of the time axis, e.g. "days since 1970-01-01"
+ * @param calendar calendar attribute of the time axis
+ * @return day of the year (0...364) of every time step
+ */
+std::vector<unsigned> get_dayofyear(const double* v_time, size_t n_time, std::string units, std::string calendar) {
+    std::vector<unsigned> v_dayofyear(n_time);
+    decode_time_axis(v_time, n_time, units, calendar, [&](size_t ts, long, unsigned day, unsigned n_days) {
+        v_dayofyear[ts] = get_dayofyear_365(day, n_days);
+    });
+    return v_dayofyear;
+}
+
+/**
+ * Decodes a CF time axis (see `decode_time_axis`) into the month of every
+ * time step. The months of the 360-day calendar have 30 days each.
+ *
+ * @param v_time values of the time axis
+ * @param n_time number of time steps
+ * @param units units attribute of the time axis, e.g. "days since 1970-01-01"
+ * @param calendar calendar attribute of the time axis
+ * @return month (0...11) of every time step
+ */
+std::vector<unsigned> get_month(const double* v_time, size_t n_time, std::string units, std::string calendar) {
+    std::vector<unsigned> v_month(n_time);
+    decode_time_axis(v_time, n_time, units, calendar, [&](size_t ts, long, unsigned day, unsigned n_days) {
+        if (n_days == 360) {
+            v_month[ts] = day / 30;
+            return;
+        }
+        const unsigned day_365 = (n_days == 366 && day >= 59) ? day - 1 : day;  // 29th February
+        v_month[ts] = (unsigned)(std::upper_bound(days_before_month, days_before_month + 12, day_365) - days_before_month) - 1;
+    });
+    return v_month;
+}
+
+/**
+ * Decodes a CF time axis (see `decode_time_axis`) into the year of every
+ * time step
+ *
+ * @param v_time values of the time axis
+ * @param n_time number of time steps
+ * @param units units attribute of the time axis, e.g. "days since 1970-01-01"
+ * @param calendar calendar attribute of the time axis
+ * @return year of every time step
+ */
+std::vector<int> get_year(const double* v_time, size_t n_time, std::string units, std::string calendar) {
+    std::vector<int> v_year(n_time);
+    decode_time_axis(v_time, n_time, units, calendar, [&](size_t ts, long year, unsigned, unsigned) {
+        v_year[ts] = (int)year;
+    });
+    return v_year;
+}
+
 void show_license() {
     const char* license =
         "GNU GENERAL PUBLIC LICENSE\n"
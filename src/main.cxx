@@ -91,6 +91,7 @@ int main(int argc, char** argv) {
             "Please check:\n"
             "    - the dimensions of the input files match:\n"
             "       - 3-dimensional: time, lat, lon | without '--1dim' flag\n"
+            "       - 2-dimensional: time, station  | '--stations <dimension>' is required\n"
             "       - 1-dimensional: time           | '--1dim' flag is required\n"
             "    - the resolutions of the input files must be the same."
             "    - the variable has the same name in all input files."
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "CMethods.hxx"
+#include "Utils.hxx"
 #include "gtest/gtest.h"
 
 namespace TestBiasAdjustCXX {
@@ -181,10 +182,37 @@ TEST_F(TestCMethods, CheckGetAdjustedScalingFactor) {
     ASSERT_EQ(::CMethods::get_adjusted_scaling_factor(-11, -10), -10);
 }
 
+// Test the resolution of the adjustment kind, method and function
+TEST_F(TestCMethods, CheckAdjustmentDispatch) {
+    ASSERT_EQ(::CMethods::get_adjustment_kind("+"), AdjustmentKind::Additive);
+    ASSERT_EQ(::CMethods::get_adjustment_kind("add"), AdjustmentKind::Additive);
+    ASSERT_EQ(::CMethods::get_adjustment_kind("*"), AdjustmentKind::Multiplicative);
+    ASSERT_EQ(::CMethods::get_adjustment_kind("multiplicative"), AdjustmentKind::Multiplicative);
+    ASSERT_THROW(::CMethods::get_adjustment_kind("-"), std::runtime_error);
+    ASSERT_EQ(::CMethods::get_adjustment_kind_name(AdjustmentKind::Multiplicative), "mult");
+
+    ASSERT_EQ(::CMethods::get_adjustment_method("quantile_delta_mapping"), AdjustmentMethod::QuantileDeltaMapping);
+    ASSERT_THROW(::CMethods::get_adjustment_method("quantile_mapping_x"), std::runtime_error);
+
+    ASSERT_THROW(::CMethods::get_adjustment_function(AdjustmentMethod::VarianceScaling, AdjustmentKind::Multiplicative, true), std::runtime_error);
+
+    // the dispatched function must produce the same result as the public method
+    AdjustmentSettings settings = AdjustmentSettings();
+    settings.kind = AdjustmentKind::Multiplicative;
+    std::vector<float> expected(days), result(days);
+    CMethodsWorkspace workspace(days, settings.n_quantiles);
+    ::CMethods::Delta_Method(expected, *reference_prec, *control_prec, *scenario_prec, settings);
+    ::CMethods::get_adjustment_function(AdjustmentMethod::DeltaMethod, settings.kind, settings.interval31_scaling)(
+        result, *reference_prec, *control_prec, *scenario_prec, settings, workspace
+    );
+    for (unsigned ts = 0; ts < days; ts++)
+        ASSERT_EQ(result[ts], expected[ts]);
+}
+
 // Test the additive linear scaling procedure
 TEST_F(TestCMethods, CheckLinearScalingAdditive) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "+";  // default
+    settings.kind = AdjustmentKind::Additive;  // default
 
     std::vector<float> *result = new std::vector<float>(days);  // 10950 entries
     ::CMethods::Linear_Scaling(
@@ -205,7 +233,7 @@ TEST_F(TestCMethods, CheckLinearScalingAdditive) {
 // Test the multiplicative linear scaling procedure
 TEST_F(TestCMethods, CheckLinearScalingMultiplicative) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "*";
+    settings.kind = AdjustmentKind::Multiplicative;
 
     std::vector<float> *result = new std::vector<float>(days);
     ::CMethods::Linear_Scaling(
@@ -226,7 +254,7 @@ TEST_F(TestCMethods, CheckLinearScalingMultiplicative) {
 // Test the (additive) variance scaling procedure
 TEST_F(TestCMethods, CheckVarianceScalingAdditive) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "+";  // default
+    settings.kind = AdjustmentKind::Additive;  // default
 
     std::vector<float> *result = new std::vector<float>(days);
     ::CMethods::Variance_Scaling(
@@ -244,10 +272,35 @@ TEST_F(TestCMethods, CheckVarianceScalingAdditive) {
     delete result;
 }
 
+// Test the (additive) variance scaling procedure with a reused workspace
+TEST_F(TestCMethods, CheckVarianceScalingAdditiveWithWorkspace) {
+    AdjustmentSettings settings = AdjustmentSettings();
+    settings.kind = AdjustmentKind::Additive;  // default
+
+    CMethodsWorkspace workspace;
+    std::vector<float> result(days), result_reused(days), expected(days);
+    ::CMethods::Variance_Scaling(expected, *reference_temp, *control_temp, *scenario_temp, settings);
+    ::CMethods::Variance_Scaling(result, *reference_temp, *control_temp, *scenario_temp, settings, workspace);
+    ::CMethods::Variance_Scaling(result_reused, *reference_temp, *control_temp, *scenario_temp, settings, workspace);
+
+    ASSERT_EQ(workspace.status, CellStatus::Ok);
+    for (unsigned ts = 0; ts < days; ts++) {
+        ASSERT_EQ(result[ts], expected[ts]);
+        ASSERT_EQ(result_reused[ts], expected[ts]);
+    }
+
+    settings.interval31_scaling = false;
+    ::CMethods::Variance_Scaling(result, *reference_temp, *control_temp, *scenario_temp, settings, workspace);
+
+    const double mbe_before = std::abs(mbe(*target_temp, *scenario_temp));
+    const double mbe_after = std::abs(mbe(*target_temp, result));
+    ASSERT_LE(mbe_after, mbe_before);
+}
+
 // Test the additive delta method procedure
 TEST_F(TestCMethods, CheckDeltaMethodAdditive) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "+";  // default
+    settings.kind = AdjustmentKind::Additive;  // default
 
     std::vector<float> *result = new std::vector<float>(days);  // 10950 entries
     ::CMethods::Delta_Method(
@@ -268,7 +321,7 @@ TEST_F(TestCMethods, CheckDeltaMethodAdditive) {
 // Test the multiplicative delta method procedure
 TEST_F(TestCMethods, CheckDeltaMethodMultiplicative) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "*";
+    settings.kind = AdjustmentKind::Multiplicative;
 
     std::vector<float> *result = new std::vector<float>(days);
     ::CMethods::Delta_Method(
@@ -289,7 +342,7 @@ TEST_F(TestCMethods, CheckDeltaMethodMultiplicative) {
 // Test the additive quantile mapping procedure
 TEST_F(TestCMethods, CheckQuantileMappingAdditive) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "+";  // default
+    settings.kind = AdjustmentKind::Additive;  // default
 
     std::vector<float> *result = new std::vector<float>(days);  // 10950 entries
     ::CMethods::Quantile_Mapping(
@@ -310,7 +363,7 @@ TEST_F(TestCMethods, CheckQuantileMappingAdditive) {
 // Test the multiplicative quantile mapping procedure
 TEST_F(TestCMethods, CheckQuantileMappingMultiplicative) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "*";
+    settings.kind = AdjustmentKind::Multiplicative;
 
     std::vector<float> *result = new std::vector<float>(days);
     ::CMethods::Quantile_Mapping(
@@ -328,10 +381,39 @@ TEST_F(TestCMethods, CheckQuantileMappingMultiplicative) {
     delete result;
 }
 
+// Test the additive quantile mapping procedure based on the exact empirical CDFs
+TEST_F(TestCMethods, CheckQuantileMappingExactAdditive) {
+    AdjustmentSettings settings = AdjustmentSettings();
+    settings.kind = AdjustmentKind::Additive;  // default
+    settings.cdf_method = CDFMethod::Exact;
+
+    std::vector<float> *result = new std::vector<float>(days);  // 10950 entries
+    ::CMethods::Quantile_Mapping(
+        *result, *reference_temp, *control_temp, *scenario_temp, settings
+    );
+
+    const double mbe_before = std::abs(mbe(*target_temp, *scenario_temp));
+    const double mbe_after = std::abs(mbe(*target_temp, *result));
+    ASSERT_LE(mbe_after, mbe_before);
+
+    const double rmse_before = rmse(*target_temp, *scenario_temp);
+    const double rmse_after = rmse(*target_temp, *result);
+    ASSERT_LE(rmse_after, rmse_before);
+
+    // mapping a time series onto its own distribution must not change it
+    ::CMethods::Quantile_Mapping(
+        *result, *control_temp, *control_temp, *control_temp, settings
+    );
+    for (unsigned ts = 0; ts < days; ts++)
+        ASSERT_EQ((*result)[ts], (*control_temp)[ts]);
+
+    delete result;
+}
+
 // Test the additive quantile delta mapping procedure
 TEST_F(TestCMethods, CheckQuantileDeltaMappingAdditive) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "+";  // default
+    settings.kind = AdjustmentKind::Additive;  // default
 
     std::vector<float> *result = new std::vector<float>(days);  // 10950 entries
     ::CMethods::Quantile_Delta_Mapping(
@@ -352,7 +434,29 @@ TEST_F(TestCMethods, CheckQuantileDeltaMappingAdditive) {
 // Test the multiplicative quantile delta mapping procedure
 TEST_F(TestCMethods, CheckQuantileDeltaMappingMultiplicative) {
     AdjustmentSettings settings = AdjustmentSettings();
-    settings.kind = "*";
+    settings.kind = AdjustmentKind::Multiplicative;
+
+    std::vector<float> *result = new std::vector<float>(days);
+    ::CMethods::Quantile_Delta_Mapping(
+        *result, *reference_prec, *control_prec, *scenario_prec, settings
+    );
+
+    const double mbe_before = std::abs(mbe(*target_prec, *scenario_prec));
+    const double mbe_after = std::abs(mbe(*target_prec, *result));
+    ASSERT_LE(mbe_after, mbe_before);
+
+    const double rmse_before = rmse(*target_prec, *scenario_prec);
+    const double rmse_after = rmse(*target_prec, *result);
+    ASSERT_LE(rmse_after, rmse_before);
+
+    delete result;
+}
+
+// Test the multiplicative quantile delta mapping procedure based on the exact empirical CDFs
+TEST_F(TestCMethods, CheckQuantileDeltaMappingExactMultiplicative) {
+    AdjustmentSettings settings = AdjustmentSettings();
+    settings.kind = AdjustmentKind::Multiplicative;
+    settings.cdf_method = CDFMethod::Exact;
 
     std::vector<float> *result = new std::vector<float>(days);
     ::CMethods::Quantile_Delta_Mapping(
@@ -369,6 +473,652 @@ TEST_F(TestCMethods, CheckQuantileDeltaMappingMultiplicative) {
 
     delete result;
 }
+
+// Test that the lookup tables approximate the transfer functions and extrapolate exactly
+TEST_F(TestCMethods, CheckLookupTable) {
+    for (AdjustmentMethod method : {AdjustmentMethod::QuantileMapping, AdjustmentMethod::QuantileDeltaMapping}) {
+        for (AdjustmentKind kind : {AdjustmentKind::Additive, AdjustmentKind::Multiplicative}) {
+            AdjustmentSettings settings = AdjustmentSettings();
+            settings.kind = kind;
+            std::vector<float>
+                &reference = (kind == AdjustmentKind::Additive) ? *reference_temp : *reference_prec,
+                &control = (kind == AdjustmentKind::Additive) ? *control_temp : *control_prec,
+                scenario = (kind == AdjustmentKind::Additive) ? *scenario_temp : *scenario_prec;
+
+            // ? values beyond the range of the quantile bins
+            const float max_value = *std::max_element(reference.begin(), reference.end());
+            scenario[0] = 2 * max_value;
+            scenario[1] = (kind == AdjustmentKind::Additive) ? -max_value : max_value * 1.5;
+
+            AdjustmentFunction adjustment_function = ::CMethods::get_adjustment_function(method, kind, false);
+            CMethodsWorkspace workspace;
+            std::vector<float> expected(days), result(days);
+            adjustment_function(expected, reference, control, scenario, settings, workspace);
+
+            settings.lookup_table_resolution = 16;
+            adjustment_function(result, reference, control, scenario, settings, workspace);
+            ASSERT_EQ(result[0], expected[0]);
+            ASSERT_EQ(result[1], expected[1]);
+
+            // ? the tables are exact at the grid points, jumps of the inverse CDFs are smoothed
+            double sum_squared_errors = 0;
+            for (unsigned ts = 2; ts < days; ts++) {
+                ASSERT_NEAR(result[ts], expected[ts], 0.02 * max_value);
+                sum_squared_errors += pow(result[ts] - expected[ts], 2);
+            }
+            ASSERT_LE(sqrt(sum_squared_errors / days), 1e-3 * max_value);
+        }
+    }
+}
+
+// Test QM and QDM based on quantile sketches, also fitted from sketches that were merged chunk by chunk
+TEST_F(TestCMethods, CheckSketchDistributions) {
+    for (AdjustmentMethod method : {AdjustmentMethod::QuantileMapping, AdjustmentMethod::QuantileDeltaMapping}) {
+        for (AdjustmentKind kind : {AdjustmentKind::Additive, AdjustmentKind::Multiplicative}) {
+            AdjustmentSettings settings = AdjustmentSettings();
+            settings.kind = kind;
+            std::vector<float>
+                &reference = (kind == AdjustmentKind::Additive) ? *reference_temp : *reference_prec,
+                &control = (kind == AdjustmentKind::Additive) ? *control_temp : *control_prec,
+                &scenario = (kind == AdjustmentKind::Additive) ? *scenario_temp : *scenario_prec,
+                &target = (kind == AdjustmentKind::Additive) ? *target_temp : *target_prec;
+
+            AdjustmentFunction adjustment_function = ::CMethods::get_adjustment_function(method, kind, false);
+            CMethodsWorkspace workspace;
+            std::vector<float> expected(days), result(days);
+            adjustment_function(expected, reference, control, scenario, settings, workspace);
+
+            // ? sketches that retain all values count exactly like the histograms
+            settings.cdf_method = CDFMethod::Sketch;
+            settings.sketch_error = 1e-4;
+            adjustment_function(result, reference, control, scenario, settings, workspace);
+            for (unsigned ts = 0; ts < days; ts++)
+                ASSERT_EQ(result[ts], expected[ts]);
+
+            // ? bounded sketches still improve the scenario
+            settings.sketch_error = 0.01;
+            adjustment_function(result, reference, control, scenario, settings, workspace);
+            ASSERT_LE(std::abs(mbe(target, result)), std::abs(mbe(target, scenario)));
+            ASSERT_LE(rmse(target, result), rmse(target, scenario));
+
+            // ? fitting from merged sketches of yearly chunks
+            const unsigned k = QuantileSketch::get_k(settings.sketch_error);
+            QuantileSketch reference_sketch(k), control_sketch(k);
+            for (unsigned start = 0; start < days; start += 365) {
+                QuantileSketch reference_chunk(k), control_chunk(k);
+                for (unsigned ts = start; ts < start + 365; ts++) {
+                    reference_chunk.update(reference[ts]);
+                    control_chunk.update(control[ts]);
+                }
+                reference_sketch.merge(reference_chunk);
+                control_sketch.merge(control_chunk);
+            }
+            std::vector<double> parameters(::CMethods::get_n_parameters(method, settings, days, days));
+            ::CMethods::Fit_Transfer_Function(method, parameters.data(), reference_sketch, control_sketch, settings, workspace);
+            ASSERT_GE(parameters[0], 2);
+            ::CMethods::Apply_Transfer_Function(method, result, parameters.data(), scenario, settings, workspace);
+            ASSERT_LE(std::abs(mbe(target, result)), std::abs(mbe(target, scenario)));
+            ASSERT_LE(rmse(target, result), rmse(target, scenario));
+        }
+    }
+    AdjustmentSettings settings = AdjustmentSettings();
+    std::vector<double> parameters(1);
+    CMethodsWorkspace workspace;
+    ASSERT_THROW(
+        ::CMethods::Fit_Transfer_Function(AdjustmentMethod::LinearScaling, parameters.data(), QuantileSketch(), QuantileSketch(), settings, workspace),
+        std::runtime_error
+    );
+}
+
+// Test QM and QDM within the long-term 31-day intervals against sorting every window on its own
+TEST_F(TestCMethods, CheckInterval31Mapping) {
+    for (AdjustmentKind kind : {AdjustmentKind::Additive, AdjustmentKind::Multiplicative}) {
+        std::vector<float>
+            reference = (kind == AdjustmentKind::Additive) ? *reference_temp : *reference_prec,
+            &control = (kind == AdjustmentKind::Additive) ? *control_temp : *control_prec,
+            scenario = (kind == AdjustmentKind::Additive) ? *scenario_temp : *scenario_prec,
+            &target = (kind == AdjustmentKind::Additive) ? *target_temp : *target_prec;
+        reference[100] = NAN;
+        scenario[200] = NAN;
+
+        AdjustmentSettings settings = AdjustmentSettings();
+        settings.kind = kind;
+        settings.interval31_mapping = true;
+        CMethodsWorkspace workspace;
+        std::vector<float> result(days);
+        ::CMethods::Quantile_Mapping(result, reference, control, scenario, settings, workspace);
+        ASSERT_TRUE(std::isnan(result[200]));
+
+        // ? QM of every day of the year based on the exact CDFs of its windows
+        AdjustmentSettings exact_settings = AdjustmentSettings();
+        exact_settings.kind = kind;
+        exact_settings.cdf_method = CDFMethod::Exact;
+        std::vector<std::vector<float>>
+            reference_windows = ::CMethods::get_long_term_dayofyear(reference),
+            control_windows = ::CMethods::get_long_term_dayofyear(control);
+        for (unsigned day = 0; day < 365; day++) {
+            std::vector<float> v_scenario;
+            for (unsigned ts = day; ts < days; ts += 365) v_scenario.push_back(scenario[ts]);
+            std::vector<float> expected(v_scenario.size());
+            ::CMethods::Quantile_Mapping(expected, reference_windows[day], control_windows[day], v_scenario, exact_settings);
+            for (unsigned year = 0; year < v_scenario.size(); year++) {
+                if (std::isnan(expected[year]))
+                    ASSERT_TRUE(std::isnan(result[day + 365 * year]));
+                else
+                    ASSERT_EQ(result[day + 365 * year], expected[year]) << "day " << day << ", year " << year;
+            }
+        }
+
+        // ? the calendar of the time series leads to the same windows
+        std::vector<unsigned> v_dayofyear(days);
+        for (unsigned ts = 0; ts < days; ts++) v_dayofyear[ts] = ts % 365;
+        settings.reference_dayofyear = settings.control_dayofyear = settings.scenario_dayofyear = DayOfYearIndex(v_dayofyear);
+        std::vector<float> result_index(days);
+        ::CMethods::Quantile_Mapping(result_index, reference, control, scenario, settings, workspace);
+        for (unsigned ts = 0; ts < days; ts++) {
+            if (!std::isnan(result[ts])) {
+                ASSERT_EQ(result_index[ts], result[ts]);
+            }
+        }
+
+        ::CMethods::Quantile_Delta_Mapping(result_index, reference, control, scenario, settings, workspace);
+        settings = AdjustmentSettings();
+        settings.kind = kind;
+        settings.interval31_mapping = true;
+        ::CMethods::Quantile_Delta_Mapping(result, reference, control, scenario, settings, workspace);
+        ASSERT_TRUE(std::isnan(result[200]));
+        scenario[200] = result[200] = result_index[200] = target[200];
+        for (unsigned ts = 0; ts < days; ts++)
+            ASSERT_EQ(result_index[ts], result[ts]);
+        ASSERT_LE(std::abs(mbe(target, result)), std::abs(mbe(target, scenario)));
+        ASSERT_LE(rmse(target, result), rmse(target, scenario));
+    }
+}
+
+// Test that missing values are ignored and cells that can't be adjusted are reported by their status
+TEST_F(TestCMethods, CheckCellStatus) {
+    std::vector<float> missing(days, NAN), constant(days, 280), result(days);
+    CMethodsWorkspace workspace;
+
+    // ? control periods without any value leave the time series unchanged
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::VarianceScaling, AdjustmentMethod::DeltaMethod, AdjustmentMethod::QuantileMapping, AdjustmentMethod::QuantileDeltaMapping}) {
+        for (bool interval31_scaling : {false, true}) {
+            AdjustmentSettings settings = AdjustmentSettings();
+            settings.interval31_scaling = interval31_scaling;
+            const std::vector<float>& target = (method == AdjustmentMethod::DeltaMethod) ? *reference_temp : *scenario_temp;
+            ::CMethods::get_adjustment_function(method, AdjustmentKind::Additive, interval31_scaling)(
+                result, *reference_temp, missing, *scenario_temp, settings, workspace
+            );
+            ASSERT_EQ(workspace.status, CellStatus::AllMissing);
+            for (unsigned ts = 0; ts < days; ts++) ASSERT_EQ(result[ts], target[ts]);
+        }
+    }
+
+    // ? the probability boundaries can't be determined if the extremes of both time series are equal
+    AdjustmentSettings settings = AdjustmentSettings();
+    ::CMethods::Quantile_Mapping(result, constant, constant, *scenario_temp, settings, workspace);
+    ASSERT_EQ(workspace.status, CellStatus::Constant);
+    for (unsigned ts = 0; ts < days; ts++) ASSERT_EQ(result[ts], scenario_temp->at(ts));
+
+    // ? a constant reference can be mapped as long as the control period varies
+    std::vector<float> varying_control(days), varying_scenario(days);
+    for (unsigned ts = 0; ts < days; ts++) {
+        varying_control[ts] = 0.5 + 0.96 * (ts % 365) / 364.0;
+        varying_scenario[ts] = 0.7 + 0.88 * (ts % 365) / 364.0;
+    }
+    std::vector<float> constant_reference(days, 1);
+    ASSERT_EQ(::CMethods::get_xbins(constant_reference, varying_control, 100, "regular").size(), 101);
+    ::CMethods::Quantile_Mapping(result, constant_reference, varying_control, varying_scenario, settings, workspace);
+    ASSERT_EQ(workspace.status, CellStatus::Ok);
+    for (unsigned ts = 0; ts < days; ts++) {
+        if (varying_scenario[ts] <= 1.46) {
+            ASSERT_NEAR(result[ts], 1, 0.01);
+        }
+    }
+
+    // ? sparse missing values are ignored by the means and stay missing
+    std::vector<float>
+        reference = *reference_temp,
+        scenario = *scenario_temp;
+    double sum = 0, count = 0, control_sum = 0;
+    for (unsigned ts = 0; ts < days; ts++) {
+        if (ts % 7 == 0) reference[ts] = NAN;
+        if (!std::isnan(reference[ts])) {
+            sum += reference[ts];
+            count++;
+        }
+        control_sum += control_temp->at(ts);
+    }
+    scenario[200] = NAN;
+    settings.interval31_scaling = false;
+    ::CMethods::Linear_Scaling(result, reference, *control_temp, scenario, settings, workspace);
+    ASSERT_EQ(workspace.status, CellStatus::Ok);
+    ASSERT_TRUE(std::isnan(result[200]));
+    for (unsigned ts = 0; ts < days; ts++) {
+        if (ts != 200) {
+            ASSERT_NEAR(result[ts], scenario[ts] + sum / count - control_sum / days, 1e-3);
+        }
+    }
+    for (AdjustmentMethod method : {AdjustmentMethod::VarianceScaling, AdjustmentMethod::QuantileMapping}) {
+        settings.interval31_scaling = true;
+        ::CMethods::get_adjustment_function(method, AdjustmentKind::Additive, true)(
+            result, reference, *control_temp, scenario, settings, workspace
+        );
+        ASSERT_EQ(workspace.status, CellStatus::Ok);
+        for (unsigned ts = 0; ts < days; ts++) ASSERT_EQ(std::isnan(result[ts]), ts == 200);
+    }
+
+    // ? the statuses of the cells of a slab are counted, also by the batched kernels
+    const unsigned n_cells = 3;
+    std::vector<float> v_reference, v_control, v_scenario, v_output(n_cells * days);
+    for (unsigned cell = 0; cell < n_cells; cell++) {
+        v_reference.insert(v_reference.end(), reference_temp->begin(), reference_temp->end());
+        v_control.insert(v_control.end(), control_temp->begin(), control_temp->end());
+        v_scenario.insert(v_scenario.end(), scenario_temp->begin(), scenario_temp->end());
+    }
+    for (unsigned ts = 0; ts < days; ts++) {
+        v_reference[days + ts] = NAN;                              // cell 1: no reference
+        if (ts % 365 < 100) v_reference[2 * days + ts] = NAN;  // cell 2: no reference in spring
+    }
+    const Slab
+        output(v_output.data(), n_cells, days, SlabLayout::CellTime),
+        reference_slab(v_reference.data(), n_cells, days, SlabLayout::CellTime),
+        control_slab(v_control.data(), n_cells, days, SlabLayout::CellTime),
+        scenario_slab(v_scenario.data(), n_cells, days, SlabLayout::CellTime);
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::VarianceScaling}) {
+        CMethodsWorkspace slab_workspace;
+        ::CMethods::Adjust_Slab(method, output, reference_slab, control_slab, scenario_slab, settings, slab_workspace);
+        ASSERT_EQ(slab_workspace.status_counts[(int)CellStatus::Ok], 1);
+        ASSERT_EQ(slab_workspace.status_counts[(int)CellStatus::AllMissing], 1);
+        ASSERT_EQ(slab_workspace.status_counts[(int)CellStatus::Constant], 0);
+        ASSERT_EQ(slab_workspace.status_counts[(int)CellStatus::Fallback], 1);
+        for (unsigned year = 0; year < years; year++) {
+            ASSERT_EQ(output.at(1, year * 365 + 50), scenario_slab.at(1, year * 365 + 50));
+            ASSERT_EQ(output.at(2, year * 365 + 50), scenario_slab.at(2, year * 365 + 50));
+            ASSERT_NE(output.at(2, year * 365 + 200), scenario_slab.at(2, year * 365 + 200));
+        }
+    }
+}
+
+// Test that splitting a grid cell into time chunks and days of the year does not change the results
+TEST_F(TestCMethods, CheckThreadsPerCell) {
+    // ? 240 years, so that the time series are long enough to be split
+    std::vector<float> reference, control, scenario;
+    for (unsigned repetition = 0; repetition < 8; repetition++) {
+        for (unsigned ts = 0; ts < days; ts++) {
+            reference.push_back(reference_temp->at(ts) + 0.01f * repetition);
+            control.push_back(control_temp->at(ts) - 0.02f * repetition);
+            scenario.push_back(scenario_temp->at(ts) + 0.03f * repetition);
+        }
+    }
+    scenario[1000] = NAN;
+    const size_t n_time = scenario.size();
+    std::vector<float> expected(n_time), result(n_time);
+    CMethodsWorkspace workspace;
+
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::VarianceScaling, AdjustmentMethod::QuantileMapping, AdjustmentMethod::QuantileDeltaMapping}) {
+        for (CDFMethod cdf_method : {CDFMethod::Histogram, CDFMethod::Exact}) {
+            for (bool interval31 : {false, true}) {
+                for (unsigned lookup_table_resolution : {0u, 8u}) {
+                    AdjustmentSettings settings = AdjustmentSettings();
+                    settings.kind = (method == AdjustmentMethod::VarianceScaling || lookup_table_resolution == 0) ? AdjustmentKind::Additive : AdjustmentKind::Multiplicative;
+                    settings.cdf_method = cdf_method;
+                    settings.interval31_scaling = interval31;
+                    settings.interval31_mapping = interval31;
+                    settings.lookup_table_resolution = lookup_table_resolution;
+                    AdjustmentFunction adjust = ::CMethods::get_adjustment_function(method, settings.kind, interval31);
+
+                    settings.n_threads = 1;
+                    adjust(expected, reference, control, scenario, settings, workspace);
+                    const CellStatus status = workspace.status;
+                    settings.n_threads = 4;
+                    adjust(result, reference, control, scenario, settings, workspace);
+                    ASSERT_EQ(workspace.status, status);
+                    for (size_t ts = 0; ts < n_time; ts++) {
+                        if (std::isnan(expected[ts]))
+                            ASSERT_TRUE(std::isnan(result[ts]));
+                        else
+                            ASSERT_EQ(result[ts], expected[ts]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Test that the batched adjustment of slabs matches the adjustment of the individual cells
+TEST_F(TestCMethods, CheckAdjustSlab) {
+    const unsigned n_cells = 19;  // more than one batch
+
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::VarianceScaling, AdjustmentMethod::DeltaMethod, AdjustmentMethod::QuantileMapping}) {
+        for (AdjustmentKind kind : {AdjustmentKind::Additive, AdjustmentKind::Multiplicative}) {
+            if (method == AdjustmentMethod::VarianceScaling && kind == AdjustmentKind::Multiplicative) continue;
+            for (bool interval31_scaling : {false, true}) {
+                AdjustmentSettings settings = AdjustmentSettings();
+                settings.kind = kind;
+                settings.interval31_scaling = interval31_scaling;
+                std::vector<float>
+                    &reference = (kind == AdjustmentKind::Additive) ? *reference_temp : *reference_prec,
+                    &control = (kind == AdjustmentKind::Additive) ? *control_temp : *control_prec,
+                    &scenario = (kind == AdjustmentKind::Additive) ? *scenario_temp : *scenario_prec;
+
+                // ? [time][cells] slabs of slightly different cells
+                std::vector<float>
+                    reference_slab(days * n_cells), control_slab(days * n_cells),
+                    scenario_slab(days * n_cells), output_slab(days * n_cells);
+                for (unsigned ts = 0; ts < days; ts++) {
+                    for (unsigned cell = 0; cell < n_cells; cell++) {
+                        reference_slab[ts * n_cells + cell] = reference[ts] * (1 + 0.01 * cell);
+                        control_slab[ts * n_cells + cell] = control[ts];
+                        scenario_slab[ts * n_cells + cell] = scenario[(ts + cell) % days];
+                    }
+                }
+                ::CMethods::Adjust_Slab(
+                    method,
+                    Slab(output_slab.data(), n_cells, days, SlabLayout::TimeCell),
+                    Slab(reference_slab.data(), n_cells, days, SlabLayout::TimeCell),
+                    Slab(control_slab.data(), n_cells, days, SlabLayout::TimeCell),
+                    Slab(scenario_slab.data(), n_cells, days, SlabLayout::TimeCell),
+                    settings
+                );
+
+                AdjustmentFunction adjustment_function = ::CMethods::get_adjustment_function(method, kind, settings.interval31_scaling);
+                CMethodsWorkspace workspace;
+                std::vector<float> v_reference(days), v_control(days), v_scenario(days), expected(days);
+                for (unsigned cell = 0; cell < n_cells; cell++) {
+                    for (unsigned ts = 0; ts < days; ts++) {
+                        v_reference[ts] = reference_slab[ts * n_cells + cell];
+                        v_control[ts] = control_slab[ts * n_cells + cell];
+                        v_scenario[ts] = scenario_slab[ts * n_cells + cell];
+                    }
+                    adjustment_function(expected, v_reference, v_control, v_scenario, settings, workspace);
+                    for (unsigned ts = 0; ts < days; ts++)
+                        ASSERT_EQ(output_slab[ts * n_cells + cell], expected[ts]);
+                }
+            }
+        }
+    }
+}
+
+// Test the conversions of the storage types of reduced precision
+TEST_F(TestCMethods, CheckStorageTypes) {
+    for (float value : {0.0f, -0.0f, 1.5f, -2.0f, 65504.0f, 0.099975586f, 5.9604645e-8f})
+        ASSERT_EQ((float)float16(value), value);
+    for (float value : {0.0f, 1.5f, -2.0f, 0.099609375f, 3.3895314e38f, 9.1835496e-41f})
+        ASSERT_EQ((float)bfloat16(value), value);
+
+    // ties to even
+    ASSERT_EQ((float)float16(1.0f + 1.0f / 2048), 1.0f);
+    ASSERT_EQ((float)float16(1.0f + 3.0f / 2048), 1.0f + 1.0f / 512);
+    ASSERT_EQ((float)bfloat16(1.0f + 1.0f / 256), 1.0f);
+    ASSERT_EQ((float)bfloat16(1.0f + 3.0f / 256), 1.0f + 1.0f / 64);
+    ASSERT_TRUE(std::isinf((float)float16(65520.0f)));
+    ASSERT_TRUE(std::isinf((float)float16(-INFINITY)));
+    ASSERT_TRUE(std::isnan((float)float16(NAN)));
+    ASSERT_TRUE(std::isnan((float)bfloat16(NAN)));
+
+    for (unsigned ts = 0; ts < days; ts++) {
+        const float value = (*scenario_temp)[ts];
+        ASSERT_LE(std::abs((float)float16(value) - value), std::abs(value) / 2048);
+        ASSERT_LE(std::abs((float)bfloat16(value) - value), std::abs(value) / 256);
+    }
+}
+
+// Test that slabs stored in half precision lead to the results of float slabs
+TEST_F(TestCMethods, CheckAdjustSlabStorageTypes) {
+    const unsigned n_cells = 3;
+    std::vector<float> reference, control, scenario;
+    for (unsigned cell = 0; cell < n_cells; cell++) {
+        for (unsigned ts = 0; ts < days; ts++) {
+            reference.push_back((*reference_temp)[ts] + cell);
+            control.push_back((*control_temp)[ts]);
+            scenario.push_back((*scenario_temp)[(ts + cell) % days]);
+        }
+    }
+
+    // copies `v_in` into a slab of storage type `T` and returns its values as float
+    auto round_trip = [](std::vector<float>& v_in, auto value) {
+        std::vector<float> v_out;
+        for (float x : v_in) v_out.push_back((float)(decltype(value))x);
+        return v_out;
+    };
+
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::DeltaMethod, AdjustmentMethod::QuantileMapping}) {
+        AdjustmentSettings settings = AdjustmentSettings();
+        CMethodsWorkspace workspace;
+        std::vector<float16>
+            reference_half(reference.begin(), reference.end()),
+            control_half(control.begin(), control.end()),
+            scenario_half(scenario.begin(), scenario.end()),
+            output_half(n_cells * days);
+        ::CMethods::Adjust_Slab(
+            method,
+            BasicSlab<float16>(output_half.data(), n_cells, days, SlabLayout::CellTime),
+            BasicSlab<float16>(reference_half.data(), n_cells, days, SlabLayout::CellTime),
+            BasicSlab<float16>(control_half.data(), n_cells, days, SlabLayout::CellTime),
+            BasicSlab<float16>(scenario_half.data(), n_cells, days, SlabLayout::CellTime),
+            settings, workspace
+        );
+
+        std::vector<float>
+            reference_rounded = round_trip(reference, float16()),
+            control_rounded = round_trip(control, float16()),
+            scenario_rounded = round_trip(scenario, float16()),
+            expected_rounded(n_cells * days);
+        ::CMethods::Adjust_Slab(
+            method,
+            Slab(expected_rounded.data(), n_cells, days, SlabLayout::CellTime),
+            Slab(reference_rounded.data(), n_cells, days, SlabLayout::CellTime),
+            Slab(control_rounded.data(), n_cells, days, SlabLayout::CellTime),
+            Slab(scenario_rounded.data(), n_cells, days, SlabLayout::CellTime),
+            settings, workspace
+        );
+        // ? the same as adjusting the rounded inputs
+        for (size_t i = 0; i < expected_rounded.size(); i++)
+            ASSERT_EQ((float)output_half[i], (float)float16(expected_rounded[i]));
+    }
+}
+
+// Test that the compensated cumulative sums only change the rounding of the means
+TEST_F(TestCMethods, CheckCompensatedSummation) {
+    for (bool interval31_scaling : {true, false}) {
+        AdjustmentSettings settings = AdjustmentSettings();
+        settings.interval31_scaling = interval31_scaling;
+        std::vector<float> expected(days), result(days);
+        ::CMethods::Linear_Scaling(expected, *reference_temp, *control_temp, *scenario_temp, settings);
+
+        settings.compensated_summation = true;
+        ::CMethods::Linear_Scaling(result, *reference_temp, *control_temp, *scenario_temp, settings);
+        for (unsigned ts = 0; ts < days; ts++)
+            ASSERT_NEAR(result[ts], expected[ts], 1e-4);
+    }
+}
+
+// Test that a reused workspace neither changes the results nor allocates memory again
+TEST_F(TestCMethods, CheckWorkspaceReuse) {
+    AdjustmentSettings settings = AdjustmentSettings();
+    settings.kind = AdjustmentKind::Multiplicative;
+    CMethodsWorkspace workspace(days, settings.n_quantiles);
+
+    std::vector<float> expected(days), result(days);
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::QuantileMapping, AdjustmentMethod::QuantileDeltaMapping}) {
+        for (CDFMethod cdf_method : {CDFMethod::Histogram, CDFMethod::Exact}) {
+            settings.cdf_method = cdf_method;
+            AdjustmentFunction adjustment_function = ::CMethods::get_adjustment_function(method, settings.kind, settings.interval31_scaling);
+
+            CMethodsWorkspace fresh_workspace;
+            adjustment_function(expected, *reference_prec, *control_prec, *scenario_prec, settings, fresh_workspace);
+            adjustment_function(result, *reference_prec, *control_prec, *scenario_prec, settings, workspace);
+            for (unsigned ts = 0; ts < days; ts++)
+                ASSERT_EQ(result[ts], expected[ts]);
+        }
+    }
+
+    // ? the buffers have been reserved in advance and must not be reallocated
+    const double
+        *xbins = workspace.v_xbins.data(),
+        *cdf = workspace.v_scenario_cdf.data(),
+        *sorted = workspace.v_control_sorted.data(),
+        *means = workspace.v_numerator_means.data();
+    const unsigned* order = workspace.v_scenario_order.data();
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::QuantileDeltaMapping}) {
+        for (CDFMethod cdf_method : {CDFMethod::Histogram, CDFMethod::Exact}) {
+            settings.cdf_method = cdf_method;
+            ::CMethods::get_adjustment_function(method, settings.kind, settings.interval31_scaling)(
+                result, *reference_prec, *control_prec, *scenario_prec, settings, workspace
+            );
+        }
+    }
+    ASSERT_EQ(workspace.v_xbins.data(), xbins);
+    ASSERT_EQ(workspace.v_scenario_cdf.data(), cdf);
+    ASSERT_EQ(workspace.v_control_sorted.data(), sorted);
+    ASSERT_EQ(workspace.v_numerator_means.data(), means);
+    ASSERT_EQ(workspace.v_scenario_order.data(), order);
+}
+
+// Test that fitting and applying the transfer functions matches the adjustment procedures
+TEST_F(TestCMethods, CheckTransferFunctions) {
+    AdjustmentSettings settings = AdjustmentSettings();
+    ASSERT_THROW(::CMethods::get_n_parameters(AdjustmentMethod::DeltaMethod, settings, days, days), std::runtime_error);
+
+    CMethodsWorkspace workspace(days, settings.n_quantiles);
+    std::vector<float> expected(days), result(days);
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::QuantileMapping, AdjustmentMethod::QuantileDeltaMapping}) {
+        for (AdjustmentKind kind : {AdjustmentKind::Additive, AdjustmentKind::Multiplicative}) {
+            for (CDFMethod cdf_method : {CDFMethod::Histogram, CDFMethod::Exact}) {
+                for (bool interval31_scaling : {true, false}) {
+                    settings.kind = kind;
+                    settings.cdf_method = cdf_method;
+                    settings.interval31_scaling = interval31_scaling;
+                    std::vector<float>
+                        &reference = (kind == AdjustmentKind::Additive) ? *reference_temp : *reference_prec,
+                        &control = (kind == AdjustmentKind::Additive) ? *control_temp : *control_prec,
+                        &scenario = (kind == AdjustmentKind::Additive) ? *scenario_temp : *scenario_prec;
+
+                    std::vector<double> parameters(::CMethods::get_n_parameters(method, settings, days, days));
+                    ::CMethods::Fit_Transfer_Function(method, parameters.data(), reference, control, settings, workspace);
+                    ::CMethods::Apply_Transfer_Function(method, result, parameters.data(), scenario, settings, workspace);
+                    ::CMethods::get_adjustment_function(method, kind, interval31_scaling)(
+                        expected, reference, control, scenario, settings, workspace
+                    );
+                    for (unsigned ts = 0; ts < days; ts++)
+                        ASSERT_EQ(result[ts], expected[ts]);
+                }
+            }
+        }
+    }
+}
+
+// Test that the day-of-year index of complete 365-day years does not change
+// the results and that leap years can be adjusted
+TEST_F(TestCMethods, CheckDayOfYearIndex) {
+    std::vector<unsigned> v_dayofyear(days);
+    for (unsigned ts = 0; ts < days; ts++) v_dayofyear[ts] = ts % 365;
+    const DayOfYearIndex index(v_dayofyear);
+    ASSERT_EQ(index.n_years, days / 365);
+
+    std::vector<std::vector<float>>
+        expected_windows = ::CMethods::get_long_term_dayofyear(*reference_temp),
+        windows = ::CMethods::get_long_term_dayofyear(*reference_temp, index);
+    ASSERT_EQ(windows, expected_windows);
+
+    std::vector<float> expected(days), result(days);
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::VarianceScaling, AdjustmentMethod::DeltaMethod}) {
+        AdjustmentSettings settings = AdjustmentSettings();
+        AdjustmentFunction adjustment_function = ::CMethods::get_adjustment_function(method, settings.kind, true);
+        CMethodsWorkspace workspace;
+        adjustment_function(expected, *reference_temp, *control_temp, *scenario_temp, settings, workspace);
+
+        settings.reference_dayofyear = settings.control_dayofyear = settings.scenario_dayofyear = index;
+        adjustment_function(result, *reference_temp, *control_temp, *scenario_temp, settings, workspace);
+        for (unsigned ts = 0; ts < days; ts++)
+            ASSERT_EQ(result[ts], expected[ts]);
+    }
+
+    // ? 4 years including the leap year 2000
+    const unsigned n_time = 4 * 365 + 1;
+    std::vector<double> v_time(n_time);
+    for (unsigned ts = 0; ts < n_time; ts++) v_time[ts] = ts;
+    AdjustmentSettings settings = AdjustmentSettings();
+    settings.reference_dayofyear = settings.control_dayofyear = settings.scenario_dayofyear =
+        DayOfYearIndex(utils::get_dayofyear(v_time.data(), n_time, "days since 2000-01-01", "standard"));
+
+    std::vector<float>
+        reference(reference_temp->begin(), reference_temp->begin() + n_time),
+        control(control_temp->begin(), control_temp->begin() + n_time),
+        scenario(scenario_temp->begin(), scenario_temp->begin() + n_time),
+        output(n_time);
+    ::CMethods::Linear_Scaling(output, reference, control, scenario, settings);
+    for (unsigned ts = 0; ts < n_time; ts++) ASSERT_FALSE(std::isnan(output[ts]));
+    ASSERT_NEAR(output[59] - scenario[59], output[58] - scenario[58], 1e-5);  // 29th February
+    ASSERT_THROW(
+        ::CMethods::Linear_Scaling(output, *reference_temp, *control_temp, *scenario_temp, settings),
+        std::runtime_error
+    );
+}
+
+// Test that grouping by month equals adjusting the months one by one
+TEST_F(TestCMethods, CheckAdjustGroups) {
+    std::vector<double> v_time(days);
+    for (unsigned ts = 0; ts < days; ts++) v_time[ts] = ts;
+    const std::vector<unsigned> v_month = utils::get_month(v_time.data(), days, "days since 1971-01-01", "noleap");
+
+    AdjustmentSettings settings = AdjustmentSettings();
+    settings.kind = AdjustmentKind::Multiplicative;
+    settings.reference_groups = settings.control_groups = settings.scenario_groups = TimeGroups(v_month, 12);
+    CMethodsWorkspace workspace;
+
+    std::vector<float> result(days);
+    for (AdjustmentMethod method : {AdjustmentMethod::LinearScaling, AdjustmentMethod::DeltaMethod, AdjustmentMethod::QuantileMapping, AdjustmentMethod::QuantileDeltaMapping}) {
+        ::CMethods::Adjust_Groups(method, result, *reference_prec, *control_prec, *scenario_prec, settings, workspace);
+
+        for (unsigned month = 0; month < 12; month++) {
+            std::vector<float> reference, control, scenario, expected;
+            std::vector<unsigned> time_steps;
+            for (unsigned ts = 0; ts < days; ts++) {
+                if (v_month[ts] != month) continue;
+                reference.push_back((*reference_prec)[ts]);
+                control.push_back((*control_prec)[ts]);
+                scenario.push_back((*scenario_prec)[ts]);
+                time_steps.push_back(ts);
+            }
+            expected.resize(time_steps.size());
+            CMethodsWorkspace month_workspace;
+            ::CMethods::get_adjustment_function(method, settings.kind, false)(
+                expected, reference, control, scenario, settings, month_workspace
+            );
+            for (unsigned i = 0; i < time_steps.size(); i++)
+                ASSERT_EQ(result[time_steps[i]], expected[i]);
+        }
+    }
+
+    // ? slabs are adjusted cell by cell and group by group
+    std::vector<float> expected(days), output(2 * days), reference(2 * days), control(2 * days), scenario(2 * days);
+    for (unsigned ts = 0; ts < days; ts++) {
+        reference[ts] = reference[days + ts] = (*reference_prec)[ts];
+        control[ts] = control[days + ts] = (*control_prec)[ts];
+        scenario[ts] = scenario[days + ts] = (*scenario_prec)[ts];
+    }
+    ::CMethods::Adjust_Groups(AdjustmentMethod::LinearScaling, expected, *reference_prec, *control_prec, *scenario_prec, settings, workspace);
+    ::CMethods::Adjust_Slab(
+        AdjustmentMethod::LinearScaling,
+        Slab(output.data(), 2, days, SlabLayout::CellTime),
+        Slab(reference.data(), 2, days, SlabLayout::CellTime),
+        Slab(control.data(), 2, days, SlabLayout::CellTime),
+        Slab(scenario.data(), 2, days, SlabLayout::CellTime),
+        settings
+    );
+    for (unsigned ts = 0; ts < days; ts++) {
+        ASSERT_EQ(output[ts], expected[ts]);
+        ASSERT_EQ(output[days + ts], expected[ts]);
+    }
+
+    settings.control_groups = TimeGroups();
+    ASSERT_THROW(
+        ::CMethods::Adjust_Groups(AdjustmentMethod::LinearScaling, result, *reference_prec, *control_prec, *scenario_prec, settings, workspace),
+        std::runtime_error
+    );
+}
 }  // namespace
 }  // namespace CMethods
 }  // namespace TestBiasAdjustCXX
@@ -0,0 +1,131 @@
+// -*- lsst-c++ -*-
+/**
+ * @file TestKernels.cxx
+ * @brief Implements the unit tests of the Kernels class
+ * @author Benjamin Thomas Schwertfeger
+ * @email: contact@b-schwertfeger.de
+ * @link https://github.com/btschwertfeger/BiasAdjustCXX
+ *
+ *  * Copyright (C) 2023 Benjamin Thomas Schwertfeger
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "Kernels.hxx"
+#include "gtest/gtest.h"
+
+namespace TestBiasAdjustCXX {
+namespace Kernels {
+namespace {
+
+// The fixture for testing class Kernels.
+class TestKernels : public ::testing::Test {
+   protected:
+    TestKernels() {
+    }
+
+    ~TestKernels() override {
+    }
+
+    void SetUp() override {
+        default_instruction_set = ::Kernels::get_instruction_set();
+
+        // 3 years and some days, so that no year is a multiple of the vector width
+        input = std::vector<float>(3 * 365 + 17);
+        for (unsigned ts = 0; ts < input.size(); ts++)
+            input[ts] = 20 * sin(0.1 * ts) + 0.001 * ts;
+        input[5] = NAN;
+
+        for (unsigned day = 0; day < 365; day++) {
+            float_table[day] = 0.5 + 0.01 * day;
+            offsets[day] = -0.3 * day;
+            factors[day] = 1.0 + 0.002 * day;
+            means[day] = 7.25 - 0.1 * day;
+        }
+    }
+
+    void TearDown() override {
+        ::Kernels::set_instruction_set(default_instruction_set);
+    }
+
+    /**
+     * Runs all kernels using the instruction set `instruction_set`
+     *
+     * @return outputs of all kernels
+     */
+    std::vector<std::vector<float>> run_kernels(InstructionSet instruction_set) {
+        ::Kernels::set_instruction_set(instruction_set);
+        const size_t n = input.size();
+        std::vector<std::vector<float>> outputs(4, std::vector<float>(n));
+        ::Kernels::add_dayofyear(outputs[0].data(), input.data(), n, float_table);
+        ::Kernels::multiply_dayofyear(outputs[1].data(), input.data(), n, float_table);
+        ::Kernels::affine_dayofyear(outputs[2].data(), input.data(), n, offsets, factors, means);
+        ::Kernels::affine(outputs[3].data(), input.data(), n, -1.5, 0.75, 3.25);
+        return outputs;
+    }
+
+    InstructionSet default_instruction_set;
+    std::vector<float> input;
+    float float_table[365];
+    double offsets[365], factors[365], means[365];
+};
+
+// Test that the scalar reference is always available and the fastest one is used
+TEST_F(TestKernels, CheckAvailableInstructionSets) {
+    std::vector<InstructionSet> instruction_sets = ::Kernels::get_available_instruction_sets();
+    ASSERT_GE(instruction_sets.size(), 1);
+    ASSERT_EQ(instruction_sets[0], InstructionSet::Scalar);
+    ASSERT_EQ(default_instruction_set, instruction_sets[instruction_sets.size() - 1]);
+    ASSERT_EQ(::Kernels::get_instruction_set_name(InstructionSet::AVX2), "avx2");
+}
+
+// Test the scalar reference against the formulas
+TEST_F(TestKernels, CheckScalarKernels) {
+    std::vector<std::vector<float>> outputs = run_kernels(InstructionSet::Scalar);
+    for (unsigned ts = 0; ts < input.size(); ts++) {
+        if (ts == 5) {
+            for (unsigned k = 0; k < outputs.size(); k++)
+                ASSERT_TRUE(std::isnan(outputs[k][ts]));
+            continue;
+        }
+        const unsigned day = ts % 365;
+        ASSERT_EQ(outputs[0][ts], input[ts] + float_table[day]);
+        ASSERT_EQ(outputs[1][ts], input[ts] * float_table[day]);
+        ASSERT_EQ(outputs[2][ts], (float)(((double)input[ts] + offsets[day]) * factors[day] + means[day]));
+        ASSERT_EQ(outputs[3][ts], (float)(((double)input[ts] - 1.5) * 0.75 + 3.25));
+    }
+}
+
+// Test that all vectorized kernels available on this machine match the scalar reference
+TEST_F(TestKernels, CheckVectorizedKernels) {
+    std::vector<std::vector<float>> expected = run_kernels(InstructionSet::Scalar);
+    for (InstructionSet instruction_set : ::Kernels::get_available_instruction_sets()) {
+        std::vector<std::vector<float>> outputs = run_kernels(instruction_set);
+        for (unsigned k = 0; k < outputs.size(); k++) {
+            for (unsigned ts = 0; ts < input.size(); ts++) {
+                if (std::isnan(expected[k][ts]))
+                    ASSERT_TRUE(std::isnan(outputs[k][ts]));
+                else
+                    ASSERT_FLOAT_EQ(outputs[k][ts], expected[k][ts])
+                        << ::Kernels::get_instruction_set_name(instruction_set) << ", kernel " << k << ", ts " << ts;
+            }
+        }
+    }
+}
+}  // namespace
+}  // namespace Kernels
+}  // namespace TestBiasAdjustCXX
@@ -23,6 +23,14 @@
  */
 
 #include "Manager.hxx"
+
+#include <netcdf.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace TestBiasAdjustCXX {
@@ -39,13 +47,144 @@ class TestManager : public ::testing::Test {
     }
 
     void SetUp() override {
+        // ? [time][station] data sets of the reference, control and scenario period
+        for (const std::string& period : periods) {
+            const double shift = (period == "reference") ? 0 : (period == "control") ? 1.3 : 2.1;
+            std::vector<float> values(n_time * n_stations);
+            for (size_t ts = 0; ts < n_time; ts++)
+                for (size_t station = 0; station < n_stations; station++)
+                    values[ts * n_stations + station] = (float)(280 + 10 * sin(2 * M_PI * ts / 365) + shift + 0.5 * station +
+                                                                3 * sin(1.7 * ts + station + 5 * shift));
+            write_dataset(get_path(period), values, true);
+
+            // ? the time series of every station as a 1-dimensional data set
+            std::vector<float> timeseries(n_time);
+            for (size_t station = 0; station < n_stations; station++) {
+                for (size_t ts = 0; ts < n_time; ts++) timeseries[ts] = values[ts * n_stations + station];
+                write_dataset(get_path(period, station), timeseries, false);
+            }
+        }
     }
 
     void TearDown() override {
+        for (const std::string& period : periods) {
+            std::remove(get_path(period).c_str());
+            for (size_t station = 0; station < n_stations; station++) std::remove(get_path(period, station).c_str());
+        }
+        std::remove(output_2d_path.c_str());
+        std::remove(output_1d_path.c_str());
+    }
+
+    // returns the path of the data set of `period` (all stations resp. one station)
+    static std::string get_path(const std::string& period, long station = -1) {
+        return "TestManager_" + period + ((station < 0) ? "" : "_" + std::to_string(station)) + ".nc";
     }
+
+    // writes the variable `tas` (time x station with the coordinates and IDs
+    // of the stations, or only time if `with_stations` is false)
+    void write_dataset(const std::string& path, const std::vector<float>& values, bool with_stations) {
+        netCDF::NcFile file(path, netCDF::NcFile::replace);
+        std::vector<netCDF::NcDim> dimensions = {file.addDim("time", n_time)};
+
+        netCDF::NcVar time_var = file.addVar("time", netCDF::ncDouble, dimensions[0]);
+        time_var.putAtt("units", "days since 2000-01-01 00:00:00");
+        time_var.putAtt("calendar", "noleap");
+        std::vector<double> time_values(n_time);
+        for (size_t ts = 0; ts < n_time; ts++) time_values[ts] = (double)ts;
+        time_var.putVar(time_values.data());
+
+        if (with_stations) {
+            dimensions.push_back(file.addDim("station", n_stations));
+            netCDF::NcVar lat_var = file.addVar("lat", netCDF::ncFloat, dimensions[1]);
+            lat_var.putAtt("units", "degrees_north");
+            lat_var.putVar(lat_values.data());
+
+            netCDF::NcVar id_var = file.addVar("station_id", netCDF::ncString, dimensions[1]);
+            id_var.putAtt("cf_role", "timeseries_id");
+            id_var.putVar(station_ids.data());
+        }
+
+        netCDF::NcVar data_var = file.addVar("tas", netCDF::ncFloat, dimensions);
+        data_var.putVar(values.data());
+    }
+
+    // runs BiasAdjustCXX with the given command-line arguments
+    static void run(const std::vector<std::string>& arguments) {
+        std::vector<char*> argv = {(char*)"BiasAdjustCXX"};
+        for (const std::string& argument : arguments) argv.push_back((char*)argument.c_str());
+        ::Manager manager((int)argv.size(), argv.data());
+        manager.run_adjustment();
+    }
+
+    // returns the values of the variable `tas` of `path`
+    static std::vector<float> read_values(const std::string& path, size_t n_values) {
+        netCDF::NcFile file(path, netCDF::NcFile::read);
+        std::vector<float> values(n_values);
+        file.getVar("tas").getVar(values.data());
+        return values;
+    }
+
+    const size_t
+        n_time = 3 * 365,
+        n_stations = 5;
+    const std::vector<std::string> periods = {"reference", "control", "scenario"};
+    const std::string
+        output_2d_path = "TestManager_output_2d.nc",
+        output_1d_path = "TestManager_output_1d.nc";
+    const std::vector<float> lat_values = {52.1f, 53.5f, 48.2f, 50.9f, 54.3f};
+    const std::vector<const char*> station_ids = {"10382", "10147", "10870", "10513", "10046"};
 };
 
-// Not tested so far since this would required acceptance tests
+// Test that the adjustment of a 2-dimensional data set (time x station)
+// matches the adjustment of every station as a 1-dimensional data set
+TEST_F(TestManager, CheckStationsMatchOneDim) {
+    const std::vector<std::vector<std::string>> options = {
+        {"-m", "linear_scaling"},
+        {"-m", "linear_scaling", "-k", "*"},
+        {"-m", "variance_scaling"},
+        {"-m", "delta_method"},
+        {"-m", "delta_method", "-k", "*"},
+        {"-m", "quantile_mapping"},
+        {"-m", "quantile_mapping", "-k", "*"},
+        {"-m", "quantile_mapping", "--cdf", "exact"},
+        {"-m", "quantile_mapping", "--cdf", "sketch"},
+        {"-m", "quantile_delta_mapping", "-k", "*"},
+        {"-m", "quantile_delta_mapping", "--cdf", "sketch"},
+    };
+
+    for (const std::vector<std::string>& option : options) {
+        std::vector<std::string> arguments = {
+            "--ref", get_path("reference"), "--contr", get_path("control"), "--scen", get_path("scenario"),
+            "-v", "tas", "-o", output_2d_path, "--stations", "station", "-p", "2"
+        };
+        arguments.insert(arguments.end(), option.begin(), option.end());
+        run(arguments);
+        const std::vector<float> output_2d = read_values(output_2d_path, n_time * n_stations);
+
+        for (size_t station = 0; station < n_stations; station++) {
+            arguments = {
+                "--ref", get_path("reference", station), "--contr", get_path("control", station), "--scen", get_path("scenario", station),
+                "-v", "tas", "-o", output_1d_path, "--1dim"
+            };
+            arguments.insert(arguments.end(), option.begin(), option.end());
+            run(arguments);
+            const std::vector<float> output_1d = read_values(output_1d_path, n_time);
+            for (size_t ts = 0; ts < n_time; ts++)
+                ASSERT_EQ(output_2d[ts * n_stations + station], output_1d[ts]) << option[1] << ", station " << station << ", time step " << ts;
+        }
+    }
+
+    // ? the coordinates and IDs of the stations are carried through
+    netCDF::NcFile file(output_2d_path, netCDF::NcFile::read);
+    std::vector<float> lat(n_stations);
+    file.getVar("lat").getVar(lat.data());
+    EXPECT_EQ(lat, lat_values);
+    std::vector<char*> ids(n_stations);
+    file.getVar("station_id").getVar(ids.data());
+    for (size_t station = 0; station < n_stations; station++)
+        EXPECT_EQ(std::string(ids[station]), station_ids[station]);
+    nc_free_string(n_stations, ids.data());
+}
 }  // namespace
 }  // namespace Manager
 }  // namespace TestBiasAdjustCXX
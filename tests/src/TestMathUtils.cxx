@@ -22,6 +22,7 @@
  *  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -112,6 +113,109 @@ TEST_F(TestMathUtils, CheckIndexOfAgreement) {
     // ASSERT_DOUBLE_EQ(::MathUtils::ioa(y, z), 0.18594436310395313);
 }
 
+// Test that the fused indicators match the definitions and ignore pairs with nan
+TEST_F(TestMathUtils, CheckComputeIndicators) {
+    std::vector<float> reference(5001), prediction(5001);
+    for (unsigned ts = 0; ts < reference.size(); ts++) {
+        reference[ts] = 280 + 10 * sin(2 * M_PI * ts / 365.25) + 3 * sin(1.7 * ts);
+        prediction[ts] = reference[ts] + 0.5 + 2 * cos(0.9 * ts);
+    }
+    prediction[7] = NAN;
+
+    // ? naive definitions over the valid pairs
+    double n = 0, sum_x = 0, sum_y = 0, sum_d = 0, sum_d2 = 0;
+    for (unsigned ts = 0; ts < reference.size(); ts++) {
+        if (std::isnan(prediction[ts])) continue;
+        n++;
+        sum_x += reference[ts];
+        sum_y += prediction[ts];
+        sum_d += prediction[ts] - reference[ts];
+        sum_d2 += (prediction[ts] - reference[ts]) * (prediction[ts] - reference[ts]);
+    }
+    const double mean_x = sum_x / n, mean_y = sum_y / n;
+    double cov = 0, var_x = 0, var_y = 0, lower = 0;
+    for (unsigned ts = 0; ts < reference.size(); ts++) {
+        if (std::isnan(prediction[ts])) continue;
+        cov += (reference[ts] - mean_x) * (prediction[ts] - mean_y);
+        var_x += (reference[ts] - mean_x) * (reference[ts] - mean_x);
+        var_y += (prediction[ts] - mean_y) * (prediction[ts] - mean_y);
+        lower += pow(std::abs(prediction[ts] - mean_x) + std::abs(reference[ts] - mean_x), 2);
+    }
+
+    const std::vector<std::string> names({"rmse", "mbe", "ioa", "corr"});
+    std::vector<double> results(names.size());
+    ::MathUtils::compute_indicators(names, reference.data(), prediction.data(), reference.size(), results.data());
+    ASSERT_NEAR(results[0], sqrt(sum_d2 / n), 1e-9);
+    ASSERT_NEAR(results[1], sum_d / n, 1e-9);
+    ASSERT_NEAR(results[2], 1 - sum_d2 / lower, 1e-9);
+    ASSERT_NEAR(results[3], cov / sqrt(var_x * var_y), 1e-9);
+    ASSERT_EQ(results[0], ::MathUtils::rmse(reference, prediction));
+    ASSERT_EQ(results[1], ::MathUtils::mbe(reference, prediction));
+    ASSERT_EQ(results[2], ::MathUtils::ioa(reference, prediction));
+    ASSERT_EQ(results[3], ::MathUtils::correlation_coefficient(reference, prediction));
+
+    // ? statistics of merged chunks
+    ::PairedMoments merged;
+    for (unsigned start = 0; start < reference.size(); start += 777) {
+        ::PairedMoments chunk;
+        const size_t length = std::min((size_t)777, reference.size() - start);
+        chunk.update(reference.data() + start, prediction.data() + start, length);
+        merged.merge(chunk);
+    }
+    ASSERT_EQ(merged.get_n(), (uint64_t)n);
+    ASSERT_NEAR(merged.get_rmse(), results[0], 1e-9);
+    ASSERT_NEAR(merged.get_mbe(), results[1], 1e-9);
+    ASSERT_NEAR(merged.get_correlation(), results[3], 1e-9);
+
+    const std::vector<std::string> names_1_ds({"mean", "sd", "var"});
+    ::MathUtils::compute_indicators(names_1_ds, reference.data(), nullptr, reference.size(), results.data());
+    ASSERT_EQ(results[0], ::MathUtils::mean(reference));
+    ASSERT_EQ(results[1], ::MathUtils::sd(reference));
+    ASSERT_EQ(results[2], ::MathUtils::variance(reference));
+
+    ASSERT_THROW(::MathUtils::compute_indicators(names, reference.data(), nullptr, reference.size(), results.data()), std::runtime_error);
+    ASSERT_THROW(::MathUtils::compute_indicators({"median"}, reference.data(), nullptr, reference.size(), results.data()), std::runtime_error);
+}
+
+// Test that the grouped indicators match the indicators of the subsets of the groups
+TEST_F(TestMathUtils, CheckGroupedIndicators) {
+    std::vector<float> reference(3000), prediction(3000);
+    std::vector<int> groups(3000);
+    for (unsigned ts = 0; ts < reference.size(); ts++) {
+        reference[ts] = 10 * sin(2 * M_PI * ts / 365.25) + 2 * sin(1.3 * ts);
+        prediction[ts] = reference[ts] + 0.5 * cos(0.7 * ts) + 0.2;
+        groups[ts] = (ts % 365) / 122;  // 3 "seasons"
+        if (ts % 11 == 0) groups[ts] = -1;
+    }
+
+    const unsigned n_groups = 4;  // the last group is empty
+    const std::vector<std::string> names({"rmse", "mbe", "ioa", "corr"});
+    ::GroupedIndicators grouped(names, groups, n_groups);
+    ASSERT_EQ(grouped.get_n_groups(), n_groups);
+
+    std::vector<double> results(n_groups * names.size()), expected(names.size());
+    for (unsigned repetition = 0; repetition < 2; repetition++) {
+        grouped.compute(reference.data(), prediction.data(), results.data());
+        for (int group = 0; group < 3; group++) {
+            std::vector<float> x, y;
+            for (unsigned ts = 0; ts < reference.size(); ts++) {
+                if (groups[ts] != group) continue;
+                x.push_back(reference[ts]);
+                y.push_back(prediction[ts]);
+            }
+            ::MathUtils::compute_indicators(names, x.data(), y.data(), x.size(), expected.data());
+            for (unsigned i = 0; i < names.size(); i++)
+                ASSERT_NEAR(results[group * names.size() + i], expected[i], 1e-9);
+        }
+        for (unsigned i = 0; i < names.size(); i++)
+            ASSERT_TRUE(std::isnan(results[3 * names.size() + i]));
+    }
+
+    ASSERT_THROW(::GroupedIndicators({"median"}, groups, n_groups), std::runtime_error);
+    ASSERT_THROW(grouped.compute(reference.data(), nullptr, results.data()), std::runtime_error);
+    ASSERT_THROW(::GroupedIndicators({"rmse"}, groups, 2), std::runtime_error);
+}
+
 // Test of the Standard Deviation function
 TEST_F(TestMathUtils, CheckStandardDeviation) {
     ASSERT_DOUBLE_EQ(::MathUtils::sd(x), 0);
@@ -119,6 +223,51 @@ TEST_F(TestMathUtils, CheckStandardDeviation) {
     ASSERT_DOUBLE_EQ(::MathUtils::sd(z), 0.8539125638299665);
 }
 
+// Test that the moments of merged chunks match the moments of the whole series
+TEST_F(TestMathUtils, CheckMoments) {
+    // large offset, so that naive sums of squares would cancel
+    std::vector<float> values(100003);
+    for (unsigned ts = 0; ts < values.size(); ts++) values[ts] = 10000 + (ts % 3) + (ts == 5 ? NAN : 0);
+
+    long double sum = 0, sum_squares = 0;
+    for (float value : values)
+        if (!std::isnan(value)) sum += value;
+    const long double expected_mean = sum / (values.size() - 1);
+    for (float value : values)
+        if (!std::isnan(value)) sum_squares += (value - expected_mean) * (value - expected_mean);
+
+    ::Moments moments;
+    moments.update(values);
+    ASSERT_EQ(moments.get_n(), values.size() - 1);
+    ASSERT_NEAR(moments.get_mean(), (double)expected_mean, 1e-9);
+    ASSERT_NEAR(moments.get_variance(), (double)(sum_squares / (values.size() - 1)), 1e-9);
+    ASSERT_EQ(moments.get_min(), 10000);
+    ASSERT_EQ(moments.get_max(), 10002);
+
+    ::Moments merged, single;
+    for (unsigned start = 0; start < values.size(); start += 999) {
+        ::Moments chunk;
+        chunk.update(values.data() + start, std::min((size_t)999, values.size() - start));
+        merged.merge(chunk);
+    }
+    for (float value : values) single.update(value);
+    for (const ::Moments& other : {merged, single}) {
+        ASSERT_EQ(other.get_n(), moments.get_n());
+        ASSERT_NEAR(other.get_mean(), moments.get_mean(), 1e-9);
+        ASSERT_NEAR(other.get_variance(), moments.get_variance(), 1e-9);
+        ASSERT_EQ(other.get_min(), moments.get_min());
+        ASSERT_EQ(other.get_max(), moments.get_max());
+    }
+
+    std::vector<float> missing({NAN, 1.0, NAN, 3.0});
+    ASSERT_DOUBLE_EQ(::MathUtils::mean(missing), 2);
+    ASSERT_DOUBLE_EQ(::MathUtils::variance(missing), 1);
+    missing = std::vector<float>({NAN, NAN});
+    ASSERT_TRUE(std::isnan(::MathUtils::mean(missing)));
+    ASSERT_TRUE(std::isnan(::MathUtils::sd(missing)));
+    ASSERT_TRUE(std::isnan(::Moments().get_min()));
+}
+
 // Test to check the Mean (float)
 TEST_F(TestMathUtils, CheckFloatMean) {
     ASSERT_FLOAT_EQ(::MathUtils::mean(v), 0);
@@ -165,6 +314,39 @@ TEST_F(TestMathUtils, CheckDoubleMedian) {
     ASSERT_DOUBLE_EQ(::MathUtils::median(e), -2);
 }
 
+// Test that the quantiles match the sorted values and do not modify the input
+TEST_F(TestMathUtils, CheckQuantiles) {
+    std::vector<float> values(1001);
+    for (unsigned ts = 0; ts < values.size(); ts++) values[ts] = (ts == 17 || ts == 500) ? NAN : sin(1.7 * ts) + 0.001 * ts;
+    const std::vector<float> original = values;
+    std::vector<float> sorted;
+    for (float value : values)
+        if (!std::isnan(value)) sorted.push_back(value);
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<double> probabilities({0.99, 0, 0.5, 0.25, 1, 0.25});
+    for (unsigned i = 1; i < 100; i++) probabilities.push_back(i / 100.0);
+
+    std::vector<float> v_scratch;
+    std::vector<double> v_quantiles;
+    ::MathUtils::quantiles(values.data(), values.size(), probabilities, v_quantiles, v_scratch);
+    ASSERT_EQ(v_quantiles.size(), probabilities.size());
+    for (unsigned i = 0; i < probabilities.size(); i++) {
+        const size_t index = std::min((size_t)(probabilities[i] * sorted.size()), sorted.size() - 1);
+        ASSERT_EQ(v_quantiles[i], sorted[index]);
+        ASSERT_EQ(::MathUtils::quantile(values.data(), values.size(), probabilities[i], v_scratch), sorted[index]);
+    }
+    ASSERT_EQ(::MathUtils::median(values), sorted[sorted.size() / 2]);
+    for (unsigned ts = 0; ts < values.size(); ts++)
+        ASSERT_TRUE(values[ts] == original[ts] || (std::isnan(values[ts]) && std::isnan(original[ts])));
+
+    std::vector<float> missing({NAN, NAN});
+    ASSERT_TRUE(std::isnan(::MathUtils::median(missing)));
+    ::MathUtils::quantiles(missing.data(), missing.size(), probabilities, v_quantiles, v_scratch);
+    ASSERT_TRUE(std::isnan(v_quantiles[0]));
+    ASSERT_THROW(::MathUtils::quantile(values.data(), values.size(), 1.5, v_scratch), std::runtime_error);
+}
+
 // Test to get the probability density function
 TEST_F(TestMathUtils, CheckProbabilityDensityFunction) {
     std::vector<double>
@@ -192,6 +374,25 @@ TEST_F(TestMathUtils, CheckCumulativeDistributionFunction) {
     for (unsigned i = 0; i < bins1.size() - 1; i++)
         ASSERT_EQ(cdf[i], target[i]);
 }
+
+// Test the CDF for values on and beyond the boundaries of uneven bins
+TEST_F(TestMathUtils, CheckCumulativeDistributionFunctionEdges) {
+    std::vector<double> bins({-10, -5, -2.5, 0, 2.5, 5, 10});
+    std::vector<float> values({-20, -10, -5, -4, -2.5, 0, 1, 2.5, 5, 7, 10, 20, NAN});
+    std::vector<int> target({0, 2, 4, 5, 7, 8, 12});
+
+    std::vector<int> cdf = ::MathUtils::get_cdf(values, bins);
+    std::vector<double> cdf_buffer(3, -1);  // is resized and overwritten
+    ::MathUtils::get_cdf(values, bins, cdf_buffer);
+    ASSERT_EQ(cdf.size(), bins.size());
+    ASSERT_EQ(cdf_buffer.size(), bins.size());
+
+    for (unsigned i = 0; i < bins.size(); i++) {
+        ASSERT_EQ(cdf[i], target[i]);
+        ASSERT_EQ(cdf_buffer[i], target[i]);
+    }
+}
+
 // Test the linear inpterpolation
 TEST_F(TestMathUtils, CheckLinearInterpolation) {
     std::vector<double> targets({2, -1.5, -3, 12, 3, -9});
@@ -214,6 +415,69 @@ TEST_F(TestMathUtils, CheckLinearInterpolation2d) {
     }
 }
 
+// Test that the interpolator objects match the linear search of `interpolate`
+TEST_F(TestMathUtils, CheckInterpolators) {
+    std::vector<double> xbins(1, -2.5), cdf(1, 0);
+    while (xbins[xbins.size() - 1] < 7.3) {  // same accumulation as `get_xbins`
+        xbins.push_back(xbins[xbins.size() - 1] + 0.37);
+        cdf.push_back(cdf[cdf.size() - 1] + (xbins.size() % 3 == 0 ? 0 : 2));  // with repeated values
+    }
+
+    std::vector<double> x({-10, -2.5, -2.4, 0, 1.2, 3.33, 6.9, 7.3, 8, 20, NAN});
+    for (unsigned i = 0; i < xbins.size(); i++) x.push_back(xbins[i]);
+    for (unsigned i = 0; i < cdf.size(); i++) x.push_back(cdf[i]);
+
+    for (bool extrapolate : {false, true}) {
+        const UniformInterpolator cdf_at(xbins, cdf, extrapolate);
+        const SortedInterpolator inverse_cdf_at(cdf, xbins, extrapolate);
+        for (unsigned i = 0; i < x.size(); i++) {
+            const double
+                expected_cdf = ::MathUtils::interpolate(xbins, cdf, x[i], extrapolate),
+                expected_inverse_cdf = ::MathUtils::interpolate(cdf, xbins, x[i], extrapolate);
+            if (std::isnan(x[i])) {
+                ASSERT_TRUE(std::isnan(cdf_at(x[i])));
+                ASSERT_TRUE(std::isnan(inverse_cdf_at(x[i])));
+            } else {
+                ASSERT_EQ(expected_cdf, cdf_at(x[i]));
+                ASSERT_EQ(expected_inverse_cdf, inverse_cdf_at(x[i]));
+            }
+        }
+    }
+}
+
+// Test that the batched interpolation matches `interpolate` for sorted and unsorted values
+TEST_F(TestMathUtils, CheckBatchedInterpolation) {
+    std::vector<double> xbins(1, -2.5), cdf(1, 0);
+    while (xbins[xbins.size() - 1] < 7.3) {
+        xbins.push_back(xbins[xbins.size() - 1] + 0.37);
+        cdf.push_back(cdf[cdf.size() - 1] + (xbins.size() % 3 == 0 ? 0 : 2));  // with repeated values
+    }
+
+    std::vector<double> sorted;
+    for (double x = -4; x < 9; x += 0.013) sorted.push_back(x);
+    for (unsigned i = 0; i < xbins.size(); i++) sorted.push_back(xbins[i]);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<double> unsorted = sorted;
+    std::reverse(unsorted.begin(), unsorted.end());
+    unsorted.push_back(NAN);
+
+    for (bool extrapolate : {false, true}) {
+        for (std::vector<double>* x : {&sorted, &unsorted}) {
+            std::vector<double> y(x->size()), in_place = *x;
+            ::MathUtils::interpolate(xbins, cdf, x->data(), x->size(), y.data(), extrapolate);
+            ::MathUtils::interpolate(xbins, cdf, in_place.data(), in_place.size(), in_place.data(), extrapolate);
+            for (unsigned i = 0; i < x->size(); i++) {
+                if (std::isnan((*x)[i])) {
+                    ASSERT_TRUE(std::isnan(y[i]));
+                    continue;
+                }
+                ASSERT_EQ(y[i], ::MathUtils::interpolate(xbins, cdf, (*x)[i], extrapolate));
+                ASSERT_EQ(in_place[i], y[i]);
+            }
+        }
+    }
+}
+
 TEST_F(TestMathUtils, CheckEnsureDevidable) {
     ASSERT_EQ(::MathUtils::ensure_devidable((double)5, (double)5, 10), 1);
     ASSERT_EQ(::MathUtils::ensure_devidable((double)0, (double)5, 10), 0);
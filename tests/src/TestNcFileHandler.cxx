@@ -23,6 +23,15 @@
  */
 
 #include "NcFileHandler.hxx"
+
+#include <netcdf.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace TestBiasAdjustCXX {
@@ -39,12 +48,170 @@ class TestNcFileHandler : public ::testing::Test {
     }
 
     void SetUp() override {
+        ::NcFileHandler::station_name = "station";
+        values.resize(n_time * n_stations);
+        for (size_t ts = 0; ts < n_time; ts++)
+            for (size_t station = 0; station < n_stations; station++)
+                values[ts * n_stations + station] = (float)(280 + 10 * sin(2 * M_PI * ts / 365) + station + sin(1.7 * ts + station));
+        write_station_file(input_path);
     }
 
     void TearDown() override {
+        std::remove(input_path.c_str());
+        std::remove(output_path.c_str());
+    }
+
+    // writes a 2-dimensional data set (time x station) with the coordinates,
+    // numeric IDs and names of the stations as string resp. char variables
+    void write_station_file(const std::string& path) {
+        netCDF::NcFile file(path, netCDF::NcFile::replace);
+        netCDF::NcDim
+            time_dim = file.addDim("time", n_time),
+            station_dim = file.addDim("station", n_stations),
+            strlen_dim = file.addDim("name_strlen", name_strlen);
+
+        netCDF::NcVar time_var = file.addVar("time", netCDF::ncDouble, time_dim);
+        time_var.putAtt("units", "days since 2000-01-01 00:00:00");
+        time_var.putAtt("calendar", "noleap");
+        std::vector<double> time_values(n_time);
+        for (size_t ts = 0; ts < n_time; ts++) time_values[ts] = (double)ts;
+        time_var.putVar(time_values.data());
+
+        netCDF::NcVar lat_var = file.addVar("lat", netCDF::ncFloat, station_dim);
+        lat_var.putAtt("units", "degrees_north");
+        lat_var.putAtt("standard_name", "latitude");
+        lat_var.putVar(lat_values.data());
+
+        netCDF::NcVar lon_var = file.addVar("lon", netCDF::ncDouble, station_dim);
+        lon_var.putAtt("units", "degrees_east");
+        lon_var.putAtt("valid_range", netCDF::ncDouble, valid_range.size(), valid_range.data());
+        lon_var.putVar(lon_values.data());
+
+        netCDF::NcVar id_var = file.addVar("station_id", netCDF::ncString, station_dim);
+        id_var.putAtt("cf_role", "timeseries_id");
+        id_var.putVar(station_ids.data());
+
+        std::vector<char> names(n_stations * name_strlen, '\0');
+        for (size_t station = 0; station < n_stations; station++)
+            std::copy(station_names[station].begin(), station_names[station].end(), names.begin() + station * name_strlen);
+        netCDF::NcVar name_var = file.addVar("station_name", netCDF::ncChar, std::vector<netCDF::NcDim>{station_dim, strlen_dim});
+        name_var.putAtt("long_name", "name of the station");
+        name_var.putVar(names.data());
+
+        netCDF::NcVar data_var = file.addVar("tas", netCDF::ncFloat, std::vector<netCDF::NcDim>{time_dim, station_dim});
+        data_var.putAtt("units", "K");
+        data_var.putVar(values.data());
     }
+
+    // returns the attribute `name` of the variable `variable`
+    static std::string get_attribute(const netCDF::NcVar& variable, const std::string& name) {
+        std::string value;
+        variable.getAtt(name).getValues(value);
+        return value;
+    }
+
+    const size_t
+        n_time = 730,
+        n_stations = 5,
+        name_strlen = 8;
+    const std::string
+        input_path = "TestNcFileHandler_stations.nc",
+        output_path = "TestNcFileHandler_stations_out.nc";
+    const std::vector<float> lat_values = {52.1f, 53.5f, 48.2f, 50.9f, 54.3f};
+    const std::vector<double> lon_values = {13.4, 10.0, 11.6, 6.9, 10.1};
+    const std::vector<double> valid_range = {-180.0, 180.0};
+    const std::vector<const char*> station_ids = {"10382", "10147", "10870", "10513", "10046"};
+    const std::vector<std::string> station_names = {"Berlin", "Hamburg", "Munich", "Cologne", "Kiel"};
+    std::vector<float> values;  // [time][station]
 };
 
+// Test that the stations are read in blocks and chunks of time steps
+TEST_F(TestNcFileHandler, CheckStationSlab) {
+    ::NcFileHandler ds(input_path, "tas", 2);
+    ASSERT_EQ(ds.n_time, n_time);
+    ASSERT_EQ(ds.n_stations, n_stations);
+
+    // the coordinates and IDs are found, but not the data variable or the time
+    const std::vector<std::string> expected_variables = {"lat", "lon", "station_id", "station_name"};
+    EXPECT_EQ(ds.station_variables, expected_variables);
+
+    const size_t first = 1, count = 3;
+    std::vector<float> slab;
+    ds.get_station_slab(slab, first, count);
+    ASSERT_EQ(slab.size(), n_time * count);
+    for (size_t ts = 0; ts < n_time; ts++)
+        for (size_t station = 0; station < count; station++)
+            ASSERT_EQ(slab[ts * count + station], values[ts * n_stations + first + station]);
+
+    // chunks of time steps, the last one is shorter
+    const size_t n_chunk = 300;
+    std::vector<float> chunk;
+    for (size_t first_time = 0; first_time < n_time; first_time += n_chunk) {
+        const size_t count_time = std::min(n_chunk, n_time - first_time);
+        ds.get_station_slab(chunk, first, count, first_time, count_time);
+        ASSERT_EQ(chunk.size(), count_time * count);
+        for (size_t ts = 0; ts < count_time; ts++)
+            for (size_t station = 0; station < count; station++)
+                ASSERT_EQ(chunk[ts * count + station], slab[(first_time + ts) * count + station]);
+    }
+}
+
+// Test that the coordinates and IDs of the stations are carried through to the output file unchanged
+TEST_F(TestNcFileHandler, CheckStationVariables) {
+    std::vector<float> v_out(n_time * n_stations);
+    for (size_t i = 0; i < v_out.size(); i++) v_out[i] = values[i] + 1;
+    {
+        ::NcFileHandler ds(input_path, "tas", 2);
+        ds.to_netcdf(output_path, "tas", v_out);
+    }
+
+    netCDF::NcFile file(output_path, netCDF::NcFile::read);
+    EXPECT_EQ(file.getDim("station").getSize(), n_stations);
+    EXPECT_EQ(file.getDim("name_strlen").getSize(), name_strlen);
+
+    const netCDF::NcVar time_var = file.getVar("time");
+    EXPECT_EQ(get_attribute(time_var, "units"), "days since 2000-01-01 00:00:00");
+    EXPECT_EQ(get_attribute(time_var, "calendar"), "noleap");
+
+    const netCDF::NcVar lat_var = file.getVar("lat");
+    EXPECT_EQ(lat_var.getType(), netCDF::ncFloat);
+    EXPECT_EQ(get_attribute(lat_var, "units"), "degrees_north");
+    EXPECT_EQ(get_attribute(lat_var, "standard_name"), "latitude");
+    std::vector<float> lat(n_stations);
+    lat_var.getVar(lat.data());
+    EXPECT_EQ(lat, lat_values);
+
+    const netCDF::NcVar lon_var = file.getVar("lon");
+    EXPECT_EQ(lon_var.getType(), netCDF::ncDouble);
+    EXPECT_EQ(get_attribute(lon_var, "units"), "degrees_east");
+    std::vector<double> lon(n_stations), range(valid_range.size());
+    lon_var.getVar(lon.data());
+    lon_var.getAtt("valid_range").getValues(range.data());
+    EXPECT_EQ(lon, lon_values);
+    EXPECT_EQ(range, valid_range);
+
+    const netCDF::NcVar id_var = file.getVar("station_id");
+    EXPECT_EQ(id_var.getType(), netCDF::ncString);
+    EXPECT_EQ(get_attribute(id_var, "cf_role"), "timeseries_id");
+    std::vector<char*> ids(n_stations);
+    id_var.getVar(ids.data());
+    for (size_t station = 0; station < n_stations; station++)
+        EXPECT_EQ(std::string(ids[station]), station_ids[station]);
+    nc_free_string(n_stations, ids.data());
+
+    const netCDF::NcVar name_var = file.getVar("station_name");
+    EXPECT_EQ(name_var.getType(), netCDF::ncChar);
+    EXPECT_EQ(get_attribute(name_var, "long_name"), "name of the station");
+    std::vector<char> names(n_stations * name_strlen);
+    name_var.getVar(names.data());
+    for (size_t station = 0; station < n_stations; station++)
+        EXPECT_EQ(std::string(names.data() + station * name_strlen), station_names[station]);
+
+    std::vector<float> data(n_time * n_stations);
+    file.getVar("tas").getVar(data.data());
+    EXPECT_EQ(data, v_out);
+}
+
 }  // namespace
 }  // namespace NcFileHandler
 }  // namespace TestBiasAdjustCXX
@@ -0,0 +1,143 @@
+// -*- lsst-c++ -*-
+/**
+ * @file TestQuantileSketch.cxx
+ * @brief Implements the unit tests of the QuantileSketch class
+ * @author Benjamin Thomas Schwertfeger
+ * @email: contact@b-schwertfeger.de
+ * @link https://github.com/btschwertfeger/BiasAdjustCXX
+ *
+ *  * Copyright (C) 2023 Benjamin Thomas Schwertfeger
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "QuantileSketch.hxx"
+#include "gtest/gtest.h"
+
+namespace TestBiasAdjustCXX {
+namespace QuantileSketch {
+namespace {
+
+// The fixture for testing class QuantileSketch.
+class TestQuantileSketch : public ::testing::Test {
+   protected:
+    TestQuantileSketch() {
+    }
+
+    ~TestQuantileSketch() override {
+    }
+
+    void SetUp() override {
+        // 30 years of a noisy seasonal cycle, not sorted in any way
+        values = std::vector<float>(10950);
+        for (unsigned ts = 0; ts < values.size(); ts++)
+            values[ts] = 10 * sin(2 * M_PI * ts / 365.25) + 5 * sin(1.7 * ts) + 0.0001 * ts;
+        sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+    }
+
+    void TearDown() override {
+    }
+
+    /**
+     * Returns the exact number of values that are smaller than `value`
+     */
+    double get_exact_rank(double value) {
+        return (double)(std::lower_bound(sorted.begin(), sorted.end(), value, [](float x, double v) { return x < v; }) - sorted.begin());
+    }
+
+    std::vector<float> values, sorted;
+};
+
+// Test the relation of the size parameter and the rank error
+TEST_F(TestQuantileSketch, CheckErrorBound) {
+    for (double error : {0.1, 0.01, 0.001}) {
+        const unsigned k = ::QuantileSketch::get_k(error);
+        ASSERT_LE(::QuantileSketch::get_error(k), error);
+        ASSERT_GT(::QuantileSketch::get_error(k - 1), error);
+    }
+    ASSERT_THROW(::QuantileSketch::get_k(0), std::runtime_error);
+    ASSERT_THROW(::QuantileSketch::get_k(1), std::runtime_error);
+}
+
+// Test that the ranks are exact as long as no values were compacted
+TEST_F(TestQuantileSketch, CheckExactRanks) {
+    ::QuantileSketch sketch(20000);
+    sketch.update(values);
+    ASSERT_EQ(sketch.get_n(), values.size());
+    ASSERT_EQ(sketch.get_n_retained(), values.size());
+    for (unsigned i = 0; i < sorted.size(); i += 97)
+        ASSERT_EQ(sketch.get_rank(sorted[i]), get_exact_rank(sorted[i]));
+    ASSERT_EQ(sketch.get_quantile(0.5), sorted[sorted.size() / 2]);
+}
+
+// Test that the memory is bounded and the ranks respect the error bound
+TEST_F(TestQuantileSketch, CheckApproximateRanks) {
+    const unsigned k = 100;
+    const double max_error = ::QuantileSketch::get_error(k) * values.size();
+    ::QuantileSketch sketch(k);
+    sketch.update(values);
+
+    ASSERT_EQ(sketch.get_n(), values.size());
+    ASSERT_LE(sketch.get_n_retained(), 4 * k);
+    ASSERT_EQ(sketch.get_min(), sorted[0]);
+    ASSERT_EQ(sketch.get_max(), sorted[sorted.size() - 1]);
+    for (unsigned i = 0; i < sorted.size(); i += 97)
+        ASSERT_NEAR(sketch.get_rank(sorted[i]), get_exact_rank(sorted[i]), max_error);
+    for (double p : {0.01, 0.25, 0.5, 0.75, 0.99}) {
+        const double rank = get_exact_rank(sketch.get_quantile(p));
+        ASSERT_NEAR(rank, p * values.size(), max_error);
+    }
+}
+
+// Test that sketches of chunks can be merged into the sketch of the whole time series
+TEST_F(TestQuantileSketch, CheckMerge) {
+    const unsigned k = 100;
+    const double max_error = ::QuantileSketch::get_error(k) * values.size();
+    ::QuantileSketch sketch(k);
+    for (unsigned start = 0; start < values.size(); start += 1000) {
+        ::QuantileSketch chunk(k);
+        for (unsigned ts = start; ts < std::min(start + 1000, (unsigned)values.size()); ts++)
+            chunk.update(values[ts]);
+        sketch.merge(chunk);
+    }
+
+    ASSERT_EQ(sketch.get_n(), values.size());
+    ASSERT_LE(sketch.get_n_retained(), 4 * k);
+    ASSERT_EQ(sketch.get_min(), sorted[0]);
+    ASSERT_EQ(sketch.get_max(), sorted[sorted.size() - 1]);
+    for (unsigned i = 0; i < sorted.size(); i += 97)
+        ASSERT_NEAR(sketch.get_rank(sorted[i]), get_exact_rank(sorted[i]), max_error);
+}
+
+// Test that nan values are ignored and empty sketches have no quantiles
+TEST_F(TestQuantileSketch, CheckNaN) {
+    ::QuantileSketch sketch;
+    ASSERT_TRUE(sketch.empty());
+    ASSERT_TRUE(std::isnan(sketch.get_quantile(0.5)));
+
+    sketch.update(std::vector<float>({NAN, 3, NAN, 1, 2}));
+    ASSERT_EQ(sketch.get_n(), 3);
+    ASSERT_EQ(sketch.get_min(), 1);
+    ASSERT_EQ(sketch.get_max(), 3);
+    ASSERT_EQ(sketch.get_rank(2.5), 2);
+    ASSERT_EQ(sketch.get_rank(4), 3);
+}
+}  // namespace
+}  // namespace QuantileSketch
+}  // namespace TestBiasAdjustCXX
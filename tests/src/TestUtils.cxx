@@ -149,6 +149,61 @@ TEST_F(TestUtils, CheckCopyrightNotice) {
     EXPECT_EQ(expected, actual);
 }
 
+// Tests the decoding of the day of the year and the month of CF time axes
+TEST_F(TestUtils, CheckDayOfYear) {
+    std::vector<double> v_time(2 * 366);
+    for (unsigned ts = 0; ts < v_time.size(); ts++) v_time[ts] = ts;
+
+    // ? 2000 is a leap year, 29th February shares the day of 28th February
+    std::vector<unsigned> v_dayofyear = utils::get_dayofyear(v_time.data(), v_time.size(), "days since 2000-01-01 00:00:00", "gregorian");
+    EXPECT_EQ(v_dayofyear[58], 58);
+    EXPECT_EQ(v_dayofyear[59], 58);
+    EXPECT_EQ(v_dayofyear[60], 59);
+    EXPECT_EQ(v_dayofyear[365], 364);
+    EXPECT_EQ(v_dayofyear[366], 0);
+    EXPECT_EQ(v_dayofyear[366 + 59], 59);
+
+    v_dayofyear = utils::get_dayofyear(v_time.data(), v_time.size(), "days since 2000-01-01", "noleap");
+    EXPECT_EQ(v_dayofyear[59], 59);
+    EXPECT_EQ(v_dayofyear[365], 0);
+
+    // ? 360 days spread over 365 days
+    v_dayofyear = utils::get_dayofyear(v_time.data(), v_time.size(), "days since 1950-01-01", "360_day");
+    EXPECT_EQ(v_dayofyear[0], 0);
+    EXPECT_EQ(v_dayofyear[359], 363);
+    EXPECT_EQ(v_dayofyear[360], 0);
+
+    // ? hours and a reference date in the middle of the year
+    for (unsigned ts = 0; ts < v_time.size(); ts++) v_time[ts] = 24 * ts + 12;
+    v_dayofyear = utils::get_dayofyear(v_time.data(), v_time.size(), "hours since 2001-03-01T00:00:00Z", "proleptic_gregorian");
+    EXPECT_EQ(v_dayofyear[0], 59);
+    EXPECT_EQ(v_dayofyear[306], 0);
+
+    // ? months of a leap year and of the 360-day calendar
+    for (unsigned ts = 0; ts < v_time.size(); ts++) v_time[ts] = ts;
+    std::vector<unsigned> v_month = utils::get_month(v_time.data(), v_time.size(), "days since 2000-01-01", "standard");
+    EXPECT_EQ(v_month[30], 0);
+    EXPECT_EQ(v_month[59], 1);
+    EXPECT_EQ(v_month[60], 2);
+    EXPECT_EQ(v_month[365], 11);
+    v_month = utils::get_month(v_time.data(), v_time.size(), "days since 2000-01-01", "360_day");
+    EXPECT_EQ(v_month[59], 1);
+    EXPECT_EQ(v_month[60], 2);
+    EXPECT_EQ(v_month[360], 0);
+
+    // ? years of the standard and the 360-day calendar
+    std::vector<int> v_year = utils::get_year(v_time.data(), v_time.size(), "days since 2000-01-01", "standard");
+    EXPECT_EQ(v_year[365], 2000);
+    EXPECT_EQ(v_year[366], 2001);
+    v_year = utils::get_year(v_time.data(), v_time.size(), "days since 1999-12-01", "360_day");
+    EXPECT_EQ(v_year[29], 1999);
+    EXPECT_EQ(v_year[30], 2000);
+    EXPECT_EQ(v_year[390], 2001);
+
+    EXPECT_THROW(utils::get_dayofyear(v_time.data(), v_time.size(), "hours since 2001-03-01", "lunar"), std::runtime_error);
+    EXPECT_THROW(utils::get_dayofyear(v_time.data(), v_time.size(), "fortnights since 2001-03-01", "noleap"), std::runtime_error);
+}
+
 }  // namespace
 }  // namespace Utils
 }  // namespace TestBiasAdjustCXX
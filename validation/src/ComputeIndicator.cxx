@@ -29,6 +29,11 @@
 #include <math.h>
 
 #include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <future>
+#include <utility>
 #include <vector>
 
 #include "MathUtils.hxx"
@@ -41,11 +46,23 @@
  */
 
 static std::vector<NcFileHandler*> v_NcFileHandlers;
-static std::vector<std::string> v_input_filepaths;
+static std::vector<std::string>
+    v_input_filepaths,
+    v_method_names;
 static std::string
-    method_name = "",
     variable_name = "",
-    output_filepath = "";
+    output_filepath = "",
+    grouping = "";
+static unsigned n_jobs = 1;
+
+// groups of time steps (see `set_time_groups`), one group if no grouping is used
+static std::vector<int>
+    v_time_groups,
+    v_group_values;
+static unsigned n_groups = 1;
+static std::string
+    group_name = "",
+    group_description = "";
 
 static utils::Log Log = utils::Log();
 
@@ -70,16 +87,18 @@ static void show_usage(std::string name) {
               << GREEN << " -i" << RESET << " inputfile2.nc"
               << GREEN << " -o " << RESET << "outputfile.nc"
               << GREEN << " -v " << RESET << "temperature"
-              << GREEN << " -m " << RESET << "rmse\n"
+              << GREEN << " -m " << RESET << "rmse,mbe,corr\n"
               << BOLDBLUE << "Parameters:\n"
               << RESET
               << "    required:\n"
               << GREEN << "\t-i, --input, \t\t" << RESET << "Inputfile / Filepath\n"
               << GREEN << "\t-o, --output\t\t" << RESET << "Outputfile / Filepath\n"
               << GREEN << "\t-v, --variable\t\t" << RESET << "Variablename (e.g.: tas, tsurf, pr) \n"
+              << GREEN << "\t-m, --method\t\t" << RESET << "Indicator(s) separated by commas, every indicator is saved as a variable of the output file\n"
               << "    optional:\n"
-              << RESET
-              << "\tNone\n"
+              << GREEN << "\t-p, --processes\t\t" << RESET << "number of threads that compute the grid cells while the next longitude is read (default: 1)\n"
+              << GREEN << "\t-g, --group\t\t" << RESET << "compute the indicators per group of time steps: 'year', 'decade', 'month', 'season' or\n"
+              << "\t\t\t\tnon-overlapping windows of years (e.g. '1981-2010,2011-2040'); output: [group][lat][lon]\n"
               << BOLDBLUE << "Requirements: \n"
               << RESET << "\t-> Data must 3-dimensional an dimensions in the following order: [time][lat][lon] and values type int or float\n"
               << "\t-> Latitudes and longitudes must be named 'lat' and 'lon', Time == 'time'\n"
@@ -98,6 +117,132 @@ static void show_usage(std::string name) {
     std::cout << std::endl;
 }
 
+/**
+ * Adds the methods of a comma-separated list (e.g. "rmse,mbe,corr")
+ *
+ * @param names list of method names
+ */
+static void add_method_names(const std::string& names) {
+    size_t start = 0;
+    while (start <= names.size()) {
+        size_t end = names.find(',', start);
+        if (end == std::string::npos) end = names.size();
+        const std::string name = names.substr(start, end - start);
+        if (name.empty())
+            throw std::runtime_error("Empty method name in " + names + "!");
+        if (isInStrV(v_method_names, name))
+            throw std::runtime_error("Method " + name + " is specified more than once!");
+        v_method_names.push_back(name);
+        start = end + 1;
+    }
+}
+
+/**
+ * Assigns the time steps to groups of consecutive values of `v_keys`, e.g.
+ * years, sorted by their value
+ *
+ * @param v_keys key of every time step
+ */
+static void set_groups_by_key(const std::vector<int>& v_keys) {
+    v_group_values = v_keys;
+    std::sort(v_group_values.begin(), v_group_values.end());
+    v_group_values.erase(std::unique(v_group_values.begin(), v_group_values.end()), v_group_values.end());
+    n_groups = (unsigned)v_group_values.size();
+
+    v_time_groups.resize(v_keys.size());
+    for (size_t ts = 0; ts < v_keys.size(); ts++)
+        v_time_groups[ts] = (int)(std::lower_bound(v_group_values.begin(), v_group_values.end(), v_keys[ts]) - v_group_values.begin());
+}
+
+/**
+ * Assigns the time steps to windows of years like "1981-2010,2011-2040".
+ * The windows must not overlap, so that every time step belongs to at most
+ * one group, time steps outside of all windows are skipped.
+ *
+ * @param windows comma-separated list of windows
+ * @param v_year year of every time step
+ */
+static void set_groups_by_windows(const std::string& windows, const std::vector<int>& v_year) {
+    std::vector<std::pair<int, int>> v_windows;
+    size_t start = 0;
+    while (start <= windows.size()) {
+        size_t end = windows.find(',', start);
+        if (end == std::string::npos) end = windows.size();
+        const std::string window = windows.substr(start, end - start);
+        int first, last, n_chars = 0;
+        if (std::sscanf(window.c_str(), "%d-%d%n", &first, &last, &n_chars) != 2 || n_chars != (int)window.size() || first > last)
+            throw std::runtime_error("Invalid window of years '" + window + "', expected for example '1981-2010'!");
+        v_windows.push_back(std::make_pair(first, last));
+        start = end + 1;
+    }
+    std::sort(v_windows.begin(), v_windows.end());
+    for (size_t i = 1; i < v_windows.size(); i++)
+        if (v_windows[i].first <= v_windows[i - 1].second)
+            throw std::runtime_error("The windows of years must not overlap!");
+
+    n_groups = (unsigned)v_windows.size();
+    group_description = "windows of years:";
+    v_group_values.clear();
+    for (const std::pair<int, int>& window : v_windows) {
+        v_group_values.push_back(window.first);
+        group_description += " " + std::to_string(window.first) + "-" + std::to_string(window.second);
+    }
+
+    v_time_groups.assign(v_year.size(), -1);
+    for (size_t ts = 0; ts < v_year.size(); ts++) {
+        const auto window = std::upper_bound(v_windows.begin(), v_windows.end(), std::make_pair(v_year[ts], INT_MAX)) - 1;
+        if (window >= v_windows.begin() && v_year[ts] <= window->second)
+            v_time_groups[ts] = (int)(window - v_windows.begin());
+    }
+}
+
+/**
+ * Assigns every time step to a group according to `grouping`, based on the
+ * decoded time axis (`units` and `calendar` attributes) of the first file
+ */
+static void set_time_groups() {
+    NcFileHandler* ds = v_NcFileHandlers[0];
+    const std::string units = ds->get_time_attribute("units");
+    if (units.empty())
+        throw std::runtime_error("The time variable of " + ds->filepath + " has no units, which are required to group the time steps!");
+    std::string calendar = ds->get_time_attribute("calendar");
+    if (calendar.empty()) calendar = "standard";
+
+    if (grouping == "month" || grouping == "season") {
+        const std::vector<unsigned> v_month = utils::get_month(ds->time_values, ds->n_time, units, calendar);
+        v_time_groups.resize(v_month.size());
+        if (grouping == "month") {
+            for (size_t ts = 0; ts < v_month.size(); ts++) v_time_groups[ts] = (int)v_month[ts];
+            n_groups = 12;
+            v_group_values = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+            group_description = "month of the year";
+        } else {
+            for (size_t ts = 0; ts < v_month.size(); ts++) v_time_groups[ts] = (int)((v_month[ts] + 1) % 12) / 3;
+            n_groups = 4;
+            v_group_values = {0, 1, 2, 3};
+            group_description = "season: 0 = DJF, 1 = MAM, 2 = JJA, 3 = SON";
+        }
+        group_name = grouping;
+        return;
+    }
+
+    std::vector<int> v_year = utils::get_year(ds->time_values, ds->n_time, units, calendar);
+    if (grouping == "year") {
+        set_groups_by_key(v_year);
+        group_name = "year";
+        group_description = "year";
+    } else if (grouping == "decade") {
+        for (int& year : v_year) year -= ((year % 10) + 10) % 10;
+        set_groups_by_key(v_year);
+        group_name = "decade";
+        group_description = "first year of the decade";
+    } else if (!grouping.empty() && (std::isdigit(grouping[0]) || grouping[0] == '-')) {
+        set_groups_by_windows(grouping, v_year);
+        group_name = "window";
+    } else
+        throw std::runtime_error("Unknown grouping '" + grouping + "'!");
+}
+
 static void parse_args(int argc, char** argv) {
     if (argc == 1) {
         show_usage(argv[0]);
@@ -118,7 +263,7 @@ static void parse_args(int argc, char** argv) {
                 std::runtime_error(arg + " requires one argument!");
         } else if (arg == "-m" || arg == "--method") {
             if (i + 1 < argc)
-                method_name = argv[++i];
+                add_method_names(argv[++i]);
             else
                 std::runtime_error(arg + " requires one argument!");
         } else if (arg == "-o" || arg == "--output") {
@@ -126,6 +271,16 @@ static void parse_args(int argc, char** argv) {
                 output_filepath = argv[++i];
             else
                 std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "-p" || arg == "--processes") {
+            if (i + 1 < argc)
+                n_jobs = (unsigned)std::max(1, std::stoi(argv[++i]));
+            else
+                throw std::runtime_error(arg + " requires one argument!");
+        } else if (arg == "-g" || arg == "--group") {
+            if (i + 1 < argc)
+                grouping = argv[++i];
+            else
+                throw std::runtime_error(arg + " requires one argument!");
         } else if (arg == "-h" || arg == "--help") {
             show_usage(argv[0]);
             exit(0);
@@ -149,18 +304,25 @@ static void parse_args(int argc, char** argv) {
         throw std::runtime_error("No inputfile(s) defined!");
     else if (output_filepath.empty())
         throw std::runtime_error("No outputfile defined!");
-    else if (method_name.empty())
+    else if (v_method_names.empty())
         throw std::runtime_error("No method specified!");
     else {
         // ? check if inputfiles match method requirements
-        if (isInStrV(MathUtils::requires_1_ds, method_name) && v_input_filepaths.size() != 1)
-            throw std::runtime_error("Method " + method_name + " requires 1 inputfile!");
-        else if (isInStrV(MathUtils::requires_2_ds, method_name) && v_input_filepaths.size() != 2)
-            throw std::runtime_error("Method " + method_name + " requires 2 inputfiles!");
+        for (const std::string& method_name : v_method_names) {
+            if (isInStrV(MathUtils::requires_1_ds, method_name) && v_input_filepaths.size() != 1)
+                throw std::runtime_error("Method " + method_name + " requires 1 inputfile!");
+            else if (isInStrV(MathUtils::requires_2_ds, method_name) && v_input_filepaths.size() != 2)
+                throw std::runtime_error("Method " + method_name + " requires 2 inputfiles!");
+            else if (!isInStrV(MathUtils::available_methods, method_name))
+                throw std::runtime_error("Unknown method " + method_name + "!");
+        }
 
         // ? initialize the data manager
         for (auto const& e : v_input_filepaths)
             v_NcFileHandlers.push_back(new NcFileHandler(e, variable_name, 3));
+        if (v_NcFileHandlers.size() == 2 && v_NcFileHandlers[0]->n_time != v_NcFileHandlers[1]->n_time)
+            throw std::runtime_error("The input files must have the same number of time steps!");
+        if (!grouping.empty()) set_time_groups();
     }
 }
 
@@ -176,68 +338,129 @@ static void stdcout_runtime(T start_time) {
  */
 
 /**
- * ? Computes the results for a col; col = all latitudes for one longitude
+ * ? Reads all latitudes of one longitude of every input file in the layout
+ *   of the files ([time][lat])
  *
- * @param v_data_out reference to output data array
- * @param lon longitude to compute
+ * @param v_slabs output, one slab per input file
+ * @param lon longitude to read
  */
-void compute_col_for_one_file(std::vector<std::vector<float>>& data_out, unsigned lon) {
-    std::vector<std::vector<float>> dataset_lats(
-        (int)v_NcFileHandlers[0]->n_lat,
-        std::vector<float>((int)v_NcFileHandlers[0]->n_time)
-    );
-
-    v_NcFileHandlers[0]->get_lat_timeseries_for_lon(dataset_lats, lon);
-    Func_one method = MathUtils::get_method_for_1_ds(method_name);
-
-    for (unsigned lat = 0; lat < v_NcFileHandlers[0]->n_lat; lat++)
-        data_out[lat][lon] = (float)method(dataset_lats[lat]);
+static void read_slabs(std::vector<std::vector<float>>& v_slabs, unsigned lon) {
+    for (unsigned i = 0; i < v_NcFileHandlers.size(); i++)
+        v_NcFileHandlers[i]->get_lat_slab_for_lon(v_slabs[i], lon);
 }
 
 /**
- *  ? Computes the results for a column; column = all latitudes for one longitudee
+ * ? Computes the results of all methods for the latitudes [`first`, `last`)
+ *   of one longitude. The time series of these latitudes are first copied
+ *   out of the slabs, so that every grid cell is reduced from contiguous
+ *   memory, and all methods are computed at once (see `MathUtils::compute_indicators`
+ *   resp. `GroupedIndicators`).
  *
- * @param v_data_out reference to output data vector
+ * @param v_data_out reference to output data vector [method][group][lat][lon]
+ * @param v_slabs slabs of the input files (see `read_slabs`)
  * @param lon longitude to compute
+ * @param first first latitude
+ * @param last end of the latitudes
+ * @param v_buffer buffer of the calling job
+ * @param grouped_indicators accumulators of the groups of the calling job, nullptr without grouping
  */
-void compute_col_for_two_files(std::vector<std::vector<float>>& v_data_out, unsigned lon) {
-    std::vector<std::vector<float>> dataset_1_lats(
-        (int)v_NcFileHandlers[0]->n_lat,
-        std::vector<float>((int)v_NcFileHandlers[0]->n_time)
-    );
-    std::vector<std::vector<float>> dataset_2_lats(
-        (int)v_NcFileHandlers[1]->n_lat,
-        std::vector<float>((int)v_NcFileHandlers[1]->n_time)
-    );
-
-    v_NcFileHandlers[0]->get_lat_timeseries_for_lon(dataset_1_lats, lon);
-    v_NcFileHandlers[1]->get_lat_timeseries_for_lon(dataset_2_lats, lon);
-
-    Func_two method = MathUtils::get_method_for_2_ds(method_name);
-    for (unsigned lat = 0; lat < v_NcFileHandlers[0]->n_lat; lat++)
-        v_data_out[lat][lon] = (float)method(dataset_1_lats[lat], dataset_2_lats[lat]);
+static void compute_cells(
+    std::vector<std::vector<float>>& v_data_out,
+    const std::vector<std::vector<float>>& v_slabs,
+    unsigned lon,
+    size_t first,
+    size_t last,
+    std::vector<float>& v_buffer,
+    GroupedIndicators* grouped_indicators
+) {
+    const size_t
+        n_lon = v_NcFileHandlers[0]->n_lon,
+        n_lat = v_NcFileHandlers[0]->n_lat,
+        n_time = v_NcFileHandlers[0]->n_time,
+        n_cells = last - first,
+        n_files = v_slabs.size();
+
+    // ? [file][lat][time] for the latitudes of this job
+    v_buffer.resize(n_files * n_cells * n_time);
+    for (size_t i = 0; i < n_files; i++) {
+        float* buffer = v_buffer.data() + i * n_cells * n_time;
+        for (size_t ts = 0; ts < n_time; ts++)
+            for (size_t lat = first; lat < last; lat++)
+                buffer[(lat - first) * n_time + ts] = v_slabs[i][ts * n_lat + lat];
+    }
+
+    const size_t n_methods = v_method_names.size();
+    std::vector<double> v_results(n_groups * n_methods);
+    for (size_t lat = first; lat < last; lat++) {
+        const float
+            *x = v_buffer.data() + (lat - first) * n_time,
+            *y = (n_files == 2) ? x + n_cells * n_time : nullptr;
+        if (grouped_indicators == nullptr)
+            MathUtils::compute_indicators(v_method_names, x, y, n_time, v_results.data());
+        else
+            grouped_indicators->compute(x, y, v_results.data());
+
+        for (size_t group = 0; group < n_groups; group++)
+            for (size_t i = 0; i < n_methods; i++)
+                v_data_out[i][(group * n_lat + lat) * n_lon + lon] = (float)v_results[group * n_methods + i];
+    }
 }
 
 /**
- * ? Computes the selected indicator for all latitudes / longitudes
+ * ? Computes the selected indicators for all latitudes / longitudes
+ * -> The latitudes of one longitude are split into `n_jobs` blocks that
+ *    are computed in parallel.
+ * -> The slabs of the next longitude are read while the current one is
+ *    computed. The netCDF library is not thread-safe, so all files are read
+ *    by this single task one after another and never at the same time.
+ * -> With a grouping, every job owns the accumulators of all groups.
  *
- * @param v_data_out output array
+ * @param v_data_out output array [method][group][lat][lon]
  */
 void compute_indicator(std::vector<std::vector<float>>& v_data_out) {
-    if (isInStrV(MathUtils::requires_1_ds, method_name)) {
-        // * One dataset as input
-        for (unsigned lon = 0; lon < v_NcFileHandlers[0]->n_lon; lon++) {
-            compute_col_for_one_file(v_data_out, lon);
-            utils::progress_bar((float)lon, (float)v_NcFileHandlers[0]->n_lon);
-        }
-    } else if (isInStrV(MathUtils::requires_2_ds, method_name)) {
-        // * Two datasets as input
-        for (unsigned lon = 0; lon < v_NcFileHandlers[0]->n_lon; lon++) {
-            compute_col_for_two_files(v_data_out, lon);
-            utils::progress_bar((float)lon, (float)v_NcFileHandlers[0]->n_lon);
-        }
+    const size_t
+        n_lon = v_NcFileHandlers[0]->n_lon,
+        n_lat = v_NcFileHandlers[0]->n_lat,
+        n_lat_per_job = (n_lat + n_jobs - 1) / n_jobs,
+        n_tasks = (n_lat + n_lat_per_job - 1) / n_lat_per_job;
+
+    std::vector<std::vector<float>>
+        v_current(v_NcFileHandlers.size()),
+        v_next(v_NcFileHandlers.size()),
+        v_buffers(n_tasks);
+    std::vector<std::future<void>> tasks;
+
+    std::vector<GroupedIndicators> v_grouped_indicators;
+    if (!grouping.empty())
+        for (size_t job = 0; job < n_tasks; job++)
+            v_grouped_indicators.emplace_back(v_method_names, v_time_groups, n_groups);
+
+    if (n_lon > 0) read_slabs(v_current, 0);
+    for (unsigned lon = 0; lon < n_lon; lon++) {
+        std::future<void> reading;
+        if (lon + 1 < n_lon)
+            reading = std::async(std::launch::async, read_slabs, std::ref(v_next), lon + 1);
+
+        for (size_t first = 0, job = 0; first < n_lat; first += n_lat_per_job, job++)
+            tasks.push_back(std::async(
+                std::launch::async,
+                compute_cells,
+                std::ref(v_data_out),
+                std::cref(v_current),
+                lon,
+                first,
+                std::min(first + n_lat_per_job, n_lat),
+                std::ref(v_buffers[job]),
+                v_grouped_indicators.empty() ? nullptr : &v_grouped_indicators[job]
+            ));
+        for (auto& e : tasks) e.get();
+        tasks.clear();
+
+        if (reading.valid()) reading.get();
+        std::swap(v_current, v_next);
+        utils::progress_bar((float)lon, (float)n_lon);
     }
-    utils::progress_bar((float)v_NcFileHandlers[0]->n_lon, (float)v_NcFileHandlers[0]->n_lon);
+    utils::progress_bar((float)n_lon, (float)n_lon);
     std::cout << std::endl;
 }
 
@@ -251,17 +474,32 @@ int main(int argc, char** argv) {
 
     try {
         parse_args(argc, argv);
-        Log.info("Method: " + method_name);
-        std::vector<std::vector<float>> v_data_out(
-            (int)v_NcFileHandlers[0]->n_lat,
-            std::vector<float>((int)v_NcFileHandlers[0]->n_lon)
-        );
+        std::string methods = v_method_names[0];
+        for (unsigned i = 1; i < v_method_names.size(); i++) methods += ", " + v_method_names[i];
+        Log.info("Methods: " + methods);
+        Log.info("Threads: " + std::to_string(n_jobs));
+        if (!grouping.empty()) Log.info("Groups: " + std::to_string(n_groups) + " (" + group_name + ")");
+
+        const size_t
+            n_lat = v_NcFileHandlers[0]->n_lat,
+            n_lon = v_NcFileHandlers[0]->n_lon;
+        std::vector<std::vector<float>> v_data_out(v_method_names.size(), std::vector<float>(n_groups * n_lat * n_lon));
 
         Log.info("Starting computation!");
         compute_indicator(v_data_out);
 
         Log.info("Saving: " + output_filepath);
-        v_NcFileHandlers[0]->to_netcdf(output_filepath, method_name, v_data_out);
+        // ? one variable per method
+        if (grouping.empty()) {
+            std::vector<std::vector<float*>> v_rows(v_method_names.size());
+            std::vector<float**> v_out_data;
+            for (unsigned i = 0; i < v_method_names.size(); i++) {
+                for (size_t lat = 0; lat < n_lat; lat++) v_rows[i].push_back(v_data_out[i].data() + lat * n_lon);
+                v_out_data.push_back(v_rows[i].data());
+            }
+            v_NcFileHandlers[0]->to_netcdf(output_filepath, v_method_names, v_out_data);
+        } else
+            v_NcFileHandlers[0]->to_netcdf(output_filepath, v_method_names, v_data_out, group_name, v_group_values, group_description);
 
         Log.info("SUCCESS!");
     } catch (const std::runtime_error& error) {